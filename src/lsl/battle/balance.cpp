@@ -0,0 +1,410 @@
+#include "balance.h"
+
+#include <boost/random/uniform_int_distribution.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace LSL {
+namespace Battle {
+
+namespace {
+
+//! what gets placed: a single player or a clan that has to stay together
+struct Unit
+{
+	Unit() : rank( 0 ) {}
+	double rank;
+	std::vector<size_t> players;
+	void Add( size_t player, float player_rank ) { players.push_back( player ); rank += player_rank; }
+};
+
+bool HigherRank( const Unit& a, const Unit& b )
+{
+	return a.rank > b.rank;
+}
+
+size_t Random( boost::random::mt19937& rng, size_t range )
+{
+	return boost::random::uniform_int_distribution<size_t>( 0, range - 1 )( rng );
+}
+
+//! puts clans that qualify into one unit each, the remaining players into units of their own
+std::vector<Unit> MakeUnits( const BalanceInput& input, std::vector<size_t> order )
+{
+	std::map<std::string, Unit> clans;
+	if ( input.clans )
+	{
+		for ( size_t i = 0; i < order.size(); ++i )
+		{
+			const size_t player = order[i];
+			if ( player < input.clans_of.size() && !input.clans_of[player].empty() )
+				clans[input.clans_of[player]].Add( player, input.ranks[player] );
+		}
+		// if clan is too small (only 1 clan member in battle) or too big, dont count it as clan
+		const size_t fair_share = ( input.ranks.size() + input.groups - 1 ) / input.groups;
+		std::map<std::string, Unit>::iterator it = clans.begin();
+		while ( it != clans.end() )
+		{
+			if ( it->second.players.size() < 2 || ( !input.strong_clans && it->second.players.size() > fair_share ) )
+				clans.erase( it++ );
+			else
+				++it;
+		}
+	}
+	std::vector<Unit> units;
+	for ( std::map<std::string, Unit>::const_iterator it = clans.begin(); it != clans.end(); ++it )
+		units.push_back( it->second );
+	for ( size_t i = 0; i < order.size(); ++i )
+	{
+		const size_t player = order[i];
+		if ( player < input.clans_of.size() && clans.count( input.clans_of[player] ) )
+			continue;
+		Unit single;
+		single.Add( player, input.ranks[player] );
+		units.push_back( single );
+	}
+	return units;
+}
+
+std::vector<size_t> Shuffled( size_t count, boost::random::mt19937& rng )
+{
+	std::vector<size_t> order( count );
+	for ( size_t i = 0; i < count; ++i )
+		order[i] = i;
+	for ( size_t i = 0; i < count; ++i )
+		std::swap( order[i], order[i + Random( rng, count - i )] );
+	return order;
+}
+
+BalanceResult ToResult( const BalanceInput& input, const std::vector<Unit>& units, const std::vector<size_t>& group_of_unit )
+{
+	BalanceResult result( input.ranks.size(), 0 );
+	for ( size_t u = 0; u < units.size(); ++u )
+		for ( size_t p = 0; p < units[u].players.size(); ++p )
+			result[units[u].players[p]] = group_of_unit[u];
+	return result;
+}
+
+/** lower is better: group sizes more than one player apart first, then the rank spread,
+ * the sum of squared group ranks to break ties
+ */
+struct Score
+{
+	size_t oversize;
+	double spread;
+	double squares;
+	bool operator < ( const Score& other ) const
+	{
+		if ( oversize != other.oversize )
+			return oversize < other.oversize;
+		if ( std::fabs( spread - other.spread ) > 1e-6 )
+			return spread < other.spread;
+		return squares < other.squares - 1e-6;
+	}
+	bool Perfect() const { return oversize == 0 && spread <= 1e-6; }
+};
+
+double RankSpread( const std::vector<double>& sums )
+{
+	return *std::max_element( sums.begin(), sums.end() ) - *std::min_element( sums.begin(), sums.end() );
+}
+
+Score Evaluate( const std::vector<double>& sums, const std::vector<size_t>& sizes )
+{
+	Score score;
+	const size_t size_spread = *std::max_element( sizes.begin(), sizes.end() ) - *std::min_element( sizes.begin(), sizes.end() );
+	score.oversize = size_spread > 1 ? size_spread - 1 : 0;
+	score.spread = RankSpread( sums );
+	score.squares = 0;
+	for ( size_t g = 0; g < sums.size(); ++g )
+		score.squares += sums[g] * sums[g];
+	return score;
+}
+
+//! one Karmarkar-Karp partial solution: a rank sum and the units behind it per group
+struct Partial
+{
+	std::vector<double> sums;
+	std::vector<std::vector<size_t> > members;
+	double Spread() const { return RankSpread( sums ); }
+};
+
+struct SmallerSpread
+{
+	bool operator()( const Partial& a, const Partial& b ) const { return a.Spread() < b.Spread(); }
+};
+
+struct SlotOrder
+{
+	SlotOrder( const std::vector<double>& sums ) : m_sums( sums ) {}
+	bool operator()( size_t a, size_t b ) const { return m_sums[a] < m_sums[b]; }
+	const std::vector<double>& m_sums;
+};
+
+/** balanced differencing: \param units sorted by rank are dealt out \param groups at a time,
+ * one to each group, so every partial solution and every merge of two keeps the group
+ * sizes level, at least as long as all units are single players
+ */
+std::vector<size_t> Differencing( const std::vector<Unit>& units, size_t groups )
+{
+	std::vector<Partial> heap;
+	for ( size_t first = 0; first < units.size(); first += groups )
+	{
+		Partial partial;
+		partial.sums.assign( groups, 0 );
+		partial.members.resize( groups );
+		for ( size_t g = 0; g < groups && first + g < units.size(); ++g )
+		{
+			partial.sums[g] = units[first + g].rank;
+			partial.members[g].push_back( first + g );
+		}
+		heap.push_back( partial );
+	}
+	std::make_heap( heap.begin(), heap.end(), SmallerSpread() );
+	std::vector<size_t> ascending( groups ), descending( groups );
+	while ( heap.size() > 1 )
+	{
+		std::pop_heap( heap.begin(), heap.end(), SmallerSpread() );
+		Partial a = heap.back();
+		heap.pop_back();
+		std::pop_heap( heap.begin(), heap.end(), SmallerSpread() );
+		Partial& b = heap.back();
+		//the biggest sums of one go with the smallest of the other
+		for ( size_t g = 0; g < groups; ++g )
+			ascending[g] = descending[g] = g;
+		std::sort( ascending.begin(), ascending.end(), SlotOrder( a.sums ) );
+		std::sort( descending.begin(), descending.end(), SlotOrder( b.sums ) );
+		std::reverse( descending.begin(), descending.end() );
+		Partial merged;
+		merged.sums.resize( groups );
+		merged.members.resize( groups );
+		for ( size_t g = 0; g < groups; ++g )
+		{
+			merged.sums[g] = a.sums[ascending[g]] + b.sums[descending[g]];
+			merged.members[g].swap( a.members[ascending[g]] );
+			merged.members[g].insert( merged.members[g].end(), b.members[descending[g]].begin(), b.members[descending[g]].end() );
+		}
+		b = merged;
+		std::push_heap( heap.begin(), heap.end(), SmallerSpread() );
+	}
+	std::vector<size_t> group_of_unit( units.size(), 0 );
+	if ( !heap.empty() )
+	{
+		for ( size_t g = 0; g < groups; ++g )
+			for ( size_t i = 0; i < heap[0].members[g].size(); ++i )
+				group_of_unit[heap[0].members[g][i]] = g;
+	}
+	return group_of_unit;
+}
+
+//! rank sum and player count of every group
+void Tally( const std::vector<Unit>& units, const std::vector<size_t>& group_of_unit, size_t groups,
+	std::vector<double>& sums, std::vector<size_t>& sizes )
+{
+	sums.assign( groups, 0 );
+	sizes.assign( groups, 0 );
+	for ( size_t u = 0; u < units.size(); ++u )
+	{
+		sums[group_of_unit[u]] += units[u].rank;
+		sizes[group_of_unit[u]] += units[u].players.size();
+	}
+}
+
+/** moves or swaps units out of the highest and lowest group, or the biggest and smallest
+ * one, while that improves the score, taking the best candidate each round
+ */
+void LocalSearch( const std::vector<Unit>& units, std::vector<size_t>& group_of_unit,
+	std::vector<double>& sums, std::vector<size_t>& sizes )
+{
+	const size_t groups = sums.size();
+	Score current = Evaluate( sums, sizes );
+	//every round improves the score, the limit only guards against rounding going in circles
+	for ( size_t round = 0; round < 4 * units.size() * units.size() + 16; ++round )
+	{
+		const size_t high = std::max_element( sums.begin(), sums.end() ) - sums.begin();
+		const size_t low = std::min_element( sums.begin(), sums.end() ) - sums.begin();
+		const size_t biggest = std::max_element( sizes.begin(), sizes.end() ) - sizes.begin();
+		const size_t smallest = std::min_element( sizes.begin(), sizes.end() ) - sizes.begin();
+		Score best = current;
+		size_t best_u = units.size(), best_v = units.size(), best_g = groups;
+		for ( size_t u = 0; u < units.size(); ++u )
+		{
+			const size_t from = group_of_unit[u];
+			if ( from != high && from != low && from != biggest && from != smallest )
+				continue;
+			for ( size_t to = 0; to < groups; ++to )
+			{
+				if ( to == from )
+					continue;
+				//move u
+				sums[from] -= units[u].rank;
+				sums[to] += units[u].rank;
+				sizes[from] -= units[u].players.size();
+				sizes[to] += units[u].players.size();
+				Score moved = Evaluate( sums, sizes );
+				if ( moved < best )
+				{
+					best = moved;
+					best_u = u;
+					best_v = units.size();
+					best_g = to;
+				}
+				//swap u with every v in the target group
+				for ( size_t v = 0; v < units.size(); ++v )
+				{
+					if ( group_of_unit[v] != to )
+						continue;
+					sums[from] += units[v].rank;
+					sums[to] -= units[v].rank;
+					sizes[from] += units[v].players.size();
+					sizes[to] -= units[v].players.size();
+					Score swapped = Evaluate( sums, sizes );
+					if ( swapped < best )
+					{
+						best = swapped;
+						best_u = u;
+						best_v = v;
+						best_g = to;
+					}
+					sums[from] -= units[v].rank;
+					sums[to] += units[v].rank;
+					sizes[from] -= units[v].players.size();
+					sizes[to] += units[v].players.size();
+				}
+				sums[from] += units[u].rank;
+				sums[to] -= units[u].rank;
+				sizes[from] += units[u].players.size();
+				sizes[to] -= units[u].players.size();
+			}
+		}
+		if ( best_u == units.size() )
+			return;
+		const size_t from = group_of_unit[best_u];
+		group_of_unit[best_u] = best_g;
+		if ( best_v != units.size() )
+			group_of_unit[best_v] = from;
+		current = best;
+		Tally( units, group_of_unit, groups, sums, sizes );
+	}
+}
+
+} // namespace
+
+float Balancer::Spread( const BalanceInput& input, const BalanceResult& result )
+{
+	if ( input.groups == 0 )
+		return 0;
+	std::vector<double> sums( input.groups, 0 );
+	for ( size_t i = 0; i < result.size(); ++i )
+		sums[result[i]] += input.ranks[i];
+	return float( RankSpread( sums ) );
+}
+
+GreedyBalancer::GreedyBalancer( unsigned int seed )
+	: m_rng( seed )
+{
+}
+
+BalanceResult GreedyBalancer::Balance( const BalanceInput& input )
+{
+	if ( input.groups == 0 || input.ranks.empty() )
+		return BalanceResult( input.ranks.size(), 0 );
+	std::vector<Unit> units = MakeUnits( input, Shuffled( input.ranks.size(), m_rng ) );
+	//clans go first, in name order, then the players by rank
+	std::vector<Unit>::iterator singles = units.begin();
+	while ( singles != units.end() && singles->players.size() > 1 )
+		++singles;
+	if ( input.type != Enum::balance_random )
+		std::stable_sort( singles, units.end(), HigherRank );
+
+	std::vector<double> sums( input.groups, 0 );
+	std::vector<size_t> group_of_unit( units.size() );
+	std::vector<size_t> lowest;
+	for ( size_t u = 0; u < units.size(); ++u )
+	{
+		// note that balance player ranks range from 1 to 1.1
+		// i.e. them are quasi equal, so this mostly picks the group with the fewest players
+		const double lowestrank = *std::min_element( sums.begin(), sums.end() );
+		lowest.clear();
+		for ( size_t g = 0; g < sums.size(); ++g )
+			if ( std::fabs( sums[g] - lowestrank ) <= 0.01 )
+				lowest.push_back( g );
+		const size_t group = lowest[Random( m_rng, lowest.size() )];
+		group_of_unit[u] = group;
+		sums[group] += units[u].rank;
+	}
+	return ToResult( input, units, group_of_unit );
+}
+
+PartitionBalancer::PartitionBalancer( unsigned int seed, boost::posix_time::time_duration budget, unsigned int max_restarts )
+	: m_rng( seed )
+	, m_budget( budget )
+	, m_max_restarts( max_restarts )
+{
+}
+
+BalanceResult PartitionBalancer::Balance( const BalanceInput& input )
+{
+	if ( input.groups == 0 || input.ranks.empty() )
+		return BalanceResult( input.ranks.size(), 0 );
+	const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + m_budget;
+	std::vector<Unit> units = MakeUnits( input, Shuffled( input.ranks.size(), m_rng ) );
+	const size_t groups = input.groups;
+
+	if ( input.type == Enum::balance_random )
+	{
+		//ignore ranks, just keep the groups the same size
+		std::vector<size_t> group_of_unit( units.size() );
+		std::vector<size_t> sizes( groups, 0 );
+		std::vector<size_t> smallest;
+		for ( size_t u = 0; u < units.size(); ++u )
+		{
+			const size_t fewest = *std::min_element( sizes.begin(), sizes.end() );
+			smallest.clear();
+			for ( size_t g = 0; g < groups; ++g )
+				if ( sizes[g] == fewest )
+					smallest.push_back( g );
+			group_of_unit[u] = smallest[Random( m_rng, smallest.size() )];
+			sizes[group_of_unit[u]] += units[u].players.size();
+		}
+		return ToResult( input, units, group_of_unit );
+	}
+
+	std::stable_sort( units.begin(), units.end(), HigherRank );
+	std::vector<size_t> best = Differencing( units, groups );
+	std::vector<double> sums;
+	std::vector<size_t> sizes;
+	Tally( units, best, groups, sums, sizes );
+	LocalSearch( units, best, sums, sizes );
+	Score best_score = Evaluate( sums, sizes );
+
+	for ( unsigned int restart = 0; restart < m_max_restarts && !best_score.Perfect() && groups > 1; ++restart )
+	{
+		if ( boost::posix_time::microsec_clock::universal_time() >= deadline )
+			break;
+		std::vector<size_t> candidate = best;
+		const size_t kicks = 1 + Random( m_rng, 3 );
+		for ( size_t k = 0; k < kicks; ++k )
+		{
+			const size_t u = Random( m_rng, units.size() );
+			const size_t v = Random( m_rng, units.size() );
+			if ( candidate[u] != candidate[v] )
+				std::swap( candidate[u], candidate[v] );
+			else
+				candidate[u] = ( candidate[u] + 1 + Random( m_rng, groups - 1 ) ) % groups;
+		}
+		Tally( units, candidate, groups, sums, sizes );
+		LocalSearch( units, candidate, sums, sizes );
+		const Score score = Evaluate( sums, sizes );
+		if ( score < best_score )
+		{
+			best.swap( candidate );
+			best_score = score;
+		}
+	}
+	return ToResult( input, units, best );
+}
+
+} // namespace Battle
+} // namespace LSL
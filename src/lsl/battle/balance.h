@@ -0,0 +1,116 @@
+#ifndef LIBLIBSPRINGLOBBY_HEADERGUARD_BALANCE_H
+#define LIBLIBSPRINGLOBBY_HEADERGUARD_BALANCE_H
+
+#include "enum.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+namespace LSL {
+namespace Battle {
+
+//! what Battle::Autobalance and Battle::FixTeamIDs hand to a Balancer
+struct BalanceInput
+{
+	BalanceInput() : groups( 2 ), type( Enum::balance_divide ), clans( true ), strong_clans( true ) {}
+	//! CommonUser::GetBalanceRank of every player
+	std::vector<float> ranks;
+	//! clan of every player, may be empty
+	std::vector<std::string> clans_of;
+	//! alliances or control teams to fill
+	size_t groups;
+	Enum::BalanceType type;
+	//! keep two or more members of a clan in one group
+	bool clans;
+	//! keep them together even if that overfills the group
+	bool strong_clans;
+};
+
+//! group of every player in BalanceInput order
+typedef std::vector<size_t> BalanceResult;
+
+/** \brief decides which group every player goes to
+ * Set one on a Battle with Battle::SetBalancer to change how it balances.
+ */
+class Balancer
+{
+public:
+	virtual ~Balancer() {}
+	virtual BalanceResult Balance( const BalanceInput& input ) = 0;
+
+	//! highest minus lowest rank sum of the groups, what the balancers try to keep small
+	static float Spread( const BalanceInput& input, const BalanceResult& result );
+};
+
+typedef boost::shared_ptr<Balancer> BalancerPtr;
+
+/** \brief what the battle used to do: shuffle, sort by rank, and put every player (and
+ * every clan as a whole) into the group with the lowest rank sum so far
+ */
+class GreedyBalancer : public Balancer
+{
+public:
+	explicit GreedyBalancer( unsigned int seed );
+	BalanceResult Balance( const BalanceInput& input );
+
+private:
+	boost::random::mt19937 m_rng;
+};
+
+/** \brief balanced multi way number partitioning: groups stay within one player of each
+ * other wherever the clans allow it, and the rank spread is narrowed within that.
+ * Balanced Karmarkar-Karp differencing for a start, then moving and swapping players or
+ * clans between the highest and lowest (or biggest and smallest) group while that
+ * improves, then the same again from randomly perturbed copies of the best
+ * assignment until the time budget or the restart limit runs out.
+ * With the same seed and a restart limit that is hit before the budget, results are
+ * reproducible.
+ */
+class PartitionBalancer : public Balancer
+{
+public:
+	explicit PartitionBalancer( unsigned int seed,
+		boost::posix_time::time_duration budget = boost::posix_time::milliseconds( 3 ),
+		unsigned int max_restarts = 200 );
+	BalanceResult Balance( const BalanceInput& input );
+
+private:
+	boost::random::mt19937 m_rng;
+	const boost::posix_time::time_duration m_budget;
+	const unsigned int m_max_restarts;
+};
+
+} // namespace Battle
+} // namespace LSL
+
+/**
+ * \file balance.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LIBLIBSPRINGLOBBY_HEADERGUARD_BALANCE_H
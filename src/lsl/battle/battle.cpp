@@ -35,7 +35,8 @@ Battle::Battle(IServerPtr serv, int id ) :
     m_serv(serv),
     m_autolock_on_start(false),
     m_auto_unspec(false),
-    m_id( id )
+    m_id( id ),
+    m_balancer( new PartitionBalancer( static_cast<unsigned int>( time( 0 ) ) ) )
 
 {
     m_opts.battleid =  m_id;
@@ -406,11 +407,11 @@ bool Battle::ExecuteSayCommand( const std::string& cmd )
             if ( user )
             {
                 const CommonUserPtr user=GetUser(nick);
-				if (!user->BattleStatus().ip.empty())
+				if (!user->BattleStatus().Extras().ip.empty())
                 {
-					m_banned_ips.insert(user->BattleStatus().ip);
+					m_banned_ips.insert(user->BattleStatus().Extras().ip);
 //                    UiEvents::GetUiEventSender( UiEvents::OnBattleActionEvent ).SendEvent(
-//								UiEvents::OnBattleActionData( std::string(" ") , user->BattleStatus().ip+" banned" )
+//								UiEvents::OnBattleActionData( std::string(" ") , user->BattleStatus().Extras().ip+" banned" )
 //                                );
                 }
                 m_serv->BattleKickPlayer( shared_from_this(), user );
@@ -440,10 +441,10 @@ bool Battle::IsBanned( const CommonUserPtr user )
 //                        );
             return true;
         }
-		else if (m_banned_ips.count(user->BattleStatus().ip)>0)
+		else if (m_banned_ips.count(user->BattleStatus().Extras().ip)>0)
         {
 //            UiEvents::GetUiEventSender( UiEvents::OnBattleActionEvent ).SendEvent(
-//						UiEvents::OnBattleActionData( std::string(" ") , user->BattleStatus().ip+" is banned, kicking" )
+//						UiEvents::OnBattleActionData( std::string(" ") , user->BattleStatus().Extras().ip+" is banned, kicking" )
 //                        );
             KickPlayer(user);
             return true;
@@ -680,7 +681,7 @@ void Battle::SetInGame( bool value )
 void Battle::FixColors()
 {
     if ( !IsFounderMe() )return;
-    std::vector<lslColor> &palette = GetFixColorsPalette( m_teams_sizes.size() + 1 );
+    std::vector<lslColor> &palette = GetFixColorsPalette( m_status_table.Teams().Distinct() + 1 );
     std::vector<int> palette_use( palette.size(), 0 );
 
 	lslColor my_col = GetMe()->BattleStatus().color; // Never changes color of founder (me) :-)
@@ -712,108 +713,16 @@ void Battle::FixColors()
     }
 }
 
-bool PlayerRankCompareFunction( const ConstCommonUserPtr a, const ConstCommonUserPtr b ) // should never operate on nulls. Hence, ASSERT_LOGIC is appropriate here.
+void Battle::SetBalancer( const BalancerPtr balancer )
 {
-	ASSERT_LOGIC( a, "fail in Autobalance, NULL player" );
-	ASSERT_LOGIC( b, "fail in Autobalance, NULL player" );
-    return ( a->GetBalanceRank() > b->GetBalanceRank() );
+    m_balancer = balancer;
 }
 
-bool PlayerTeamCompareFunction( const ConstCommonUserPtr a, const ConstCommonUserPtr b ) // should never operate on nulls. Hence, ASSERT_LOGIC is appropriate here.
-{
-	ASSERT_LOGIC( a, "fail in Autobalance, NULL player" );
-	ASSERT_LOGIC( b, "fail in Autobalance, NULL player" );
-    return ( a->BattleStatus().team > b->BattleStatus().team );
-}
-
-struct Alliance
-{
-    CommonUserVector players;
-    float ranksum;
-    int allynum;
-    Alliance(): ranksum(0), allynum(-1) {}
-    Alliance(int i): ranksum(0), allynum(i) {}
-    void AddPlayer( const CommonUserPtr player )
-    {
-        if ( player )
-        {
-            players.push_back( player );
-            ranksum += player->GetBalanceRank();
-        }
-    }
-    void AddAlliance( const Alliance &other )
-    {
-        for ( CommonUserVector::const_iterator i = other.players.begin(); i != other.players.end(); ++i )
-            AddPlayer( *i );
-    }
-    bool operator < ( const Alliance &other ) const
-    {
-        return ranksum < other.ranksum;
-    }
-};
-
-struct ControlTeam
-{
-    CommonUserVector players;
-    float ranksum;
-    int teamnum;
-    ControlTeam(): ranksum(0), teamnum(-1) {}
-    ControlTeam( int i ): ranksum(0), teamnum(i) {}
-    void AddPlayer( const CommonUserPtr player )
-    {
-        if ( player )
-        {
-            players.push_back( player );
-            ranksum += player->GetBalanceRank();
-        }
-    }
-    void AddTeam( ControlTeam &other )
-    {
-        for ( CommonUserVector::const_iterator i = other.players.begin(); i != other.players.end(); ++i ) AddPlayer( *i );
-    }
-    bool operator < (const ControlTeam &other) const
-    {
-        return ranksum < other.ranksum;
-    }
-};
-
-int my_random( int range )
-{
-    return rand() % range;
-}
-
-void shuffle( CommonUserVector& players) // proper shuffle.
-{
-    for ( size_t i=0; i < players.size(); ++i ) // the players below i are shuffled, the players above arent
-    {
-        int rn = i + my_random( players.size() - i ); // the top of shuffled part becomes random card from unshuffled part
-        CommonUserPtr tmp = players[i];
-        players[i] = players[rn];
-        players[rn] = tmp;
-    }
-}
-
-/*
-bool ClanRemovalFunction(const std::map<std::string, Alliance>::value_type &v){
-  return v.second.players.size()<2;
-}
-*/
-/*
-struct ClannersRemovalPredicate{
-  std::map<std::string, Alliance> &clans;
-  PlayerRemovalPredicate(std::map<std::string, Alliance> &clans_):clans(clans_)
-  {
-  }
-  bool operator()(User *u) const{
-    return clans.find(u->GetClan());
-  }
-}*/
-
 void Battle::Autobalance( Enum::BalanceType balance_type, bool support_clans, bool strong_clans, int numallyteams )
 {
 //    lslDebug("Autobalancing alliances, type=%d, clans=%d, strong_clans=%d, numallyteams=%d",balance_type, support_clans,strong_clans, numallyteams);
 
-    std::vector<Alliance> alliances;
+    std::vector<int> allynums;
     if ( numallyteams == 0 || numallyteams == -1 ) // 0 or 1 -> use num start rects
     {
         int ally = 0;
@@ -823,138 +732,53 @@ void Battle::Autobalance( Enum::BalanceType balance_type, bool support_clans, bo
             if ( sr.IsOk() )
             {
                 ally=i;
-                alliances.push_back( Alliance( ally ) );
+                allynums.push_back( ally );
                 ally++;
             }
         }
         // make at least two alliances
-        while ( alliances.size() < 2 )
+        while ( allynums.size() < 2 )
         {
-            alliances.push_back( Alliance( ally ) );
+            allynums.push_back( ally );
             ally++;
         }
     }
     else
     {
-        for ( int i = 0; i < numallyteams; i++ ) alliances.push_back( Alliance( i ) );
+        for ( int i = 0; i < numallyteams; i++ ) allynums.push_back( i );
     }
 
-    //for(i=0;i<alliances.size();++i)alliances[i].allynum=i;
-
-    CommonUserVector players_sorted;
-    players_sorted.reserve( m_userlist.size() );
-
+    // one player per team, the others in it follow along
+    std::map< int, CommonUserPtr> dedupe_teams;
     for ( size_t i = 0; i < m_userlist.size(); ++i )
     {
         CommonUserPtr usr = m_userlist[i];
         if ( !usr->BattleStatus().spectator )
-        {
-            players_sorted.push_back( usr );
-        }
+            dedupe_teams[usr->BattleStatus().team] = usr;
     }
-
-    // remove players in the same team so only one remains
-    std::map< int, CommonUserPtr> dedupe_teams;
-    for ( std::vector<CommonUserPtr>::const_iterator it = players_sorted.begin(); it != players_sorted.end(); ++it )
-    {
-        dedupe_teams[(*it)->BattleStatus().team] = *it;
-    }
-    players_sorted.clear();
-    players_sorted.reserve( dedupe_teams.size() );
+    CommonUserVector players;
+    BalanceInput input;
+    input.groups = allynums.size();
+    input.type = balance_type;
+    input.clans = support_clans;
+    input.strong_clans = strong_clans;
     for ( std::map<int, CommonUserPtr>::const_iterator it = dedupe_teams.begin(); it != dedupe_teams.end(); ++it )
     {
-        players_sorted.push_back( it->second );
-    }
-
-    shuffle( players_sorted );
-
-    std::map<std::string, Alliance> clan_alliances;
-    if ( support_clans )
-    {
-        for ( size_t i=0; i < players_sorted.size(); ++i )
-        {
-            std::string clan = players_sorted[i]->GetClan();
-            if ( !clan.empty() )
-            {
-                clan_alliances[clan].AddPlayer( players_sorted[i] );
-            }
-        }
-    };
-
-    if ( balance_type != Enum::balance_random )
-        std::sort( players_sorted.begin(), players_sorted.end(), PlayerRankCompareFunction );
-
-    if ( support_clans )
-    {
-        std::map<std::string, Alliance>::iterator clan_it = clan_alliances.begin();
-        while ( clan_it != clan_alliances.end() )
-        {
-            Alliance &clan = (*clan_it).second;
-            // if clan is too small (only 1 clan member in battle) or too big, dont count it as clan
-            if ( ( clan.players.size() < 2 ) ||
-                 ( !strong_clans && ( clan.players.size() >
-                                      ( ( players_sorted.size() + alliances.size() -1 ) / alliances.size() ) ) ) )
-            {
-                std::map<std::string, Alliance>::iterator next = clan_it;
-                ++next;
-                clan_alliances.erase( clan_it );
-                clan_it = next;
-                continue;
-            }
-            std::sort( alliances.begin(), alliances.end() );
-            float lowestrank = alliances[0].ranksum;
-            int rnd_k = 1;// number of alliances with rank equal to lowestrank
-            while ( size_t( rnd_k ) < alliances.size() )
-            {
-                if ( fabs( alliances[rnd_k].ranksum - lowestrank ) > 0.01 ) break;
-                rnd_k++;
-            }
-            alliances[my_random( rnd_k )].AddAlliance( clan );
-            ++clan_it;
-        }
-    }
-
-    for ( size_t i = 0; i < players_sorted.size(); ++i )
-    {
-        // skip clanners, those have been added already.
-        if ( clan_alliances.count( players_sorted[i]->GetClan() ) > 0 )
-        {
-            continue;
-        }
-
-        // find alliances with lowest ranksum
-        // insert current user into random one out of them
-        // since performance doesnt matter here, i simply sort alliances,
-        // then find how many alliances in beginning have lowest ranksum
-        // note that balance player ranks range from 1 to 1.1 now
-        // i.e. them are quasi equal
-        // so we're essentially adding to alliance with smallest number of players,
-        // the one with smallest ranksum.
-
-        std::sort( alliances.begin(), alliances.end() );
-        float lowestrank = alliances[0].ranksum;
-        int rnd_k = 1;// number of alliances with rank equal to lowestrank
-        while ( size_t( rnd_k ) < alliances.size() )
-        {
-            if ( fabs( alliances[rnd_k].ranksum - lowestrank ) > 0.01 ) break;
-            rnd_k++;
-        }
-        alliances[my_random( rnd_k )].AddPlayer( players_sorted[i] );
+        players.push_back( it->second );
+        input.ranks.push_back( it->second->GetBalanceRank() );
+        input.clans_of.push_back( it->second->GetClan() );
     }
+    const BalanceResult groups = m_balancer->Balance( input );
 
     const size_t totalplayers = m_userlist.size();
-    for ( size_t i = 0; i < alliances.size(); ++i )
+    for ( size_t i = 0; i < players.size(); ++i )
     {
-        for ( size_t j = 0; j < alliances[i].players.size(); ++j )
+        int balanceteam = players[i]->BattleStatus().team;
+        for ( size_t h = 0; h < totalplayers; h++ ) // change ally num of all players in the team
         {
-			ASSERT_LOGIC( alliances[i].players[j], "fail in Autobalance, NULL player" );
-            int balanceteam = alliances[i].players[j]->BattleStatus().team;
-            for ( size_t h = 0; h < totalplayers; h++ ) // change ally num of all players in the team
-            {
-                CommonUserPtr usr = m_userlist[h];
-                if ( usr->BattleStatus().team == balanceteam )
-                    ForceAlly( usr, alliances[i].allynum );
-            }
+            CommonUserPtr usr = m_userlist[h];
+            if ( usr->BattleStatus().team == balanceteam )
+                ForceAlly( usr, allynums[groups[i]] );
         }
     }
 }
@@ -962,8 +786,6 @@ void Battle::Autobalance( Enum::BalanceType balance_type, bool support_clans, bo
 void Battle::FixTeamIDs( Enum::BalanceType balance_type, bool support_clans, bool strong_clans, int numcontrolteams )
 {
 //	wxLogMessage("Autobalancing teams, type=%d, clans=%d, strong_clans=%d, numcontrolteams=%d",balance_type, support_clans, strong_clans, numcontrolteams);
-    std::vector<ControlTeam> control_teams;
-
     if ( numcontrolteams == 0 || numcontrolteams == -1 ) numcontrolteams = m_userlist.size() - GetSpectators(); // 0 or -1 -> use num players, will use comshare only if no available team slots
     Enum::StartType position_type = (Enum::StartType)
             Util::FromString<long>( CustomBattleOptions()->getSingleValue( "startpostype", LSL::OptionsWrapper::EngineOption ) );
@@ -1008,115 +830,32 @@ void Battle::FixTeamIDs( Enum::BalanceType balance_type, bool support_clans, boo
         }
         return;
     }
-    for ( int i = 0; i < numcontrolteams; i++ )
-        control_teams.push_back( ControlTeam( i ) );
-
-    std::vector<CommonUserPtr> players_sorted;
-    players_sorted.reserve( m_userlist.size() );
-
-    int player_team_counter = 0;
+    if ( numcontrolteams <= 0 )
+        return;
 
+    CommonUserVector players;
+    BalanceInput input;
+    input.groups = numcontrolteams;
+    input.type = balance_type;
+    input.clans = support_clans;
+    input.strong_clans = strong_clans;
     for ( size_t i = 0; i < m_userlist.size(); ++i ) // don't count spectators
     {
-        if ( !m_userlist.At(i)->BattleStatus().spectator )
-        {
-            players_sorted.push_back( m_userlist.At(i) );
-            // -- server fail? it doesnt work right.
-			//ForceTeam(m_userlist.At(i),player_team_counter);
-            player_team_counter++;
-        }
-    }
-
-    shuffle( players_sorted );
-
-    std::map<std::string, ControlTeam> clan_teams;
-    if ( support_clans )
-    {
-        for ( size_t i = 0; i < players_sorted.size(); ++i )
-        {
-            std::string clan = players_sorted[i]->GetClan();
-            if ( !clan.empty() )
-            {
-                clan_teams[clan].AddPlayer( players_sorted[i] );
-            }
-        }
-    };
-
-    if ( balance_type != Enum::balance_random )
-        std::sort( players_sorted.begin(), players_sorted.end(), PlayerRankCompareFunction );
-
-    if ( support_clans )
-    {
-        std::map<std::string, ControlTeam>::iterator clan_it = clan_teams.begin();
-        while ( clan_it != clan_teams.end() )
-        {
-            ControlTeam &clan = (*clan_it).second;
-            // if clan is too small (only 1 clan member in battle) or too big, dont count it as clan
-            if ( ( clan.players.size() < 2 ) || ( !strong_clans && ( clan.players.size() >  ( ( players_sorted.size() + control_teams.size() -1 ) / control_teams.size() ) ) ) )
-            {
-//				wxLogMessage("removing clan %s",(*clan_it).first.c_str());
-                std::map<std::string, ControlTeam>::iterator next = clan_it;
-                ++next;
-                clan_teams.erase( clan_it );
-                clan_it = next;
-                continue;
-            }
-//			wxLogMessage( "Inserting clan %s", (*clan_it).first.c_str() );
-            std::sort( control_teams.begin(), control_teams.end() );
-            float lowestrank = control_teams[0].ranksum;
-            int rnd_k = 1; // number of alliances with rank equal to lowestrank
-            while ( size_t( rnd_k ) < control_teams.size() )
-            {
-                if ( fabs( control_teams[rnd_k].ranksum - lowestrank ) > 0.01 ) break;
-                rnd_k++;
-            }
-//			wxLogMessage("number of lowestrank teams with same rank=%d", rnd_k );
-            control_teams[my_random( rnd_k )].AddTeam( clan );
-            ++clan_it;
-        }
-    }
-
-    for (size_t i = 0; i < players_sorted.size(); ++i )
-    {
-        // skip clanners, those have been added already.
-        if ( clan_teams.count( players_sorted[i]->GetClan() ) > 0 )
-        {
-//			wxLogMessage( "clanner already added, nick=%s",players_sorted[i]->Nick().c_str() );
-            continue;
-        }
-
-        // find teams with lowest ranksum
-        // insert current user into random one out of them
-        // since performance doesnt matter here, i simply sort teams,
-        // then find how many teams in beginning have lowest ranksum
-        // note that balance player ranks range from 1 to 1.1 now
-        // i.e. them are quasi equal
-        // so we're essentially adding to teams with smallest number of players,
-        // the one with smallest ranksum.
-
-        std::sort( control_teams.begin(), control_teams.end() );
-        float lowestrank = control_teams[0].ranksum;
-        int rnd_k = 1; // number of alliances with rank equal to lowestrank
-        while ( size_t( rnd_k ) < control_teams.size() )
+        const CommonUserPtr user = m_userlist.At(i);
+        if ( !user->BattleStatus().spectator )
         {
-            if ( fabs ( control_teams[rnd_k].ranksum - lowestrank ) > 0.01 ) break;
-            rnd_k++;
+            players.push_back( user );
+            input.ranks.push_back( user->GetBalanceRank() );
+            input.clans_of.push_back( user->GetClan() );
         }
-//		wxLogMessage( "number of lowestrank teams with same rank=%d", rnd_k );
-        control_teams[my_random( rnd_k )].AddPlayer( players_sorted[i] );
     }
+    const BalanceResult teams = m_balancer->Balance( input );
 
-
-    for ( size_t i=0; i < control_teams.size(); ++i )
+    for ( size_t i = 0; i < players.size(); ++i )
     {
-        for ( size_t j = 0; j < control_teams[i].players.size(); ++j )
-        {
-			ASSERT_LOGIC( control_teams[i].players[j], "fail in Autobalance teams, NULL player" );
-            std::string msg = (boost::format( "setting player %s to team and ally %d" ) % control_teams[i].players[j]->Nick() % i).str();
-//			wxLogMessage( "%s", msg.c_str() );
-            ForceTeam( control_teams[i].players[j], control_teams[i].teamnum );
-            ForceAlly( control_teams[i].players[j], control_teams[i].teamnum );
-        }
+//        wxLogMessage( "setting player %s to team and ally %d", players[i]->Nick().c_str(), teams[i] );
+        ForceTeam( players[i], teams[i] );
+        ForceAlly( players[i], teams[i] );
     }
 }
 
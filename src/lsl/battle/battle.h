@@ -6,6 +6,7 @@
 #include <lslutils/type_forwards.h>
 #include "ibattle.h"
 #include "enum.h"
+#include "balance.h"
 
 namespace LSL {
 
@@ -79,6 +80,8 @@ public:
     void FixColors();
     void Autobalance( Enum::BalanceType balance_type = Enum::balance_divide, bool clans = true, bool strong_clans = true, int allyteamsize = 0 );
     void FixTeamIDs( Enum::BalanceType balance_type = Enum::balance_divide, bool clans = true, bool strong_clans = true, int controlteamsize = 0 );
+    //! what Autobalance and FixTeamIDs use, a time seeded PartitionBalancer by default
+    void SetBalancer( const BalancerPtr balancer );
 
     void SendScriptToClients();
 
@@ -123,6 +126,7 @@ private:
     bool m_auto_unspec;
     const int m_id;
     ChannelPtr m_channel;
+    BalancerPtr m_balancer;
 };
 
 } // namespace Battle {
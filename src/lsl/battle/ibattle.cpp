@@ -5,6 +5,7 @@
 #include <lslutils/conversion.h>
 #include <lslutils/config.h>
 #include <lslutils/autopointers.h>
+#include <lslutils/pool.h>
 #include <lslunitsync/unitsync.h>
 #include <lslunitsync/optionswrapper.h>
 
@@ -17,6 +18,7 @@
 
 #include "signals.h"
 #include "tdfcontainer.h"
+#include "tdfschema.h"
 
 #include <algorithm>
 #include <boost/foreach.hpp>
@@ -58,9 +60,6 @@ IBattle::IBattle():
     , m_opt_wrap( new OptionsWrapper() )
 	, m_ingame(false)
 	, m_auto_unspec(false)
-	, m_players_ready(0)
-	, m_players_sync(0)
-	, m_players_ok(0)
 	, m_is_self_in(false)
 	, m_generating_script(false)
     , m_timer ( new boost::asio::deadline_timer( _io, TIMER_INTERVAL ) )
@@ -93,7 +92,7 @@ std::vector<lslColor>& IBattle::GetFixColorsPalette( int numteams ) const
 
 lslColor IBattle::GetFixColor(int i) const
 {
-	int size = m_teams_sizes.size();
+	int size = m_status_table.Teams().Distinct();
     std::vector<lslColor> palette = GetFixColorsPalette( size );
 	return palette[i];
 }
@@ -152,7 +151,7 @@ lslColor IBattle::GetFreeColor( const ConstCommonUserPtr user) const
 
 	int inc = 1;
 	while ( true ) {
-        ColorVec fixcolorspalette = GetFixColorsPalette( m_teams_sizes.size() + inc++ );
+        ColorVec fixcolorspalette = GetFixColorsPalette( m_status_table.Teams().Distinct() + inc++ );
         ColorVec::iterator fixcolorspalette_new_end = std::unique( fixcolorspalette.begin(), fixcolorspalette.end(), AreColorsSimilarProxy( 20 ) );
 		fixcolorspalette_new_end = std::remove_if( fixcolorspalette.begin(), fixcolorspalette.end(), DismissColor( current_used_colors ) );
 		if ( fixcolorspalette_new_end != fixcolorspalette.begin() )
@@ -173,29 +172,13 @@ int IBattle::ColorDifference(const lslColor &a, const lslColor &b)  const// retu
 
 int IBattle::GetFreeTeam( bool excludeme ) const
 {
-	int lowest = 0;
-	bool changed = true;
-	while ( changed )
-	{
-		changed = false;
-		for ( size_t i = 0; i < m_userlist.size(); i++ )
-		{
-            const ConstCommonUserPtr user = m_userlist.At( i );
-			if ( ( user == GetMe() ) && excludeme ) continue;
-			if ( user->BattleStatus().spectator ) continue;
-			if ( user->BattleStatus().team == lowest )
-			{
-				lowest++;
-				changed = true;
-			}
-		}
-	}
-	return lowest;
+	const ConstCommonUserPtr me = GetMe();
+	return m_status_table.LowestFreeTeam( ( excludeme && me ) ? me->Id() : std::string() );
 }
 
 int IBattle::GetClosestFixColor(const lslColor &col, const std::vector<int> &excludes, int difference) const
 {
-    std::vector<lslColor> palette = GetFixColorsPalette( m_teams_sizes.size() + 1 );
+    std::vector<lslColor> palette = GetFixColorsPalette( m_status_table.Teams().Distinct() + 1 );
 	int result=0;
 	for (size_t i=0;i<palette.size();++i)
 	{
@@ -242,24 +225,17 @@ void IBattle::OnUserAdded(const CommonUserPtr user )
 		pos = GetFreePosition();
 		UserPositionChanged( user );
 	}
-	if ( !bs.spectator )
-	{
-		PlayerJoinedAlly( bs.ally );
-		PlayerJoinedTeam( bs.team );
-	}
 	if ( bs.spectator && IsFounderMe() ) m_opts.spectators++;
 	if ( !bs.spectator && !bs.IsBot() )
 	{
-		if ( bs.ready ) m_players_ready++;
-		if ( bs.sync) m_players_sync++;
 		if ( !bs.ready || !bs.sync ) m_ready_up_map[user->Nick()] = time(0);
-		if ( bs.ready && bs.sync ) m_players_ok++;
 	}
+	m_status_table.Set( user->Id(), bs );
 }
 
 CommonUserPtr IBattle::OnBotAdded( const std::string& nick, const UserBattleStatus& bs )
 {
-    CommonUserPtr bot( new CommonUser( User::GetNewUserId(), nick ) );
+    CommonUserPtr bot = Util::MakePooled<CommonUser>( User::GetNewUserId(), nick );
     m_internal_bot_list.Add( bot );
 	bot->UpdateBattleStatus( bs );
     return bot;
@@ -285,30 +261,9 @@ void IBattle::OnUserBattleStatusUpdated( CommonUserPtr user, UserBattleStatus st
 	UserBattleStatus previousstatus = user->BattleStatus();
 
 	user->UpdateBattleStatus( status );
+	m_status_table.Set( user->Id(), user->BattleStatus() );
 	unsigned int oldspeccount = m_opts.spectators;
-	m_opts.spectators = 0;
-	m_players_sync = 0;
-	m_players_ready = 0;
-	m_players_ok = 0;
-	m_teams_sizes.clear();
-	m_ally_sizes.clear();
-	for ( unsigned int i = 0; i < m_userlist.size(); i++ )
-	{
-        const ConstCommonUserPtr loopuser = m_userlist.At( i );
-		const UserBattleStatus& loopstatus = loopuser->BattleStatus();
-		if ( loopstatus.spectator ) m_opts.spectators++;
-		if ( !loopstatus.IsBot() )
-		{
-			if ( !loopstatus.spectator )
-			{
-				if ( loopstatus.ready && loopstatus.spectator ) m_players_ready++;
-				if ( loopstatus.sync ) m_players_sync++;
-				if ( loopstatus.ready && loopstatus.sync ) m_players_ok++;
-				PlayerJoinedTeam( loopstatus.team );
-				PlayerJoinedAlly( loopstatus.ally );
-			}
-		}
-	}
+	m_opts.spectators = m_status_table.CountSpectators();
 	if ( oldspeccount != m_opts.spectators  )
 	{
 		if ( IsFounderMe() ) SendHostInfo( Enum::HI_Spectators );
@@ -345,17 +300,7 @@ bool IBattle::ShouldAutoStart() const
 void IBattle::OnUserRemoved( CommonUserPtr user )
 {
 	UserBattleStatus& bs = user->BattleStatus();
-	if ( !bs.spectator )
-	{
-		PlayerLeftTeam( bs.team );
-		PlayerLeftAlly( bs.ally );
-	}
-	if ( !bs.spectator && !bs.IsBot() )
-	{
-		if ( bs.ready ) m_players_ready--;
-		if ( bs.sync ) m_players_sync--;
-		if ( bs.ready && bs.sync ) m_players_ok--;
-	}
+	m_status_table.Remove( user->Id() );
 	if ( IsFounderMe() && bs.spectator )
 	{
 		m_opts.spectators--;
@@ -365,7 +310,7 @@ void IBattle::OnUserRemoved( CommonUserPtr user )
 	{
 		OnSelfLeftBattle();
 	}
-	m_userlist.Remove( user->Nick() );
+	m_userlist.Remove( user->key() );
 	if ( !bs.IsBot() )
         user->SetBattle( IBattlePtr() );
 	else
@@ -377,17 +322,8 @@ void IBattle::OnUserRemoved( CommonUserPtr user )
 
 bool IBattle::IsEveryoneReady() const
 {
-	for ( unsigned int i = 0; i < GetNumPlayers(); i++ )
-	{
-        const ConstCommonUserPtr usr = m_userlist.At( i );
-		const UserBattleStatus& status = usr->BattleStatus();
-		if ( status.IsBot() ) continue;
-		if ( status.spectator ) continue;
-		if ( usr == GetMe() ) continue;
-		if ( !status.ready ) return false;
-		if ( !status.sync ) return false;
-	}
-	return true;
+	const ConstCommonUserPtr me = GetMe();
+	return m_status_table.AllOk( me ? me->Id() : std::string() );
 }
 
 void IBattle::AddStartRect( unsigned int allyno, unsigned int left, unsigned int top, unsigned int right, unsigned int bottom )
@@ -518,12 +454,8 @@ void IBattle::ForceTeam(const CommonUserPtr user, int team )
 {
 	if ( IsFounderMe() || user->BattleStatus().IsBot() )
 	{
-		if ( !user->BattleStatus().spectator )
-		{
-			PlayerLeftTeam( user->BattleStatus().team );
-			PlayerJoinedTeam( team );
-		}
 		user->BattleStatus().team = team;
+		m_status_table.Set( user->Id(), user->BattleStatus() );
 	}
 }
 
@@ -533,12 +465,8 @@ void IBattle::ForceAlly(const CommonUserPtr user, int ally )
 
 	if ( IsFounderMe() || user->BattleStatus().IsBot() )
 	{
-		if ( !user->BattleStatus().spectator )
-		{
-			PlayerLeftAlly( user->BattleStatus().ally );
-			PlayerJoinedAlly( ally );
-		}
 		user->BattleStatus().ally = ally;
+		m_status_table.Set( user->Id(), user->BattleStatus() );
 	}
 
 }
@@ -553,66 +481,12 @@ void IBattle::ForceColor(const CommonUserPtr user, const lslColor& col )
 
 }
 
-void IBattle::PlayerJoinedTeam( int team )
-{
-	std::map<int, int>::const_iterator itor = m_teams_sizes.find( team );
-	if ( itor == m_teams_sizes.end() ) m_teams_sizes[team] = 1;
-	else m_teams_sizes[team] = m_teams_sizes[team] + 1;
-}
-
-void IBattle::PlayerJoinedAlly( int ally )
-{
-	std::map<int, int>::const_iterator iter = m_ally_sizes.find( ally );
-	if ( iter == m_ally_sizes.end() ) m_ally_sizes[ally] = 1;
-	else m_ally_sizes[ally] = m_ally_sizes[ally] + 1;
-}
-
-void IBattle::PlayerLeftTeam( int team )
-{
-	std::map<int, int>::iterator itor = m_teams_sizes.find( team );
-	if ( itor != m_teams_sizes.end() )
-	{
-		itor->second = itor->second -1;
-		if ( itor->second == 0 )
-		{
-			m_teams_sizes.erase( itor );
-		}
-	}
-}
-
-void IBattle::PlayerLeftAlly( int ally )
-{
-	std::map<int, int>::iterator iter = m_ally_sizes.find( ally );
-	if ( iter != m_ally_sizes.end() )
-	{
-		iter->second = iter->second - 1;
-		if ( iter->second == 0 )
-		{
-			m_ally_sizes.erase( iter );
-		}
-	}
-}
-
 void IBattle::ForceSpectator(const CommonUserPtr user, bool spectator )
 {
 	if ( IsFounderMe() || user->BattleStatus().IsBot() )
 	{
 		UserBattleStatus& status = user->BattleStatus();
 
-		if ( !status.spectator ) // leaving spectator status
-		{
-			PlayerJoinedTeam( status.team );
-			PlayerJoinedAlly( status.ally );
-			if ( status.ready && !status.IsBot() ) m_players_ready++;
-		}
-
-		if (spectator) // entering spectator status
-		{
-			PlayerLeftTeam( status.team );
-			PlayerLeftAlly( status.ally );
-			if ( status.ready && !status.IsBot() ) m_players_ready--;
-		}
-
 		if ( IsFounderMe() )
 		{
 			if ( status.spectator != spectator )
@@ -629,6 +503,7 @@ void IBattle::ForceSpectator(const CommonUserPtr user, bool spectator )
 			}
 		}
 		user->BattleStatus().spectator = spectator;
+		m_status_table.Set( user->Id(), user->BattleStatus() );
 	}
 }
 
@@ -651,24 +526,8 @@ void IBattle::KickPlayer(const CommonUserPtr user )
 
 int IBattle::GetFreeAlly( bool excludeme ) const
 {
-	int lowest = 0;
-	bool changed = true;
-	while ( changed )
-	{
-		changed = false;
-		for ( unsigned int i = 0; i < m_userlist.size(); i++ )
-		{
-            const ConstCommonUserPtr user = m_userlist.At( i );
-			if ( ( user == GetMe() ) && excludeme ) continue;
-			if ( user->BattleStatus().spectator ) continue;
-			if ( user->BattleStatus().ally == lowest )
-			{
-				lowest++;
-				changed = true;
-			}
-		}
-	}
-	return lowest;
+	const ConstCommonUserPtr me = GetMe();
+	return m_status_table.LowestFreeAlly( ( excludeme && me ) ? me->Id() : std::string() );
 }
 
 UserPosition IBattle::GetFreePosition()
@@ -864,11 +723,7 @@ void IBattle::OnSelfLeftBattle()
 		}
 	}
 	ClearStartRects();
-	m_teams_sizes.clear();
-	m_ally_sizes.clear();
-	m_players_ready = 0;
-	m_players_sync = 0;
-	m_players_ok = 0;
+	m_status_table.Clear();
 	usync().UnSetCurrentMod(); //left battle
 }
 
@@ -1036,6 +891,7 @@ void IBattle::AddUserFromDemo( CommonUserPtr user )
 	user->BattleStatus().isfromdemo = true;
     m_internal_user_list.Add( user );
     m_userlist.Add( user );
+    m_status_table.Set( user->Id(), user->BattleStatus() );
 }
 
 void IBattle::SetProxy( const std::string& value )
@@ -1103,25 +959,67 @@ void IBattle::LoadScriptMMOpts( const TDF::PDataList& node )
 }
 
 //! (koshi) don't delete commented things please, they might be need in the future and i'm lazy
+namespace {
+//! everything GetBattleFromScript looks up, case folded and hashed once
+struct ScriptKeys
+{
+	ScriptKeys()
+		: game( "GAME" ),
+		gametype( "GameType" ),
+		modhash( "ModHash" ),
+		mapname( "MapName" ),
+		maphash( "MapHash" ),
+		numplayers( "NumPlayers" ),
+		numusers( "NumUsers" ),
+		name( "Name" ),
+		countrycode( "CountryCode" ),
+		spectator( "Spectator" ),
+		team( "Team" ),
+		rank( "Rank" ),
+		shortname( "ShortName" ),
+		version( "Version" ),
+		host( "Host" )
+	{
+		teams.Int( "TeamLeader", &IBattle::TeamInfoContainer::TeamLeader, 0 )
+			.Int( "StartPosX", &IBattle::TeamInfoContainer::StartPosX, -1 )
+			.Int( "StartPosY", &IBattle::TeamInfoContainer::StartPosY, -1 )
+			.Int( "AllyTeam", &IBattle::TeamInfoContainer::AllyTeam, 0 )
+			.Colour( "RGBColor", &IBattle::TeamInfoContainer::RGBColor )
+			.String( "Side", &IBattle::TeamInfoContainer::SideName, "" )
+			.Int( "Handicap", &IBattle::TeamInfoContainer::Handicap, 0 );
+		allies.Int( "NumAllies", &IBattle::AllyInfoContainer::NumAllies, 0 )
+			.Int( "StartRectLeft", &IBattle::AllyInfoContainer::StartRectLeft, 0 )
+			.Int( "StartRectTop", &IBattle::AllyInfoContainer::StartRectTop, 0 )
+			.Int( "StartRectRight", &IBattle::AllyInfoContainer::StartRectRight, 0 )
+			.Int( "StartRectBottom", &IBattle::AllyInfoContainer::StartRectBottom, 0 );
+	}
+	const TDF::Key game, gametype, modhash, mapname, maphash, numplayers, numusers;
+	const TDF::Key name, countrycode, spectator, team, rank, shortname, version, host;
+	TDF::Schema<IBattle::TeamInfoContainer> teams;
+	TDF::Schema<IBattle::AllyInfoContainer> allies;
+};
+} // namespace
+
 void IBattle::GetBattleFromScript( bool loadmapmod )
 {
+	static const ScriptKeys keys;
 	BattleOptions opts;
-	std::stringstream ss ( GetScript() );
-    TDF::PDataList script( TDF::ParseTDF(ss) );
+	const std::string script_txt = GetScript();
+    TDF::PDataList script( TDF::ParseTDF( script_txt.data(), script_txt.size() ) );
 
-    TDF::PDataList replayNode ( script->Find("GAME" ) );
+    TDF::PDataList replayNode ( script->Find( keys.game ) );
 	if ( replayNode.ok() )
 	{
-		std::string modname = replayNode->GetString( "GameType" );
-		std::string modhash = replayNode->GetString( "ModHash" );
+		std::string modname = replayNode->GetString( keys.gametype );
+		std::string modhash = replayNode->GetString( keys.modhash );
 		if ( !modhash.empty() )
 			modhash = Util::MakeHashUnsigned( modhash );
 		SetHostMod( modname, modhash );
 
 		//don't have the maphash, what to do?
 		//ui download function works with mapname if hash is empty, so works for now
-		std::string mapname    = replayNode->GetString( "MapName" );
-		std::string maphash    = replayNode->GetString( "MapHash" );
+		std::string mapname    = replayNode->GetString( keys.mapname );
+		std::string maphash    = replayNode->GetString( keys.maphash );
 		if ( !maphash.empty() )
 			maphash = Util::MakeHashUnsigned( maphash );
 		SetHostMap( mapname, maphash );
@@ -1130,8 +1028,8 @@ void IBattle::GetBattleFromScript( bool loadmapmod )
 		//        opts.port       = replayNode->GetInt  ( "HostPort", DEFAULT_EXTERNAL_UDP_SOURCE_PORT );
 		opts.spectators = 0;
 
-		int playernum = replayNode->GetInt  ( "NumPlayers", 0);
-		int usersnum = replayNode->GetInt  ( "NumUsers", 0);
+		int playernum = replayNode->GetInt  ( keys.numplayers, 0);
+		int usersnum = replayNode->GetInt  ( keys.numusers, 0);
 		if ( usersnum > 0 ) playernum = usersnum;
 		//        int allynum = replayNode->GetInt  ( "NumAllyTeams", 1);
 		//        int teamnum = replayNode->GetInt  ( "NumTeams", 1);
@@ -1148,64 +1046,46 @@ void IBattle::GetBattleFromScript( bool loadmapmod )
 		//[PLAYERX] sections
 		for ( int i = 0; i < playernum ; ++i )
 		{
-            TDF::PDataList player ( replayNode->Find( "PLAYER" + Util::ToString(i) ) );
-            TDF::PDataList bot ( replayNode->Find( "AI" + Util::ToString(i) ) );
+            TDF::PDataList player ( replayNode->Find( TDF::Key( "PLAYER", i ) ) );
+            TDF::PDataList bot ( replayNode->Find( TDF::Key( "AI", i ) ) );
 			if ( player.ok() || bot.ok() )
 			{
 				if ( bot.ok() ) player = bot;
-                const CommonUserPtr user( new CommonUser( User::GetNewUserId(), player->GetString( "Name" ),
-                                                    boost::to_upper_copy(player->GetString( "CountryCode") )) );
+                const CommonUserPtr user( new CommonUser( User::GetNewUserId(), player->GetString( keys.name ),
+                                                    boost::to_upper_copy(player->GetString( keys.countrycode )) ) );
 				UserBattleStatus& status = user->BattleStatus();
 				status.isfromdemo = true;
-				status.spectator = player->GetInt( "Spectator", 0 );
+				status.spectator = player->GetInt( keys.spectator, 0 );
 				opts.spectators += user->BattleStatus().spectator;
-				status.team = player->GetInt( "Team" );
-				if ( !status.spectator )
-				{
-					PlayerJoinedTeam( status.team );
-				}
+				status.team = player->GetInt( keys.team );
 				status.sync = true;
 				status.ready = true;
 				if ( status.spectator ) m_opts.spectators++;
-				else
-				{
-					if ( !bot.ok() )
-					{
-						if ( status.ready) m_players_ready++;
-						if ( status.sync ) m_players_sync++;
-						if ( status.sync && status.ready ) m_players_ok++;
-					}
-				}
 
 				//! (koshi) changed this from ServerRankContainer to RankContainer
-				user->Status().rank = (UserStatus::RankContainer)player->GetInt( "Rank", -1 );
+				//rank is a 3 bit field now, a missing or odd Rank must not wrap around to RANK_8
+				const int rank = player->GetInt( keys.rank, UserStatus::RANK_1 );
+				user->Status().rank = (UserStatus::RankContainer)std::max<int>( UserStatus::RANK_1, std::min<int>( UserStatus::RANK_8, rank ) );
 
 				if ( bot.ok() )
 				{
-					status.aishortname = bot->GetString( "ShortName" );
-					status.aiversion = bot->GetString( "Version" );
-					int ownerindex = bot->GetInt( "Host" );
-                    TDF::PDataList aiowner ( replayNode->Find( "PLAYER" + Util::ToString(ownerindex) ) );
+					status.MutableExtras().aishortname = bot->GetString( keys.shortname );
+					status.MutableExtras().aiversion = bot->GetString( keys.version );
+					int ownerindex = bot->GetInt( keys.host );
+                    TDF::PDataList aiowner ( replayNode->Find( TDF::Key( "PLAYER", ownerindex ) ) );
 					if ( aiowner.ok() )
 					{
-						status.owner = aiowner->GetString( "Name" );
+						status.MutableExtras().owner = aiowner->GetString( keys.name );
 					}
 				}
 
 				IBattle::TeamInfoContainer teaminfos = parsed_teams[user->BattleStatus().team];
 				if ( !teaminfos.exist )
 				{
-                    TDF::PDataList team( replayNode->Find( "TEAM" + Util::ToString( user->BattleStatus().team ) ) );
-					if ( team.ok() )
+                    const TDF::PDataList team( replayNode->Find( TDF::Key( "TEAM", user->BattleStatus().team ) ) );
+					if ( keys.teams.Extract( team, teaminfos ) )
 					{
 						teaminfos.exist = true;
-						teaminfos.TeamLeader = team->GetInt( "TeamLeader", 0 );
-						teaminfos.StartPosX = team->GetInt( "StartPosX", -1 );
-						teaminfos.StartPosY = team->GetInt( "StartPosY", -1 );
-						teaminfos.AllyTeam = team->GetInt( "AllyTeam", 0 );
-                        teaminfos.RGBColor = Util::ColorFromFloatString( team->GetString( "RGBColor" ) );
-						teaminfos.SideName = team->GetString( "Side", "" );
-						teaminfos.Handicap = team->GetInt( "Handicap", 0 );
 						int sidepos = Util::IndexInSequence( sides, teaminfos.SideName );
 						teaminfos.SideNum = sidepos;
 						parsed_teams[ user->BattleStatus().team ] = teaminfos;
@@ -1218,23 +1098,14 @@ void IBattle::GetBattleFromScript( bool loadmapmod )
 					status.pos.y = teaminfos.StartPosY;
 					status.color = teaminfos.RGBColor;
 					status.handicap = teaminfos.Handicap;
-					if ( !status.spectator )
-					{
-						PlayerJoinedAlly( status.ally );
-					}
 					if ( teaminfos.SideNum >= 0 ) status.side = teaminfos.SideNum;
 					IBattle::AllyInfoContainer allyinfos = parsed_allies[user->BattleStatus().ally];
 					if ( !allyinfos.exist )
 					{
-                        TDF::PDataList ally( replayNode->Find( "ALLYTEAM" + Util::ToString( user->BattleStatus().ally ) ) );
-						if ( ally.ok() )
+                        const TDF::PDataList ally( replayNode->Find( TDF::Key( "ALLYTEAM", user->BattleStatus().ally ) ) );
+						if ( keys.allies.Extract( ally, allyinfos ) )
 						{
 							allyinfos.exist = true;
-							allyinfos.NumAllies = ally->GetInt( "NumAllies", 0 );
-							allyinfos.StartRectLeft = ally->GetInt( "StartRectLeft", 0 );
-							allyinfos.StartRectTop = ally->GetInt( "StartRectTop", 0 );
-							allyinfos.StartRectRight = ally->GetInt( "StartRectRight", 0 );
-							allyinfos.StartRectBottom = ally->GetInt( "StartRectBottom", 0 );
 							parsed_allies[ user->BattleStatus().ally ] = allyinfos;
 							AddStartRect( user->BattleStatus().ally, allyinfos.StartRectTop, allyinfos.StartRectTop, allyinfos.StartRectRight, allyinfos.StartRectBottom );
 						}
@@ -8,6 +8,7 @@
 #include <lslunitsync/data.h>
 
 #include "enum.h"
+#include "statustable.h"
 
 #include <sstream>
 #include <boost/scoped_ptr.hpp>
@@ -86,12 +87,12 @@ struct BattleOptions
 	
 	unsigned int maxplayers;
 	unsigned int spectators;
-	std::string maphash;
-	std::string modhash;
+	InternedString maphash;
+	InternedString modhash;
 
 	std::string description;
-	std::string mapname;
-	std::string modname;
+	InternedString mapname;
+	InternedString modname;
 };
 
 /** \brief base model for all Battle types
@@ -228,12 +229,14 @@ public:
 
     ConstCommonUserVector Users() const { return m_userlist.Vectorize(); }
     CommonUserVector Users() { return m_userlist.Vectorize(); }
+    //! Users() without the copy, invalidated when someone joins or leaves
+    CommonUserList::RangeType UserRange() const { return m_userlist.Range(); }
     unsigned int GetNumUsers() { return m_userlist.size(); }
     unsigned int GetNumPlayers() const;
     unsigned int GetNumActivePlayers() const;
-    unsigned int GetNumReadyPlayers() const { return m_players_ready; }
-    unsigned int GetNumSyncedPlayers() const { return m_players_sync; }
-    unsigned int GetNumOkPlayers() const { return m_players_ok; }
+    unsigned int GetNumReadyPlayers() const { return m_status_table.CountReady(); }
+    unsigned int GetNumSyncedPlayers() const { return m_status_table.CountSynced(); }
+    unsigned int GetNumOkPlayers() const { return m_status_table.CountOk(); }
 
     int GetBattleId() const { return m_opts.battleid; }
     virtual int Id() const { return GetBattleId(); }
@@ -321,8 +324,8 @@ public:
 
 	virtual void StartSpring() = 0;
 
-	virtual std::map<int, int> GetAllySizes() { return m_ally_sizes; }
-	virtual std::map<int, int> GetTeamSizes() { return m_teams_sizes; }
+	virtual std::map<int, int> GetAllySizes() { return m_status_table.Allies().Sizes(); }
+	virtual std::map<int, int> GetTeamSizes() { return m_status_table.Teams().Sizes(); }
 
 	std::map<std::string, std::string> m_script_tags; // extra script tags to reload in the case of map/mod reload
 
@@ -334,11 +337,6 @@ public:
     CommonUserPtr GetUser( const std::string& nick );
 
 private:
-	void PlayerLeftTeam( int team );
-	void PlayerLeftAlly( int ally );
-	void PlayerJoinedTeam( int team );
-	void PlayerJoinedAlly( int ally );
-
 	bool m_map_loaded;
 	bool m_mod_loaded;
 	bool m_map_exists;
@@ -358,12 +356,6 @@ private:
 
 	std::map<unsigned int,BattleStartRect> m_rects;
 
-	unsigned int m_players_ready;
-	unsigned int m_players_sync;
-	unsigned int m_players_ok; // players which are ready and in sync
-
-	std::map<int, int> m_ally_sizes; // allyteam -> number of people in
-
 	std::string m_preset;
 
     CommonUserList m_internal_bot_list;
@@ -383,7 +375,8 @@ protected:
     bool m_generating_script;
     boost::scoped_ptr< boost::asio::deadline_timer > m_timer;
     std::map<std::string, time_t> m_ready_up_map; // player name -> time counting from join/unspect
-    std::map<int, int> m_teams_sizes; // controlteam -> number of people in
+    //! ready/sync/spectator counts and team/ally occupancy of everyone in m_userlist
+    StatusTable m_status_table;
 };
 
 } // namespace Battle
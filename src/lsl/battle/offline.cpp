@@ -55,10 +55,7 @@ OfflineBattle& OfflineBattle::operator = ( const OfflineBattle& other )
     m_generating_script = other.m_generating_script;
     m_rects = other.m_rects;
     m_ready_up_map = other.m_ready_up_map; // player name -> time counting from join/unspect
-    m_players_ready = other.m_players_ready;
-    m_players_sync = other.m_players_sync;
-    m_teams_sizes = other.m_teams_sizes; // controlteam -> number of people in
-    m_ally_sizes = other.m_ally_sizes; // allyteam -> number of people in
+    m_status_table = other.m_status_table;
     m_preset = other.m_preset;
     m_is_self_in = other.m_is_self_in;
     m_internal_bot_list = other.m_internal_bot_list;
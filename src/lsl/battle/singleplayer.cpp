@@ -73,7 +73,7 @@ void SinglePlayerBattle::RemoveUnfittingBots()
         if ( new_ais.Index(old_ais[i]) == wxNOT_FOUND  ) {
             for( size_t j = 0; j < GetNumUsers(); ++j  ) {
                 User& u = GetUser( j );
-                if ( u.GetBattleStatus().airawname == old_ais[i] )
+                if ( u.GetBattleStatus().Extras().airawname == old_ais[i] )
                     KickPlayer( u );
             }
         }
@@ -0,0 +1,198 @@
+#include "statustable.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace LSL {
+namespace Battle {
+
+namespace {
+//! index of the lowest set bit, x must not be 0
+int LowestSetBit( boost::uint64_t x )
+{
+	int bit = 0;
+	if ( !( x & 0xFFFFFFFFull ) ) { bit += 32; x >>= 32; }
+	if ( !( x & 0xFFFF ) ) { bit += 16; x >>= 16; }
+	if ( !( x & 0xFF ) ) { bit += 8; x >>= 8; }
+	if ( !( x & 0xF ) ) { bit += 4; x >>= 4; }
+	if ( !( x & 0x3 ) ) { bit += 2; x >>= 2; }
+	if ( !( x & 0x1 ) ) { bit += 1; }
+	return bit;
+}
+} // namespace
+
+void Occupancy::Join( unsigned int number )
+{
+	if ( m_count[number]++ == 0 )
+	{
+		m_used[number / WORD_BITS] |= boost::uint64_t( 1 ) << ( number % WORD_BITS );
+		++m_distinct;
+	}
+}
+
+void Occupancy::Leave( unsigned int number )
+{
+	if ( m_count[number] == 0 )
+		return;
+	if ( --m_count[number] == 0 )
+	{
+		m_used[number / WORD_BITS] &= ~( boost::uint64_t( 1 ) << ( number % WORD_BITS ) );
+		--m_distinct;
+	}
+}
+
+void Occupancy::Clear()
+{
+	std::memset( m_count, 0, sizeof( m_count ) );
+	std::memset( m_used, 0, sizeof( m_used ) );
+	m_distinct = 0;
+}
+
+int Occupancy::LowestFree() const
+{
+	for ( int word = 0; word < WORDS; ++word )
+	{
+		if ( ~m_used[word] )
+			return word * WORD_BITS + LowestSetBit( ~m_used[word] );
+	}
+	return NUMBERS;
+}
+
+std::map<int, int> Occupancy::Sizes() const
+{
+	std::map<int, int> sizes;
+	for ( int number = 0; number < NUMBERS; ++number )
+	{
+		if ( m_count[number] )
+			sizes[number] = m_count[number];
+	}
+	return sizes;
+}
+
+StatusTable::StatusTable()
+	: m_spectators( 0 )
+	, m_players( 0 )
+	, m_ready( 0 )
+	, m_synced( 0 )
+	, m_ok( 0 )
+{
+}
+
+void StatusTable::Set( const std::string& id, const UserBattleStatus& status )
+{
+	unsigned char flags = 0;
+	if ( status.ready ) flags |= FLAG_READY;
+	if ( status.sync == SYNC_SYNCED ) flags |= FLAG_SYNCED;
+	if ( status.spectator ) flags |= FLAG_SPECTATOR;
+	if ( status.IsBot() ) flags |= FLAG_BOT;
+
+	boost::unordered_map<std::string, size_t>::const_iterator it = m_rows.find( id );
+	size_t row;
+	if ( it == m_rows.end() )
+	{
+		row = m_ids.size();
+		m_rows[id] = row;
+		m_ids.push_back( id );
+		m_flags.push_back( flags );
+		m_team.push_back( status.team );
+		m_ally.push_back( status.ally );
+	}
+	else
+	{
+		row = it->second;
+		Account( row, -1 );
+		m_flags[row] = flags;
+		m_team[row] = status.team;
+		m_ally[row] = status.ally;
+	}
+	Account( row, 1 );
+}
+
+void StatusTable::Remove( const std::string& id )
+{
+	boost::unordered_map<std::string, size_t>::iterator it = m_rows.find( id );
+	if ( it == m_rows.end() )
+		return;
+	const size_t row = it->second;
+	const size_t last = m_ids.size() - 1;
+	Account( row, -1 );
+	m_rows.erase( it );
+	if ( row != last )
+	{
+		m_flags[row] = m_flags[last];
+		m_team[row] = m_team[last];
+		m_ally[row] = m_ally[last];
+		m_ids[row].swap( m_ids[last] );
+		m_rows[m_ids[row]] = row;
+	}
+	m_flags.pop_back();
+	m_team.pop_back();
+	m_ally.pop_back();
+	m_ids.pop_back();
+}
+
+void StatusTable::Clear()
+{
+	m_flags.clear();
+	m_team.clear();
+	m_ally.clear();
+	m_ids.clear();
+	m_rows.clear();
+	m_spectators = m_players = m_ready = m_synced = m_ok = 0;
+	m_teams.Clear();
+	m_allies.Clear();
+}
+
+void StatusTable::Account( size_t row, int sign )
+{
+	const unsigned char flags = m_flags[row];
+	if ( flags & FLAG_SPECTATOR )
+	{
+		m_spectators += sign;
+		return;
+	}
+	if ( sign > 0 )
+	{
+		m_teams.Join( m_team[row] );
+		m_allies.Join( m_ally[row] );
+	}
+	else
+	{
+		m_teams.Leave( m_team[row] );
+		m_allies.Leave( m_ally[row] );
+	}
+	if ( flags & FLAG_BOT )
+		return;
+	m_players += sign;
+	if ( flags & FLAG_READY ) m_ready += sign;
+	if ( flags & FLAG_SYNCED ) m_synced += sign;
+	if ( ( flags & FLAG_READY ) && ( flags & FLAG_SYNCED ) ) m_ok += sign;
+}
+
+bool StatusTable::AllOk( const std::string& except_id ) const
+{
+	size_t not_ok = m_players - m_ok;
+	boost::unordered_map<std::string, size_t>::const_iterator it = m_rows.find( except_id );
+	if ( it != m_rows.end() )
+	{
+		const unsigned char flags = m_flags[it->second];
+		const bool ok = ( flags & ( FLAG_READY | FLAG_SYNCED ) ) == ( FLAG_READY | FLAG_SYNCED );
+		if ( !( flags & PLAYER_MASK ) && !ok )
+			--not_ok;
+	}
+	return not_ok == 0;
+}
+
+int StatusTable::LowestFree( const Occupancy& occupancy, const std::vector<unsigned char>& numbers, const std::string& except_id ) const
+{
+	const int lowest = occupancy.LowestFree();
+	boost::unordered_map<std::string, size_t>::const_iterator it = m_rows.find( except_id );
+	if ( it == m_rows.end() || ( m_flags[it->second] & FLAG_SPECTATOR ) )
+		return lowest;
+	//the excepted row is alone on its number: that one counts as free as well
+	const int own = numbers[it->second];
+	return occupancy.Count( own ) == 1 ? std::min( lowest, own ) : lowest;
+}
+
+} // namespace Battle
+} // namespace LSL
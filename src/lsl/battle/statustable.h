@@ -0,0 +1,129 @@
+#ifndef LIBLIBSPRINGLOBBY_HEADERGUARD_STATUSTABLE_H
+#define LIBLIBSPRINGLOBBY_HEADERGUARD_STATUSTABLE_H
+
+#include <lsl/user/userdata.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace LSL {
+namespace Battle {
+
+/** \brief how many rows use each team (or ally) number, with a bitset of the used ones
+ * Numbers are what fits UserBattleStatus::team, 0-255.
+ */
+class Occupancy
+{
+public:
+	Occupancy() { Clear(); }
+	void Join( unsigned int number );
+	void Leave( unsigned int number );
+	void Clear();
+
+	size_t Count( unsigned int number ) const { return m_count[number]; }
+	//! numbers with at least one row
+	size_t Distinct() const { return m_distinct; }
+	//! lowest number no row uses
+	int LowestFree() const;
+	//! number -> rows, like IBattle::GetTeamSizes always returned
+	std::map<int, int> Sizes() const;
+
+private:
+	enum { NUMBERS = 256, WORD_BITS = 64, WORDS = NUMBERS / WORD_BITS };
+	unsigned short m_count[NUMBERS];
+	boost::uint64_t m_used[WORDS];
+	size_t m_distinct;
+};
+
+/** \brief the battle status fields every ready/sync check looks at, one array per field
+ * A row per battle user, rows are kept dense by moving the last one into a removed slot.
+ * Set and Remove take the old values of a row out of the counters and put the new ones
+ * in, so every query below is constant time whatever the battle size.
+ * "Players" here are humans that aren't spectating, like everywhere in IBattle. Team and
+ * ally occupancy counts every non spectator, bots included, as they need a team too.
+ */
+class StatusTable
+{
+public:
+	StatusTable();
+	//! adds or refreshes the row of \param id
+	void Set( const std::string& id, const UserBattleStatus& status );
+	void Remove( const std::string& id );
+	void Clear();
+	size_t size() const { return m_ids.size(); }
+
+	size_t CountSpectators() const { return m_spectators; }
+	size_t CountReady() const { return m_ready; }
+	size_t CountSynced() const { return m_synced; }
+	size_t CountOk() const { return m_ok; }
+	//! true if every player but \param except_id is ready and synced
+	bool AllOk( const std::string& except_id ) const;
+
+	const Occupancy& Teams() const { return m_teams; }
+	const Occupancy& Allies() const { return m_allies; }
+	//! lowest team no non spectator but \param except_id is on
+	int LowestFreeTeam( const std::string& except_id ) const { return LowestFree( m_teams, m_team, except_id ); }
+	int LowestFreeAlly( const std::string& except_id ) const { return LowestFree( m_allies, m_ally, except_id ); }
+
+private:
+	enum {
+		FLAG_READY = 1,
+		FLAG_SYNCED = 2,
+		FLAG_SPECTATOR = 4,
+		FLAG_BOT = 8,
+		PLAYER_MASK = FLAG_SPECTATOR | FLAG_BOT
+	};
+	//! adds (\param sign 1) or takes out (-1) what \param row contributes to the counters
+	void Account( size_t row, int sign );
+	int LowestFree( const Occupancy& occupancy, const std::vector<unsigned char>& numbers, const std::string& except_id ) const;
+
+	std::vector<unsigned char> m_flags;
+	std::vector<unsigned char> m_team;
+	std::vector<unsigned char> m_ally;
+	std::vector<std::string> m_ids;
+	boost::unordered_map<std::string, size_t> m_rows;
+
+	size_t m_spectators;
+	//! non spectating humans, only AllOk needs it
+	size_t m_players;
+	size_t m_ready;
+	size_t m_synced;
+	size_t m_ok;
+	Occupancy m_teams;
+	Occupancy m_allies;
+};
+
+} // namespace Battle
+} // namespace LSL
+
+/**
+ * \file statustable.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LIBLIBSPRINGLOBBY_HEADERGUARD_STATUSTABLE_H
@@ -4,12 +4,31 @@
 #include <lslutils/autopointers.h>
 #include <lslutils/debug.h>
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <clocale>
 #include <cmath>
+#include <cstdio>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <boost/algorithm/string.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fcntl.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 
 #define ASSERT_LOGIC(...)   do {} while(0)
 
@@ -17,8 +36,75 @@ namespace LSL { namespace TDF {
 
 namespace BA = boost::algorithm;
 
+namespace {
+//! indentation is cut from this, deeper levels take several pieces
+const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+const int tab_run = sizeof( tabs ) - 1;
+} // namespace
+
+FileSink::FileSink( int fd, bool owned ):
+		m_fd( fd ),
+		m_owned( owned ),
+		m_failed( false )
+{
+	m_buffer.reserve( BUFFER_SIZE );
+}
+
+FileSink::FileSink( const std::string &path ):
+		m_fd( open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644 ) ),
+		m_owned( true ),
+		m_failed( false )
+{
+	m_buffer.reserve( BUFFER_SIZE );
+}
+
+FileSink::~FileSink() {
+	Flush();
+	if ( m_owned && m_fd >= 0 )
+		close( m_fd );
+}
+
+void FileSink::Write( const char* data, size_t length ) {
+	if ( m_buffer.size() + length > BUFFER_SIZE ) {
+		Flush();
+		if ( length > BUFFER_SIZE ) {
+			WriteOut( data, length );
+			return;
+		}
+	}
+	m_buffer.insert( m_buffer.end(), data, data + length );
+}
+
+void FileSink::Flush() {
+	if ( !m_buffer.empty() )
+		WriteOut( &m_buffer[0], m_buffer.size() );
+	m_buffer.clear();
+}
+
+void FileSink::WriteOut( const char* data, size_t length ) {
+	while ( length > 0 && Good() ) {
+		const int written = write( m_fd, data, static_cast<unsigned int>( length ) );
+		if ( written < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			m_failed = true;
+			return;
+		}
+		data += written;
+		length -= written;
+	}
+}
+
 TDFWriter::TDFWriter(std::stringstream &s ):
-		m_stream( s ),
+		m_own_sink( new StreamSink( s ) ),
+		m_sink( *m_own_sink ),
+		m_depth( 0 )
+{
+
+}
+
+TDFWriter::TDFWriter( TDFSink &sink ):
+		m_sink( sink ),
 		m_depth( 0 )
 {
 
@@ -26,26 +112,97 @@ TDFWriter::TDFWriter(std::stringstream &s ):
 
 TDFWriter::~TDFWriter() {
 	Close();
+	m_sink.Flush();
 }
 void TDFWriter::EnterSection( const std::string &name ) {
+	m_line.clear();
 	Indent();
-    m_stream << "[" << name << "]\n";
+	m_line += '[';
+	m_line += name;
+	m_line += "]\n";
 	Indent();
-    m_stream << "{\n";
+	m_line += "{\n";
+	m_sink.Write( m_line.data(), m_line.size() );
 	m_depth++;
 }
 void TDFWriter::LeaveSection() {
 	m_depth--;
+	m_line.clear();
 	Indent();
-    m_stream << "}\n";
+	m_line += "}\n";
+	m_sink.Write( m_line.data(), m_line.size() );
 }
 void TDFWriter::Indent() {
-    for ( int i = 0;i < m_depth;++i )m_stream << "\t";
+	for ( int left = m_depth; left > 0; left -= tab_run )
+		m_line.append( tabs, std::min( left, tab_run ) );
 }
 //std::string GetCurrentPath();
-void TDFWriter::Append( const std::string &name, std::string value ) {
+void TDFWriter::BeginEntry( const std::string &name ) {
+	m_line.clear();
 	Indent();
-    m_stream << name << "=" << value << ";\n";
+	m_line += name;
+	m_line += '=';
+}
+void TDFWriter::EndEntry() {
+	m_line += ";\n";
+	m_sink.Write( m_line.data(), m_line.size() );
+}
+void TDFWriter::Append( const std::string &name, const std::string &value ) {
+	BeginEntry( name );
+	m_line += value;
+	EndEntry();
+}
+void TDFWriter::Append( const std::string &name, const char* value ) {
+	BeginEntry( name );
+	m_line += value;
+	EndEntry();
+}
+void TDFWriter::Append( const std::string &name, double value, int decimals ) {
+	BeginEntry( name );
+	char buf[64];
+	snprintf( buf, sizeof( buf ), "%.*f", decimals, value );
+	m_line += buf;
+	// printf honours LC_NUMERIC, the script always wants a point
+	const char point = *localeconv()->decimal_point;
+	if ( point != '.' )
+		std::replace( m_line.end() - strlen( buf ), m_line.end(), point, '.' );
+	EndEntry();
+}
+
+void TDFWriter::FormatUnsigned( unsigned long long value ) {
+	char buf[24];
+	char* end = buf + sizeof( buf );
+	char* p = end;
+	do {
+		*--p = '0' + value % 10;
+		value /= 10;
+	} while ( value );
+	m_line.append( p, end );
+}
+
+void TDFWriter::Format( long long value ) {
+	if ( value < 0 ) {
+		m_line += '-';
+		// negating the smallest value doesn't fit, the unsigned one does
+		FormatUnsigned( 0ull - static_cast<unsigned long long>( value ) );
+	} else {
+		FormatUnsigned( value );
+	}
+}
+
+void TDFWriter::Format( double value ) {
+	// whole numbers %g prints without exponent go the integer way
+	if ( value > -1e6 && value < 1e6 && value == static_cast<double>( static_cast<long long>( value ) ) && !( value == 0 && std::signbit( value ) ) ) {
+		Format( static_cast<long long>( value ) );
+		return;
+	}
+	char buf[32];
+	snprintf( buf, sizeof( buf ), "%g", value );
+	const size_t length = strlen( buf );
+	m_line.append( buf, length );
+	const char point = *localeconv()->decimal_point;
+	if ( point != '.' )
+		std::replace( m_line.end() - length, m_line.end(), point, '.' );
 }
 
 void TDFWriter::Close() {
@@ -57,191 +214,288 @@ void TDFWriter::Close() {
 }
 
 void TDFWriter::AppendLineBreak() {
-    m_stream << "\n";
-}
-
-void Tokenizer::ReportError( const Token &t, const std::string &err ) {
-    LslError( "TDF parsing error at (%s), on token \"%s\" : %s", t.pos_string.c_str(), t.value_s.c_str(), err.c_str() );
-	errors++;
-}
-
-//#define ReportError(a) {std::cerr<<"error "<<(a);}
-//#define ReportError(a) {wxLogMessage(\1;}
-
-void Tokenizer::EnterStream( std::istream &stream_, const std::string &name ) {
-	skip_eol = false;
-    include_stack.push_back( IncludeCacheEntry( &stream_, false ) );
-	include_stack.back().name = name;
+	m_sink.Write( "\n", 1 );
+}
+
+std::string Token::Value() const {
+	if ( !escaped )
+		return value.to_string();
+	std::string result;
+	result.reserve( value.size() );
+	for ( size_t i = 0; i < value.size(); ++i ) {
+		if ( value[i] == '\\' && i + 1 < value.size() )
+			result += value[++i];
+		// std::string has problem with zero characters, replace by space.
+		else if ( value[i] == 0 )
+			result += ' ';
+		else
+			result += value[i];
+	}
+	return result;
 }
 
-void Tokenizer::UnwindStack() {
-	while ( ( !include_stack.empty() ) && include_stack.back().stream && ( !include_stack.back().stream->good() ) ) {
-		include_stack.pop_back();
+std::string Tokenizer::Position( const Token &t ) const {
+	if ( t.IsEOF() )
+		return "EOF";
+	int line = 1;
+	int column = 1;
+	const char* end = std::min( buffer_begin + t.offset, buffer_end );
+	for ( const char* p = buffer_begin; p < end; ++p ) {
+		if ( *p == 10 || *p == 13 ) {
+			line += 1;
+			column = 1;
+			// \r\n and \n\r count as one line break
+			if ( p + 1 < end && ( p[1] == 10 || p[1] == 13 ) && p[1] != *p )
+				++p;
+		} else {
+			column += 1;
+		}
 	}
+	std::stringstream pos;
+	if ( !buffer_name.empty() )
+		pos << buffer_name << " , ";
+	pos << "line " << line << " , column " << column;
+	return pos.str();
 }
 
-char Tokenizer::PeekNextChar() {
-	UnwindStack();
-	//std::string tmp;
-	char tmp = 0;
-	if ( !include_stack.empty() )tmp = ( *include_stack.back().stream ).peek();
-	return tmp;
+void Tokenizer::ReportError( const Token &t, const std::string &err ) {
+    LslError( "TDF parsing error at (%s), on token \"%s\" : %s", Position( t ).c_str(), t.Value().c_str(), err.c_str() );
+	errors++;
 }
 
-char Tokenizer::GetNextChar() {
-	UnwindStack();
-	//std::string tmp;
-	if ( include_stack.empty() )return 0;
-
-	char c = ( *include_stack.back().stream ).get();
-
-	if ( ( !skip_eol ) && ( c == 10 || c == 13 ) ) {// end of line
-		include_stack.back().line += 1;
-		include_stack.back().column = 1;
-
-		// if next is different we'll skip it.
-		//std::istream &stream=(*include_stack.back().stream);
-		char nc = ( *include_stack.back().stream ).peek();
-		if ( ( nc == 10 || nc == 13 ) && ( nc != c ) )skip_eol = true;
-	} else {
-		if ( !skip_eol )include_stack.back().column += 1;
-		skip_eol = false;
-	}
+void Tokenizer::EnterBuffer( const char* data, size_t length, const std::string &name, bool partial_ ) {
+	buffer_begin = data;
+	buffer_pos = data;
+	buffer_end = data + length;
+	buffer_name = name;
+	partial = partial_;
+	token_buffer.clear();
+}
 
-	return c;
+void Tokenizer::EnterStream( std::istream &stream_, const std::string &name ) {
+	owned_buffer.assign( std::istreambuf_iterator<char>( stream_ ), std::istreambuf_iterator<char>() );
+	EnterBuffer( owned_buffer.data(), owned_buffer.size(), name );
 }
 
 bool Tokenizer::Good() {
-	UnwindStack();
-	return !include_stack.empty();
+	return buffer_pos < buffer_end;
 }
 
 void Tokenizer::ReadToken( Token &token ) {
-start:
-
-	SkipSpaces();
-	token.value_s.clear();
-
-	if ( !Good() ) {
-		token.type = Token::type_eof;
-        token.pos_string = "EOF";
-		return;
-	}
-
-    std::stringstream token_tmp;
-    if ( !include_stack.empty() && !include_stack.back().name.empty() )
-        token_tmp << include_stack.back().name << " , ";
-    token_tmp << "line " << include_stack.back().line << " , column " << include_stack.back().column;
-    token.pos_string = token_tmp.str();
-
-	char c = GetNextChar();
-	token.value_s += c;
-	// first find what token is it, and handle all except numbers
-	switch ( c ) {
-		case '[': {
-				token.type = Token::type_section_name;
-				token.value_s.clear();
-				bool skip_next_eol_char = false;
-				while ( Good() ) {
-					c = GetNextChar();
-					// std::string has problem with zero characters, replace by space.
-					if ( c == 0 ) {
-						c = ' ';
-					}
-					if ( c == '\\' ) {
-						if ( Good() ) {
-							token.value_s += GetNextChar();
-						} else {
-                            ReportError( token, "Quotes not closed before end of file" );
+	token.escaped = false;
+	for ( ;; ) {
+		SkipSpaces();
+		token.offset = buffer_pos - buffer_begin;
+		if ( !Good() ) {
+			// a partial buffer doesn't end the input, there is just nothing more yet
+			token.type = partial ? Token::type_none : Token::type_eof;
+			token.value = StringRef();
+			return;
+		}
+		const char* start = buffer_pos++;
+		// first find what token is it
+		switch ( *start ) {
+			case '[': {
+					token.type = Token::type_section_name;
+					const char* name = buffer_pos;
+					for ( ; buffer_pos < buffer_end; ++buffer_pos ) {
+						if ( *buffer_pos == '\\' ) {
+							token.escaped = true;
+							if ( buffer_pos + 1 == buffer_end )
+								break;
+							++buffer_pos;
+						} else if ( *buffer_pos == ']' ) {
+							token.value = StringRef( name, buffer_pos - name );
+							++buffer_pos;
 							return;
+						} else if ( *buffer_pos == 0 ) {
+							token.escaped = true;
 						}
-					} else if ( c == ']' ) {
-						return;
-					} else
-					{
-						token.value_s += c;
-					}
-					// handle end of line
-					if ( skip_next_eol_char ) {
-						skip_next_eol_char = false;
-					} else if ( c == 10 || c == 13 ) {
-						//++line;
-						//column=1;
-						if ( ( PeekNextChar() == 10 || PeekNextChar() == 13 ) && ( PeekNextChar() != c ) )skip_next_eol_char = true;
 					}
+					if ( partial )
+						break;
+					buffer_pos = buffer_end;
+					token.value = StringRef( name, buffer_end - name );
+					ReportError( token, "Quotes not closed before end of file" );
+					return;
 				}
-                ReportError( token, "Quotes not closed before end of file" );
-			}
-		case '{':
-			token.type = Token::type_enter_section;
-			return;
-		case '}':
-			token.type = Token::type_leave_section;
-			return;
-		case ';':
-			token.type = Token::type_semicolon;
-			return;
-		case '=':
-			token.type = Token::type_entry_value;
-            token.value_s = "";
-			while ( Good() && PeekNextChar() != ';' ) {
-				unsigned char c_ = GetNextChar();
-				token.value_s += c_;
-			}
-			return;
-		case '/':// handle comments
-			if ( PeekNextChar() == '/' ) {
-				//SkipToEOL();
-				if ( !include_stack.empty() ) {
-					std::string tmp;
-					std::getline( ( *include_stack.back().stream ), tmp );
-					include_stack.back().line += 1;
-					include_stack.back().column = 1;
+			case '{':
+				token.type = Token::type_enter_section;
+				token.value = StringRef( start, 1 );
+				return;
+			case '}':
+				token.type = Token::type_leave_section;
+				token.value = StringRef( start, 1 );
+				return;
+			case ';':
+				token.type = Token::type_semicolon;
+				token.value = StringRef( start, 1 );
+				return;
+			case '=': {
+					token.type = Token::type_entry_value;
+					const char* semicolon = static_cast<const char*>( std::memchr( buffer_pos, ';', buffer_end - buffer_pos ) );
+					if ( !semicolon && partial )
+						break;
+					const char* value = buffer_pos;
+					buffer_pos = semicolon ? semicolon : buffer_end;
+					token.value = StringRef( value, buffer_pos - value );
+					return;
 				}
-
-				goto start;
-			}
-			else if ( PeekNextChar() == '*' ) {// multi-line comment
-				while ( Good() ) {
-					char c1 = GetNextChar();
-					if ( ( c1 == '*' ) && ( PeekNextChar() == '/' ) ) {
-						GetNextChar();
+			case '/':// handle comments
+				if ( !Good() && partial )
+					break;
+				if ( Good() && *buffer_pos == '/' ) {
+					const char* eol = static_cast<const char*>( std::memchr( buffer_pos, '\n', buffer_end - buffer_pos ) );
+					if ( !eol && partial )
 						break;
-					}
+					buffer_pos = eol ? eol + 1 : buffer_end;
+					continue;
 				}
-				goto start;
-			}
-		default:
-			while ( Good() && PeekNextChar() != '=' ) {
-				unsigned char c_ = GetNextChar();
-				token.value_s += c_;
-			}
-			token.type = Token::type_entry_name;
-			return;
+				else if ( Good() && *buffer_pos == '*' ) {// multi-line comment
+					const char* close = buffer_pos + 1;
+					while ( close + 1 < buffer_end && !( close[0] == '*' && close[1] == '/' ) )
+						++close;
+					if ( close + 1 >= buffer_end && partial )
+						break;
+					buffer_pos = ( close + 1 < buffer_end ) ? close + 2 : buffer_end;
+					continue;
+				}
+				// a lone '/' starts an entry name
+				// fall through
+			default: {
+					const char* equals = static_cast<const char*>( std::memchr( buffer_pos, '=', buffer_end - buffer_pos ) );
+					if ( !equals && partial )
+						break;
+					buffer_pos = equals ? equals : buffer_end;
+					token.type = Token::type_entry_name;
+					token.value = StringRef( start, buffer_pos - start );
+					return;
+				}
+		}
+		// only partial buffers get here: the token isn't complete yet, leave it for the next one
+		buffer_pos = start;
+		token.type = Token::type_none;
+		token.value = StringRef();
+		token.escaped = false;
+		return;
 	}
 }
 
 void Tokenizer::SkipSpaces() {
-	while ( Good() && IsWhitespace( PeekNextChar() ) ) {
-		GetNextChar();
+	while ( Good() && IsWhitespace( *buffer_pos ) ) {
+		++buffer_pos;
 	}
 }
 
 Token Tokenizer::GetToken( int i ) {
-	int p = buffer_pos + i;
-	if ( p < 0 )return Token();
-	while ( int( token_buffer.size() ) < p + 1 ) {
+	if ( i < 0 )return Token();
+	while ( int( token_buffer.size() ) < i + 1 ) {
 		Token t;
 		ReadToken( t );
 		if ( t.IsEOF() )return t;
 		token_buffer.push_back( t );
 	}
 
-	return token_buffer[p];
+	return token_buffer[i];
 }
 
 void Tokenizer::Step( int i ) {
-	buffer_pos += i;
+	for ( ; i > 0; --i ) {
+		if ( !token_buffer.empty() ) {
+			token_buffer.pop_front();
+		} else {
+			Token skipped;
+			ReadToken( skipped );
+		}
+	}
+}
+
+size_t HashNoCase( StringRef name ) {
+	size_t hash = 2166136261u;
+	for ( size_t i = 0; i < name.size(); ++i )
+		hash = ( hash ^ static_cast<unsigned char>( LowerCase( name[i] ) ) ) * 16777619u;
+	return hash;
+}
+
+int ParseDoubleArray( StringRef text, int n_values, double *values ) {
+	int values_read = 0;
+	while ( values_read < n_values ) {
+		while ( !text.empty() && IsWhitespace( text[0] ) )
+			text.remove_prefix( 1 );
+		if ( text.empty() )
+			break;
+		size_t length = 0;
+		while ( length < text.size() && !IsWhitespace( text[length] ) )
+			++length;
+		values[values_read++] = Util::ParseDouble( text.data(), text.data() + length );
+		text.remove_prefix( length );
+	}
+	return values_read;
+}
+
+lslColor ParseFloatColour( StringRef text, int *components_read ) {
+	double values[3] = { 0, 0, 0 };
+	const int read = ParseDoubleArray( text, 3, values );
+	if ( components_read ) {
+		*components_read = read;
+	}
+	unsigned char components[3];
+	for ( int i = 0; i < 3; ++i ) {
+		// clamped before the cast, 1.0 would not fit
+		const double value = values[i] * 256;
+		components[i] = value <= 0 ? 0 : ( value >= 255 ? 255 : static_cast<unsigned char>( value ) );
+	}
+	return lslColor( components[0], components[1], components[2] );
+}
+
+Key::Key( const std::string& name ):
+		lower( name )
+{
+	Init();
+}
+
+Key::Key( const char* name ):
+		lower( name )
+{
+	Init();
+}
+
+Key::Key( const std::string& prefix, int index ):
+		lower( prefix )
+{
+	char buf[16];
+	char* end = buf + sizeof( buf );
+	char* p = end;
+	unsigned int value = index < 0 ? 0u - static_cast<unsigned int>( index ) : index;
+	do {
+		*--p = '0' + value % 10;
+		value /= 10;
+	} while ( value );
+	if ( index < 0 )
+		*--p = '-';
+	lower.append( p, end );
+	Init();
+}
+
+void Key::Init() {
+	for ( size_t i = 0; i < lower.size(); ++i )
+		lower[i] = LowerCase( lower[i] );
+	hash = HashNoCase( lower );
+}
+
+Path::Path( const std::string& path ):
+		absolute( !path.empty() && path[0] == '/' )
+{
+	size_t begin = 0;
+	while ( begin <= path.size() ) {
+		size_t end = path.find( '/', begin );
+		if ( end == std::string::npos )
+			end = path.size();
+		const std::string part = path.substr( begin, end - begin );
+		if ( !part.empty() && part != "." )
+			keys.push_back( Key( part ) );
+		begin = end + 1;
+	}
 }
 
 Node::~Node() {
@@ -498,6 +752,36 @@ PNode DataList::FindByPath( const std::string &str ) {
 	}
 }
 
+PNode DataList::Find( const Key& key ) {
+	if ( key.Lower() == ".." )return Parent();
+	if ( key.Lower() == "." )return this;
+	nodes_iterator i = nodes.find( key.Lower() );
+	if ( i != nodes.end() ) {
+		return i->second;
+	}
+	return NULL;
+}
+
+PNode DataList::FindByPath( const TDF::Path &path ) {
+	PDataList current_dir( this );
+	if ( path.Absolute() ) {// go to root
+		PDataList tmp = Parent();
+		while ( tmp.Ok() ) {
+			current_dir = tmp;
+			tmp = tmp->Parent();
+		}
+	}
+	const std::vector<Key>& keys = path.Keys();
+	if ( keys.empty() )
+		return PNode( current_dir );
+	for ( size_t i = 0; i + 1 < keys.size(); ++i ) {
+		current_dir = PDataList( current_dir->Find( keys[i] ) );
+		if ( !current_dir.Ok() )
+			return NULL;
+	}
+	return current_dir->Find( keys.back() );
+}
+
 PNode DataList::Next( PNode what ) {
 	if ( what.Ok() )return what->list_next;
 	return NULL;
@@ -567,7 +851,7 @@ void DataList::Load( Tokenizer &f ) {
 			case Token::type_entry_name:
 				{
 					PDataLeaf new_leaf( new DataLeaf );
-					new_leaf->SetName( t.value_s );
+					new_leaf->SetName( t.Value() );
 					new_leaf->Load( f );
 					Insert( PNode( new_leaf ) );
 				}
@@ -580,7 +864,7 @@ void DataList::Load( Tokenizer &f ) {
                         f.ReportError( t, "'{' expected" );
 					} else {
 						PDataList new_list( new DataList );
-						new_list->SetName( t.value_s );
+						new_list->SetName( t.Value() );
 						new_list->Load( f );// will eat the '}'
 						Insert( PNode( new_list ) );
 					}
@@ -594,78 +878,81 @@ void DataList::Load( Tokenizer &f ) {
 }
 
 
-int DataList::GetInt( const std::string &f_name, int default_value, bool *it_worked ) {
-	PDataLeaf leaf( Find( f_name ) );
-	if ( !leaf.ok() ) {
-		if ( it_worked ) {
-			*it_worked = false;
-		}
-		return default_value;
-	}
-	std::string s = leaf->GetValue();
-    long result =Util::FromString<long>( s );
+namespace {
+int LeafInt( const PDataLeaf& leaf, int default_value, bool *it_worked ) {
 	if ( it_worked ) {
-		*it_worked = true;
+		*it_worked = leaf.ok();
 	}
-	return result;
-}
-double DataList::GetDouble( const std::string &f_name, double default_value, bool *it_worked ) {
-	PDataLeaf leaf( Find( f_name ) );
-	if ( !leaf.ok() ) {
-		if ( it_worked ) {
-			*it_worked = false;
-		}
+	if ( !leaf.ok() )
 		return default_value;
-	}
-	std::string s = leaf->GetValue();
-    double result =Util::FromString<double>( s );
+	const std::string& value = leaf->Value();
+	return Util::ParseLong( value.data(), value.data() + value.size() );
+}
+
+double LeafDouble( const PDataLeaf& leaf, double default_value, bool *it_worked ) {
 	if ( it_worked ) {
-		*it_worked = true;
+		*it_worked = leaf.ok();
 	}
-	return result;
-}
-std::string DataList::GetString( const std::string &f_name, const std::string &default_value, bool *it_worked ) {
-	PDataLeaf leaf( Find( f_name ) );
-	if ( !leaf.ok() ) {
-		if ( it_worked ) {
-			*it_worked = false;
-		}
+	if ( !leaf.ok() )
 		return default_value;
-	}
+	const std::string& value = leaf->Value();
+	return Util::ParseDouble( value.data(), value.data() + value.size() );
+}
+
+std::string LeafString( const PDataLeaf& leaf, const std::string &default_value, bool *it_worked ) {
 	if ( it_worked ) {
-		*it_worked = true;
+		*it_worked = leaf.ok();
 	}
-	return leaf->GetValue();
+	return leaf.ok() ? leaf->Value() : default_value;
 }
-int DataList::GetDoubleArray( const std::string &f_name, int n_values, double *values ) {
-	PDataLeaf leaf( Find( f_name ) );
+
+int LeafDoubleArray( const PDataLeaf& leaf, int n_values, double *values ) {
 	if ( !leaf.ok() ) {
 		return 0;
 	}
-    //! TODO seperator?
-    StringVector tokens = Util::StringTokenize( leaf->GetValue(), "\n" );
-	int i = 0;
-	int values_read = 0;
-    for ( i = 0;i < n_values && tokens.size(); ++i ) {
-        std::string s = tokens[i];
-        double d = Util::FromString<double>( s );
-        values_read++;
-	}
-	return values_read;
+	return ParseDoubleArray( leaf->Value(), n_values, values );
 }
 
-lslColor DataList::GetColour( const std::string &f_name, const lslColor &default_value, bool *it_worked ) {
-	double values[3];
-	if ( GetDoubleArray( f_name, 3, values ) != 3 ) {
-		if ( it_worked ) {
-			*it_worked = false;
-		}
-		return default_value;
-	}
+lslColor LeafColour( const PDataLeaf& leaf, const lslColor &default_value, bool *it_worked ) {
+	int read = 0;
+	const lslColor colour = leaf.ok() ? ParseFloatColour( leaf->Value(), &read ) : default_value;
 	if ( it_worked ) {
-		*it_worked = true;
+		*it_worked = read == 3;
 	}
-	return lslColor( values[0]*255.99, values[1]*255.99, values[2]*255.99 );
+	return read == 3 ? colour : default_value;
+}
+} // namespace
+
+int DataList::GetInt( const std::string &f_name, int default_value, bool *it_worked ) {
+	return LeafInt( PDataLeaf( Find( f_name ) ), default_value, it_worked );
+}
+double DataList::GetDouble( const std::string &f_name, double default_value, bool *it_worked ) {
+	return LeafDouble( PDataLeaf( Find( f_name ) ), default_value, it_worked );
+}
+std::string DataList::GetString( const std::string &f_name, const std::string &default_value, bool *it_worked ) {
+	return LeafString( PDataLeaf( Find( f_name ) ), default_value, it_worked );
+}
+int DataList::GetDoubleArray( const std::string &f_name, int n_values, double *values ) {
+	return LeafDoubleArray( PDataLeaf( Find( f_name ) ), n_values, values );
+}
+lslColor DataList::GetColour( const std::string &f_name, const lslColor &default_value, bool *it_worked ) {
+	return LeafColour( PDataLeaf( Find( f_name ) ), default_value, it_worked );
+}
+
+int DataList::GetInt( const Key &key, int default_value, bool *it_worked ) {
+	return LeafInt( PDataLeaf( Find( key ) ), default_value, it_worked );
+}
+double DataList::GetDouble( const Key &key, double default_value, bool *it_worked ) {
+	return LeafDouble( PDataLeaf( Find( key ) ), default_value, it_worked );
+}
+std::string DataList::GetString( const Key &key, const std::string &default_value, bool *it_worked ) {
+	return LeafString( PDataLeaf( Find( key ) ), default_value, it_worked );
+}
+int DataList::GetDoubleArray( const Key &key, int n_values, double *values ) {
+	return LeafDoubleArray( PDataLeaf( Find( key ) ), n_values, values );
+}
+lslColor DataList::GetColour( const Key &key, const lslColor &default_value, bool *it_worked ) {
+	return LeafColour( PDataLeaf( Find( key ) ), default_value, it_worked );
 }
 
 
@@ -681,16 +968,14 @@ void DataLeaf::Save( TDFWriter &f ) {
 }
 void DataLeaf::Load( Tokenizer &f ) {
 	Token t = f.TakeToken();
-	value = t.value_s;
+	value = t.Value();
 	t = f.TakeToken();
-    if ( t.value_s != ";" ) {
+    if ( t.type != Token::type_semicolon ) {
         f.ReportError( t, "; expected" );
 	}
 }
 
-PDataList ParseTDF( std::istream &s, int *error_count ) {
-	Tokenizer t;
-	t.EnterStream( s );
+static PDataList Parse( Tokenizer &t, int *error_count ) {
     PDataList result( new DataList );
 	result->Load( t );
 	if ( error_count ) {
@@ -699,4 +984,31 @@ PDataList ParseTDF( std::istream &s, int *error_count ) {
 	return result;
 }
 
+PDataList ParseTDF( std::istream &s, int *error_count ) {
+	Tokenizer t;
+	t.EnterStream( s );
+	return Parse( t, error_count );
+}
+
+PDataList ParseTDF( const char* data, size_t length, int *error_count ) {
+	Tokenizer t;
+	t.EnterBuffer( data, length );
+	return Parse( t, error_count );
+}
+
+PDataList ParseTDFFile( const std::string &path, int *error_count ) {
+	Tokenizer t;
+	// the tree copies everything it keeps, the mapping only has to live through Parse
+	boost::interprocess::mapped_region region;
+	try {
+		boost::interprocess::file_mapping file( path.c_str(), boost::interprocess::read_only );
+		boost::interprocess::mapped_region( file, boost::interprocess::read_only ).swap( region );
+	} catch ( boost::interprocess::interprocess_exception &e ) {
+		// empty files can't be mapped, unreadable ones end up the same
+		LslDebug( "ParseTDFFile: could not map %s: %s", path.c_str(), e.what() );
+	}
+	t.EnterBuffer( static_cast<const char*>( region.get_address() ), region.get_size(), path );
+	return Parse( t, error_count );
+}
+
 } } // namespace LSL { namespace TDF {
@@ -6,30 +6,103 @@
 #include <lslutils/type_forwards.h>
 #include <lslutils/autopointers.h>
 
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/utility/string_ref.hpp>
+
 #include <sstream>
 #include <vector>
 #include <deque>
 #include <map>
 
-namespace LSL { namespace TDF {
+namespace LSL {
+
+//! same view type the line framer hands out
+typedef boost::string_ref StringRef;
+
+namespace TDF {
+
+/** \brief where a TDFWriter puts its output
+ * The writer hands over one complete line at a time.
+ **/
+class TDFSink
+{
+	public:
+		virtual ~TDFSink() {}
+		virtual void Write( const char* data, size_t length ) = 0;
+		virtual void Flush() {}
+};
+
+//! growable contiguous buffer, reserve once and the whole script fits
+class BufferSink : public TDFSink
+{
+	public:
+		explicit BufferSink( size_t reserve = 0 ) { m_buffer.reserve( reserve ); }
+		virtual void Write( const char* data, size_t length ) { m_buffer.append( data, length ); }
+		const std::string& Data() const { return m_buffer; }
+		//! hands the buffer over without copying it
+		void Swap( std::string& other ) { m_buffer.swap( other ); }
+	private:
+		std::string m_buffer;
+};
 
-/** \brief std::stringstream based output class for TDF
+//! for the old std::stringstream based interface
+class StreamSink : public TDFSink
+{
+	public:
+		explicit StreamSink( std::ostream& stream ) : m_stream( stream ) {}
+		virtual void Write( const char* data, size_t length ) { m_stream.write( data, length ); }
+		virtual void Flush() { m_stream.flush(); }
+	private:
+		std::ostream& m_stream;
+};
+
+/** \brief writes to a file descriptor, a file or a pipe, through a buffer of its own
+ * Errors are sticky, check Good() after Flush().
+ **/
+class FileSink : public TDFSink, public boost::noncopyable
+{
+	public:
+		//! \param owned closes \param fd when done
+		explicit FileSink( int fd, bool owned = false );
+		//! creates or truncates \param path
+		explicit FileSink( const std::string& path );
+		~FileSink();
+		virtual void Write( const char* data, size_t length );
+		virtual void Flush();
+		bool Good() const { return m_fd >= 0 && !m_failed; }
+	private:
+		enum { BUFFER_SIZE = 64 * 1024 };
+		void WriteOut( const char* data, size_t length );
+		int m_fd;
+		bool m_owned;
+		bool m_failed;
+		std::vector<char> m_buffer;
+};
+
+/** \brief output class for TDF
  * this is only ever used internally (script generation) 
  * and needn't be exposed to library users 
+ * Each line is put together in a reused buffer and handed to the sink in one go,
+ * numbers are formatted without streams or locale, indentation comes from a
+ * precomputed run of tabs.
  * \todo add link to format specification 
  **/
 class TDFWriter
 {
 	public:
 		TDFWriter( std::stringstream& s );
+		TDFWriter( TDFSink& sink );
 		~TDFWriter();
 		void EnterSection( const std::string& name );
 		void LeaveSection();
-		void Indent();
 		std::string GetCurrentPath();
-		void Append( const std::string& name, std::string value );
+		void Append( const std::string& name, const std::string& value );
+		void Append( const std::string& name, const char* value );
 		template<class T>
 		void Append( const std::string& name, T value );
+		//! \param value in fixed notation with \param decimals digits behind the point
+		void Append( const std::string& name, double value, int decimals );
 
 		/// works like algorithms such as std::sort
 		template<class T> void Append( const std::string& name, T begin, T end );
@@ -38,7 +111,29 @@ class TDFWriter
 		void Close();
 	protected:
 	private:
-		std::stringstream& m_stream;
+		//! appends the indentation to the line being put together
+		void Indent();
+		void BeginEntry( const std::string& name );
+		void EndEntry();
+		void Format( const std::string& value ) { m_line += value; }
+		void Format( const char* value ) { m_line += value; }
+		void Format( bool value ) { m_line += value ? '1' : '0'; }
+		void Format( int value ) { Format( static_cast<long long>( value ) ); }
+		void Format( unsigned int value ) { FormatUnsigned( value ); }
+		void Format( long value ) { Format( static_cast<long long>( value ) ); }
+		void Format( unsigned long value ) { FormatUnsigned( value ); }
+		void Format( long long value );
+		void Format( unsigned long long value ) { FormatUnsigned( value ); }
+		//! like std::ostream does by default, %g with 6 digits
+		void Format( double value );
+		void Format( float value ) { Format( static_cast<double>( value ) ); }
+		template<class T> void Format( const T& value ) { m_line += Util::ToString( value ); }
+		void FormatUnsigned( unsigned long long value );
+
+		boost::scoped_ptr<StreamSink> m_own_sink;
+		TDFSink& m_sink;
+		//! the line being put together
+		std::string m_line;
 		int m_depth;
 };
 
@@ -55,6 +150,55 @@ typedef RefcountedPointer<DataList> PDataList;
 class DataLeaf;
 typedef RefcountedPointer<DataLeaf> PDataLeaf;
 
+//! fnv-1a over the ascii lowercase of \param name, what Key and Document hash names with
+size_t HashNoCase( StringRef name );
+
+/** parses up to \param n_values whitespace separated doubles with Util::ParseDouble,
+ * \return how many there were
+ **/
+int ParseDoubleArray( StringRef text, int n_values, double *values );
+/** "r g b" with components in 0..1, scaled like Util::ColorFromFloatString, missing ones are 0.
+ * \param components_read if not NULL gets how many components there were
+ **/
+lslColor ParseFloatColour( StringRef text, int *components_read = NULL );
+
+/** \brief an entry or section name, case folded and hashed once
+ * Lookups taking a Key skip the lowercase copy a string lookup makes, keep the ones used
+ * over and over (every PLAYERn of a script) around and reuse them on any tree or document.
+ **/
+class Key {
+	public:
+		explicit Key( const std::string& name );
+		explicit Key( const char* name );
+		//! \param prefix with \param index appended, like "PLAYER" 3 for player3
+		Key( const std::string& prefix, int index );
+
+		//! the name in lowercase
+		const std::string& Lower() const { return lower; }
+		size_t Hash() const { return hash; }
+
+	private:
+		void Init();
+		std::string lower;
+		size_t hash;
+};
+
+/** \brief a FindByPath argument split into Keys once
+ * Empty and "." parts are dropped, ".." stays and goes up a level.
+ **/
+class Path {
+	public:
+		explicit Path( const std::string& path );
+
+		//! started with '/', resolved from the root
+		bool Absolute() const { return absolute; }
+		const std::vector<Key>& Keys() const { return keys; }
+
+	private:
+		std::vector<Key> keys;
+		bool absolute;
+};
+
 class Node: public RefcountedContainer , public boost::noncopyable
 {
 		friend class DataList;
@@ -118,10 +262,12 @@ class DataList: public Node {
 		bool Remove( PNode node );
 		bool Rename( const std::string& old_name, const std::string& new_name );
 		PNode Find( const std::string& str );// find by name
+		PNode Find( const Key& key );
 
 		std::string Path();
 
 		PNode FindByPath( const std::string& str );
+		PNode FindByPath( const TDF::Path& path );
 
 		PNode Next( PNode what );
 		PNode Prev( PNode what );
@@ -139,6 +285,13 @@ class DataList: public Node {
 		int GetDoubleArray( const std::string& name, int n_values, double *values );
 
 		lslColor GetColour( const std::string& name, const lslColor &default_value = lslColor( 0, 0, 0 ), bool *it_worked = NULL );
+
+		/// the same looked up by Key, numbers are parsed without streams or locale either way
+		int GetInt( const Key& key, int default_value = 0, bool *it_worked = NULL );
+		double GetDouble( const Key& key, double default_value = 0, bool *it_worked = NULL );
+		std::string GetString( const Key& key, const std::string& default_value = std::string(), bool *it_worked = NULL );
+		int GetDoubleArray( const Key& key, int n_values, double *values );
+		lslColor GetColour( const Key& key, const lslColor &default_value = lslColor( 0, 0, 0 ), bool *it_worked = NULL );
 };
 
 //! docme
@@ -148,6 +301,7 @@ class DataLeaf: public Node {
 		std::string value;
 	public:
 		std::string GetValue();
+		const std::string& Value() const { return value; }
 		void SetValue( const std::string& value );
 
 		virtual void Save( TDFWriter &f );
@@ -169,6 +323,10 @@ inline bool IsAlphaNum( char c ) {
 inline bool IsWhitespace( char c ) {
 	return ( c == ' ' ) || ( c == 10 ) || ( c == 13 ) || ( c == '\t' );
 }
+//! names are ascii, no locale needed to fold them
+inline char LowerCase( char c ) {
+	return ( c >= 'A' && c <= 'Z' ) ? c - 'A' + 'a' : c;
+}
 struct Token {
 	enum TokenType {
 		type_none,
@@ -181,75 +339,39 @@ struct Token {
 		type_eof
 	};
 	TokenType type;
-	std::string value_s;
-
-	std::string pos_string;// for error reporting
+	//! view into the tokenizer's buffer, section names may still contain escapes, see Value()
+	StringRef value;
+	//! byte offset into the buffer, only turned into line/column when an error is reported
+	size_t offset;
+	//! value holds backslash escapes or zero characters
+	bool escaped;
 
 	bool IsEOF() const {
 		return ( type == type_eof );
 	}
-	Token(): type( type_eof )
+	//! unescaped copy of value
+	std::string Value() const;
+
+	Token(): type( type_eof ), offset( 0 ), escaped( false )
 	{
 	}
 
 };
 
 /** \brief Tokenizer used in TDF parsing
- * \todo clean up, move to CPP file
+ * Works on one contiguous buffer, tokens are views into it. The buffer is either
+ * owned (EnterStream) or borrowed (EnterBuffer) and must then outlive the tokenizer.
  **/
-class Tokenizer {
-		
-		/// simple reference counted pointer to stream.
-		struct IncludeCacheEntry {
-			std::string name; ///< used for error reporting
-			int line;
-			int column;
-			std::istream *stream;
-			//bool must_delete;
-			int *refcount;
-
-			IncludeCacheEntry( std::istream *stream_, bool must_delete_ = false ):
-					line( 1 ),
-					column( 1 ),
-					stream( stream_ ),
-					refcount( NULL )
-			{
-				if ( must_delete_ ) {
-					refcount = new int;
-					( *refcount ) = 1;
-				}
-			}
-			IncludeCacheEntry( const IncludeCacheEntry &other ):
-					line( other.line ),
-					column( other.column ),
-					stream( other.stream ),
-					refcount( other.refcount )
-			{
-				stream = other.stream;
-				refcount = other.refcount;
-				if ( refcount )( *refcount ) += 1;
-			}
-			~IncludeCacheEntry()
-			{
-				if ( refcount ) {
-					( *refcount )--;
-					if ( ( *refcount ) <= 0 ) {
-						delete stream;
-						delete refcount;
-					}
-				}
-			}
-		};
-		std::vector<IncludeCacheEntry> include_stack;
-		void UnwindStack();
+class Tokenizer : public boost::noncopyable {
+		std::string owned_buffer;
+		const char* buffer_begin;
+		const char* buffer_pos;
+		const char* buffer_end;
+		std::string buffer_name; ///< used for error reporting
+		//! the buffer ends mid input, a token running into its end is left for the next one
+		bool partial;
 
 		std::deque<Token> token_buffer;
-		//size_t max_buffer_size;
-		size_t buffer_pos;
-
-		bool skip_eol;
-		char GetNextChar();
-		char PeekNextChar();
 
 		void ReadToken( Token &token );
 		void SkipSpaces();
@@ -257,22 +379,39 @@ class Tokenizer {
 		int errors;
 
 	public:
-		Tokenizer(): buffer_pos( 0 ), skip_eol( false ), errors( 0 )
+		Tokenizer(): buffer_begin( NULL ), buffer_pos( NULL ), buffer_end( NULL ), partial( false ), errors( 0 )
 		{
 		}
 
+		/** tokenizes \param data in place, replaces whatever was entered before
+		 * With \param partial_ set more input follows this buffer: a token that isn't complete
+		 * within it comes back as type_none and is not consumed.
+		 **/
+		void EnterBuffer( const char* data, size_t length, const std::string& name = "", bool partial_ = false );
+		//! reads the rest of \param stream_ into a buffer of our own
 		void EnterStream( std::istream& stream_, const std::string& name = "" );
 
 		Token GetToken( int i = 0 );
 		void Step( int i = 1 );
 		inline Token TakeToken() {
-			Token result = GetToken();
-			Step();
+			if ( token_buffer.empty() ) {
+				Token result;
+				ReadToken( result );
+				return result;
+			}
+			Token result = token_buffer.front();
+			token_buffer.pop_front();
 			return result;
 		}
 
 		bool Good();
+		//! bytes of the buffer tokenized so far, lookahead included
+		size_t Consumed() const {
+			return buffer_pos - buffer_begin;
+		}
 
+		//! "name , line l , column c" of \param t, counted from the buffer start
+		std::string Position( const Token& t ) const;
 		void ReportError( const Token& t, const std::string& err );
 
 		int NumErrors() const {
@@ -286,22 +425,26 @@ inline Tokenizer &operator >>( Tokenizer& tokenizer, Token& token ) {
 }
 
 PDataList ParseTDF( std::istream &s, int *error_count = NULL );
+PDataList ParseTDF( const char* data, size_t length, int *error_count = NULL );
+//! maps the file into memory instead of reading it, an unreadable file parses as empty list
+PDataList ParseTDFFile( const std::string& path, int *error_count = NULL );
 
 //Defintions to not clutter up the class declaration
 template<class T> void TDFWriter:: Append( const std::string& name, T value )
 {
-	Append( name, Util::ToString( value ) );
+	BeginEntry( name );
+	Format( value );
+	EndEntry();
 }
 
 template<class T>
 void TDFWriter::Append( const std::string& name, T begin, T end ) {
-	Indent();
-	m_stream << name << "=";
+	BeginEntry( name );
 	for ( T it = begin;it != end;++it ) {
-		if ( it != begin )m_stream << " ";
-		m_stream << ( *it );
+		if ( it != begin )m_line += ' ';
+		Format( *it );
 	}
-	m_stream << ";\n";
+	EndEntry();
 }
 
 } } // namespace LSL { namespace TDF {
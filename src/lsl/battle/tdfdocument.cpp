@@ -0,0 +1,363 @@
+#include "tdfdocument.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace LSL { namespace TDF {
+
+namespace {
+//! the name's hash mixed with the run start, so a Key's precomputed hash can be used
+inline size_t Hash( unsigned int run, size_t name_hash ) {
+	return name_hash ^ ( run * 2654435761u );
+}
+
+bool EqualNoCase( StringRef a, StringRef b ) {
+	if ( a.size() != b.size() )
+		return false;
+	for ( size_t i = 0; i < a.size(); ++i )
+		if ( LowerCase( a[i] ) != LowerCase( b[i] ) )
+			return false;
+	return true;
+}
+} // namespace
+
+Document::Document()
+	: lookup_used( 0 ),
+	errors( 0 )
+{
+}
+
+int Document::Parse( const char* data, size_t length, const std::string& name ) {
+	source.assign( data, data + length );
+	return Parse( name );
+}
+
+int Document::Parse( std::istream& stream, const std::string& name ) {
+	source.assign( std::istreambuf_iterator<char>( stream ), std::istreambuf_iterator<char>() );
+	return Parse( name );
+}
+
+int Document::Parse( const std::string& name ) {
+	// every entry has a '=' (but a last one cut off), every section a '[', plus the root;
+	// comments only make this too big
+	const size_t estimate = std::count( source.begin(), source.end(), '=' ) + std::count( source.begin(), source.end(), '[' ) + 2;
+	nodes.clear();
+	nodes.reserve( estimate );
+	size_t slots = 16;
+	while ( slots < 2 * estimate )
+		slots *= 2;
+	const Slot free_slot = { 0, 0 };
+	lookup.assign( slots, free_slot );
+	lookup_used = 0;
+	errors = 0;
+
+	// the root goes first, its run is laid out last
+	Entry root = Entry();
+	root.section = true;
+	nodes.push_back( root );
+	if ( open_sections.empty() )
+		open_sections.resize( 1 );
+	open_sections[0].clear();
+	size_t depth = 0;
+
+	Tokenizer f;
+	f.EnterBuffer( source.empty() ? NULL : &source[0], source.size(), name );
+	for ( bool done = false; !done; ) {
+		const Token t = f.TakeToken();
+		switch ( t.type ) {
+			case Token::type_eof:
+				while ( depth > 0 )
+					CloseSection( depth-- );
+				done = true;
+				break;
+			case Token::type_leave_section:
+				// a stray '}' ends the root just like it ends DataList::Load
+				if ( depth == 0 )
+					done = true;
+				else
+					CloseSection( depth-- );
+				break;
+			case Token::type_entry_name:
+				{
+					Entry leaf = Entry();
+					leaf.name = Unescape( t );
+					leaf.value = Unescape( f.TakeToken() );
+					const Token t2 = f.TakeToken();
+					if ( t2.type != Token::type_semicolon )
+						f.ReportError( t2, "; expected" );
+					open_sections[depth].push_back( leaf );
+				}
+				break;
+			case Token::type_section_name:
+				{
+					const Token t2 = f.TakeToken();
+					if ( t2.type != Token::type_enter_section ) {
+						f.ReportError( t, "'{' expected" );
+					} else {
+						Entry section = Entry();
+						section.name = Unescape( t );
+						section.section = true;
+						open_sections[depth].push_back( section );
+						if ( open_sections.size() <= ++depth )
+							open_sections.resize( depth + 1 );
+						open_sections[depth].clear();
+					}
+				}
+				break;
+			default:
+				f.ReportError( t, "[sectionname] or entryname= expected." );
+		}
+	}
+	CloseSection( 0 );
+
+	for ( unsigned int i = 0; i < nodes.size(); ++i ) {
+		for ( unsigned int c = 0; c < nodes[i].num_children; ++c )
+			nodes[nodes[i].first_child + c].parent = i;
+	}
+	errors = f.NumErrors();
+	return errors;
+}
+
+void Document::CloseSection( size_t depth ) {
+	std::vector<Entry>& children = open_sections[depth];
+	const unsigned int run = nodes.size();
+	for ( size_t i = 0; i < children.size(); ++i ) {
+		nodes.push_back( children[i] );
+		if ( !Insert( run, nodes.size() - 1 ) )
+			nodes.pop_back();
+	}
+	Entry& owner = ( depth == 0 ) ? nodes[0] : open_sections[depth - 1].back();
+	owner.first_child = run;
+	owner.num_children = nodes.size() - run;
+	children.clear();
+}
+
+StringRef Document::Unescape( const Token& t ) {
+	if ( !t.escaped )
+		return t.value;
+	// the unescaped name is never longer, write it over the escaped one
+	char* begin = &source[0] + ( t.value.data() - &source[0] );
+	char* out = begin;
+	for ( size_t i = 0; i < t.value.size(); ++i ) {
+		if ( t.value[i] == '\\' && i + 1 < t.value.size() )
+			*out++ = t.value[++i];
+		else
+			*out++ = t.value[i] ? t.value[i] : ' ';
+	}
+	return StringRef( begin, out - begin );
+}
+
+bool Document::Insert( unsigned int run, unsigned int node ) {
+	if ( 2 * ( lookup_used + 1 ) > lookup.size() ) {
+		// only if the estimate in Parse was off, rehash into twice the size
+		std::vector<Slot> old( 2 * lookup.size() );
+		old.swap( lookup );
+		lookup_used = 0;
+		for ( size_t i = 0; i < old.size(); ++i )
+			if ( old[i].node )
+				Insert( old[i].run, old[i].node );
+	}
+	const size_t mask = lookup.size() - 1;
+	for ( size_t i = Hash( run, HashNoCase( nodes[node].name ) ) & mask; ; i = ( i + 1 ) & mask ) {
+		Slot& slot = lookup[i];
+		if ( !slot.node ) {
+			slot.run = run;
+			slot.node = node;
+			++lookup_used;
+			return true;
+		}
+		if ( slot.run == run && EqualNoCase( nodes[slot.node].name, nodes[node].name ) )
+			return false;
+	}
+}
+
+unsigned int Document::Lookup( unsigned int section, StringRef name, size_t name_hash ) const {
+	const Entry& entry = nodes[section];
+	if ( entry.num_children == 0 )
+		return 0;
+	const size_t mask = lookup.size() - 1;
+	for ( size_t i = Hash( entry.first_child, name_hash ) & mask; lookup[i].node; i = ( i + 1 ) & mask ) {
+		if ( lookup[i].run == entry.first_child && EqualNoCase( nodes[lookup[i].node].name, name ) )
+			return lookup[i].node;
+	}
+	return 0;
+}
+
+bool NodeRef::IsSection() const {
+	return ok() && doc->nodes[index].section;
+}
+
+StringRef NodeRef::Name() const {
+	return ok() ? doc->nodes[index].name : StringRef();
+}
+
+StringRef NodeRef::Value() const {
+	return ok() ? doc->nodes[index].value : StringRef();
+}
+
+NodeRef NodeRef::Parent() const {
+	if ( !ok() || index == 0 )
+		return NodeRef();
+	return NodeRef( doc, doc->nodes[index].parent );
+}
+
+size_t NodeRef::NumChildren() const {
+	return ok() ? doc->nodes[index].num_children : 0;
+}
+
+NodeRef NodeRef::Child( size_t i ) const {
+	if ( i >= NumChildren() )
+		return NodeRef();
+	return NodeRef( doc, doc->nodes[index].first_child + i );
+}
+
+NodeRef NodeRef::Find( StringRef name ) const {
+	return Find( name, HashNoCase( name ) );
+}
+
+NodeRef NodeRef::Find( const Key& key ) const {
+	return Find( key.Lower(), key.Hash() );
+}
+
+NodeRef NodeRef::Find( StringRef name, size_t name_hash ) const {
+	if ( !ok() )
+		return NodeRef();
+	if ( name == ".." )
+		return Parent();
+	if ( name == "." )
+		return *this;
+	// the root is nobody's child, 0 means not found
+	const unsigned int found = doc->Lookup( index, name, name_hash );
+	return found ? NodeRef( doc, found ) : NodeRef();
+}
+
+NodeRef NodeRef::FindByPath( StringRef path ) const {
+	if ( path.empty() )
+		return *this;
+	NodeRef current = *this;
+	if ( path[0] == '/' ) {// go to root
+		current = ok() ? doc->Root() : NodeRef();
+		path.remove_prefix( 1 );
+	}
+	for ( ;; ) {
+		const size_t slash = path.find( '/' );
+		if ( slash == StringRef::npos )
+			return path.empty() ? current : current.Find( path );
+		const StringRef part = path.substr( 0, slash );
+		if ( part == ".." ) {
+			current = current.Parent();
+			if ( !current.ok() )
+				return NodeRef();
+		} else if ( !part.empty() && part != "." ) {
+			current = current.Find( part );
+			if ( !current.IsSection() )
+				return NodeRef();
+		}
+		path.remove_prefix( slash + 1 );
+	}
+}
+
+NodeRef NodeRef::FindByPath( const TDF::Path& path ) const {
+	NodeRef current = *this;
+	if ( path.Absolute() )
+		current = ok() ? doc->Root() : NodeRef();
+	const std::vector<Key>& keys = path.Keys();
+	if ( keys.empty() )
+		return current;
+	for ( size_t i = 0; i + 1 < keys.size(); ++i ) {
+		current = current.Find( keys[i] );
+		if ( !current.IsSection() )
+			return NodeRef();
+	}
+	return current.Find( keys.back() );
+}
+
+NodeRef NodeRef::FindLeaf( StringRef name ) const {
+	const NodeRef node = Find( name );
+	return node.IsLeaf() ? node : NodeRef();
+}
+
+NodeRef NodeRef::FindLeaf( const Key& key ) const {
+	const NodeRef node = Find( key );
+	return node.IsLeaf() ? node : NodeRef();
+}
+
+namespace {
+int LeafInt( const NodeRef& leaf, int default_value, bool *it_worked ) {
+	if ( it_worked ) {
+		*it_worked = leaf.ok();
+	}
+	if ( !leaf.ok() )
+		return default_value;
+	const StringRef value = leaf.Value();
+	return Util::ParseLong( value.data(), value.data() + value.size() );
+}
+
+double LeafDouble( const NodeRef& leaf, double default_value, bool *it_worked ) {
+	if ( it_worked ) {
+		*it_worked = leaf.ok();
+	}
+	if ( !leaf.ok() )
+		return default_value;
+	const StringRef value = leaf.Value();
+	return Util::ParseDouble( value.data(), value.data() + value.size() );
+}
+
+std::string LeafString( const NodeRef& leaf, const std::string& default_value, bool *it_worked ) {
+	if ( it_worked ) {
+		*it_worked = leaf.ok();
+	}
+	return leaf.ok() ? leaf.Value().to_string() : default_value;
+}
+
+lslColor LeafColour( const NodeRef& leaf, const lslColor &default_value, bool *it_worked ) {
+	int read = 0;
+	const lslColor colour = ParseFloatColour( leaf.Value(), &read );
+	if ( it_worked ) {
+		*it_worked = read == 3;
+	}
+	return read == 3 ? colour : default_value;
+}
+} // namespace
+
+int NodeRef::GetInt( StringRef name, int default_value, bool *it_worked ) const {
+	return LeafInt( FindLeaf( name ), default_value, it_worked );
+}
+
+double NodeRef::GetDouble( StringRef name, double default_value, bool *it_worked ) const {
+	return LeafDouble( FindLeaf( name ), default_value, it_worked );
+}
+
+std::string NodeRef::GetString( StringRef name, const std::string& default_value, bool *it_worked ) const {
+	return LeafString( FindLeaf( name ), default_value, it_worked );
+}
+
+int NodeRef::GetDoubleArray( StringRef name, int n_values, double *values ) const {
+	return ParseDoubleArray( FindLeaf( name ).Value(), n_values, values );
+}
+
+lslColor NodeRef::GetColour( StringRef name, const lslColor &default_value, bool *it_worked ) const {
+	return LeafColour( FindLeaf( name ), default_value, it_worked );
+}
+
+int NodeRef::GetInt( const Key& key, int default_value, bool *it_worked ) const {
+	return LeafInt( FindLeaf( key ), default_value, it_worked );
+}
+
+double NodeRef::GetDouble( const Key& key, double default_value, bool *it_worked ) const {
+	return LeafDouble( FindLeaf( key ), default_value, it_worked );
+}
+
+std::string NodeRef::GetString( const Key& key, const std::string& default_value, bool *it_worked ) const {
+	return LeafString( FindLeaf( key ), default_value, it_worked );
+}
+
+int NodeRef::GetDoubleArray( const Key& key, int n_values, double *values ) const {
+	return ParseDoubleArray( FindLeaf( key ).Value(), n_values, values );
+}
+
+lslColor NodeRef::GetColour( const Key& key, const lslColor &default_value, bool *it_worked ) const {
+	return LeafColour( FindLeaf( key ), default_value, it_worked );
+}
+
+} } // namespace LSL { namespace TDF {
@@ -0,0 +1,158 @@
+#ifndef LSL_HEADERGUARD_TDFDOCUMENT_H
+#define LSL_HEADERGUARD_TDFDOCUMENT_H
+
+#include "tdfcontainer.h"
+
+#include <boost/noncopyable.hpp>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace LSL { namespace TDF {
+
+class Document;
+
+/** \brief a section or entry of a Document, a (document,index) pair that is cheap to copy
+ * Offers what DataList does for reading, a default constructed one is not ok(), Find
+ * on it finds nothing. Only valid as long as its document is.
+ **/
+class NodeRef {
+	public:
+		NodeRef(): doc( NULL ), index( 0 ) {}
+
+		bool ok() const { return doc != NULL; }
+		bool Ok() const { return ok(); }
+		bool IsSection() const;
+		bool IsLeaf() const { return ok() && !IsSection(); }
+
+		StringRef Name() const;
+		//! raw value of an entry, empty for sections
+		StringRef Value() const;
+
+		NodeRef Parent() const;
+		size_t NumChildren() const;
+		//! children in file order
+		NodeRef Child( size_t i ) const;
+
+		//! case insensitive like DataList::Find, ".." and "." included
+		NodeRef Find( StringRef name ) const;
+		NodeRef Find( const Key& key ) const;
+		NodeRef FindByPath( StringRef path ) const;
+		NodeRef FindByPath( const TDF::Path& path ) const;
+
+		int GetInt( StringRef name, int default_value = 0, bool *it_worked = NULL ) const;
+		double GetDouble( StringRef name, double default_value = 0, bool *it_worked = NULL ) const;
+		std::string GetString( StringRef name, const std::string& default_value = std::string(), bool *it_worked = NULL ) const;
+		/// returns number of values that were successfully read, values are separated by whitespace
+		int GetDoubleArray( StringRef name, int n_values, double *values ) const;
+		lslColor GetColour( StringRef name, const lslColor &default_value = lslColor( 0, 0, 0 ), bool *it_worked = NULL ) const;
+
+		/// the same looked up by Key, which saves hashing the name
+		int GetInt( const Key& key, int default_value = 0, bool *it_worked = NULL ) const;
+		double GetDouble( const Key& key, double default_value = 0, bool *it_worked = NULL ) const;
+		std::string GetString( const Key& key, const std::string& default_value = std::string(), bool *it_worked = NULL ) const;
+		int GetDoubleArray( const Key& key, int n_values, double *values ) const;
+		lslColor GetColour( const Key& key, const lslColor &default_value = lslColor( 0, 0, 0 ), bool *it_worked = NULL ) const;
+
+		bool operator==( const NodeRef& other ) const { return doc == other.doc && index == other.index; }
+		bool operator!=( const NodeRef& other ) const { return !( *this == other ); }
+
+	private:
+		friend class Document;
+		NodeRef( const Document* doc_, unsigned int index_ ): doc( doc_ ), index( index_ ) {}
+		NodeRef Find( StringRef name, size_t name_hash ) const;
+		//! the entry called \param name, not a section
+		NodeRef FindLeaf( StringRef name ) const;
+		NodeRef FindLeaf( const Key& key ) const;
+
+		const Document* doc;
+		unsigned int index;
+};
+
+/** \brief read only TDF tree in a handful of allocations
+ * The document keeps a copy of the source text and every name and value is a view into
+ * it, escaped section names are unescaped in place. Nodes sit in one array, the children
+ * of a section in one contiguous run of it (a section's run is laid out when it's closed,
+ * so nested runs come first and the root's is last). One hash table keyed on (run start,
+ * lowercase name) answers every Find in the document. Parsing follows ParseTDF, errors
+ * included, so a later duplicate name is dropped just like DataList::Insert does.
+ **/
+class Document : public boost::noncopyable {
+	public:
+		Document();
+
+		//! replaces the current contents with a copy of \param data parsed, \return number of errors
+		int Parse( const char* data, size_t length, const std::string& name = "" );
+		int Parse( std::istream& stream, const std::string& name = "" );
+
+		NodeRef Root() const { return NodeRef( this, 0 ); }
+		//! sections and entries, the root included
+		size_t Size() const { return nodes.size(); }
+		int NumErrors() const { return errors; }
+
+	private:
+		friend class NodeRef;
+
+		struct Entry {
+			StringRef name;
+			StringRef value;
+			unsigned int parent;
+			unsigned int first_child;
+			unsigned int num_children;
+			bool section;
+		};
+
+		//! open addressing slot of the lookup table, node 0 (the root) marks a free one
+		struct Slot {
+			unsigned int run;
+			unsigned int node;
+		};
+
+		int Parse( const std::string& name );
+		//! moves the children collected at \param depth into nodes as the run of their section
+		void CloseSection( size_t depth );
+		StringRef Unescape( const Token& t );
+		//! adds \param node to the table, false if its run already has that name
+		bool Insert( unsigned int run, unsigned int node );
+		//! index of the child of \param section called \param name, 0 if there is none
+		unsigned int Lookup( unsigned int section, StringRef name, size_t name_hash ) const;
+
+		std::vector<char> source;
+		std::vector<Entry> nodes;
+		//! power of two sized, at most half full
+		std::vector<Slot> lookup;
+		size_t lookup_used;
+		//! children of the currently open sections, one list per depth, reused between parses
+		std::vector<std::vector<Entry> > open_sections;
+		int errors;
+};
+
+} } // namespace LSL { namespace TDF {
+
+/**
+ * \file tdfdocument.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#endif // LSL_HEADERGUARD_TDFDOCUMENT_H
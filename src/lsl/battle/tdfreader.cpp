@@ -0,0 +1,154 @@
+#include "tdfreader.h"
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+namespace LSL { namespace TDF {
+
+namespace BA = boost::algorithm;
+
+Reader::Reader( Handler& handler_, const std::string& name_ )
+	: handler( handler_ ),
+	name( name_ ),
+	depth( 0 ),
+	stopped( false ),
+	errors( 0 )
+{
+}
+
+size_t Reader::Read( const char* data, size_t length, bool final ) {
+	if ( stopped )
+		return 0;
+	Tokenizer f;
+	f.EnterBuffer( data, length, name, !final );
+	size_t consumed = 0;
+	bool incomplete = false;
+	while ( !stopped && !incomplete ) {
+		// an entry or a section header is handled whole or left for the next piece
+		consumed = f.Consumed();
+		const Token t = f.TakeToken();
+		switch ( t.type ) {
+			case Token::type_none:
+				incomplete = true;
+				break;
+			case Token::type_eof:
+				// only a final piece ends
+				for ( ; depth > 0 && !stopped; --depth )
+					stopped = !handler.LeaveSection();
+				errors += f.NumErrors();
+				return length;
+			case Token::type_leave_section:
+				// a stray '}' ends the root just like it ends DataList::Load
+				if ( depth == 0 ) {
+					stopped = true;
+				} else {
+					--depth;
+					stopped = !handler.LeaveSection();
+				}
+				break;
+			case Token::type_entry_name:
+				{
+					const Token value = f.TakeToken();
+					const Token t2 = f.TakeToken();
+					if ( value.type == Token::type_none || t2.type == Token::type_none ) {
+						incomplete = true;
+						break;
+					}
+					if ( t2.type != Token::type_semicolon )
+						f.ReportError( t2, "; expected" );
+					stopped = !handler.Entry( t.value, value.value );
+				}
+				break;
+			case Token::type_section_name:
+				{
+					const Token t2 = f.TakeToken();
+					if ( t2.type == Token::type_none ) {
+						incomplete = true;
+						break;
+					}
+					if ( t2.type != Token::type_enter_section ) {
+						f.ReportError( t, "'{' expected" );
+					} else {
+						++depth;
+						if ( t.escaped )
+							scratch = t.Value();
+						stopped = !handler.EnterSection( t.escaped ? StringRef( scratch ) : t.value );
+					}
+				}
+				break;
+			default:
+				f.ReportError( t, "[sectionname] or entryname= expected." );
+		}
+	}
+	// stopped, or the last entry/section header needs more input
+	if ( stopped )
+		consumed = f.Consumed();
+	errors += f.NumErrors();
+	return consumed;
+}
+
+bool ReadTDF( const char* data, size_t length, Handler& handler, int *error_count ) {
+	Reader reader( handler );
+	reader.Finish( data, length );
+	if ( error_count ) {
+		*error_count = reader.NumErrors();
+	}
+	return !reader.Stopped();
+}
+
+void PathCollector::Want( const std::string& path ) {
+	const std::string lower = BA::to_lower_copy( path );
+	wanted.insert( lower );
+	for ( size_t slash = lower.find( '/' ); slash != std::string::npos; slash = lower.find( '/', slash + 1 ) )
+		prefixes.insert( lower.substr( 0, slash + 1 ) );
+}
+
+bool PathCollector::Found( const std::string& path ) const {
+	return values.find( BA::to_lower_copy( path ) ) != values.end();
+}
+
+std::string PathCollector::Get( const std::string& path, const std::string& default_value ) const {
+	const std::map<std::string, std::string>::const_iterator it = values.find( BA::to_lower_copy( path ) );
+	return it == values.end() ? default_value : it->second;
+}
+
+bool PathCollector::EnterSection( StringRef name ) {
+	if ( skipped > 0 ) {
+		++skipped;
+		return true;
+	}
+	const size_t length = current.size();
+	current.append( name.data(), name.size() );
+	BA::to_lower( current );
+	current += '/';
+	if ( prefixes.find( current ) != prefixes.end() ) {
+		lengths.push_back( length );
+	} else {
+		current.resize( length );
+		++skipped;
+	}
+	return true;
+}
+
+bool PathCollector::Entry( StringRef name, StringRef value ) {
+	if ( skipped > 0 )
+		return true;
+	std::string path = current;
+	path.append( name.data(), name.size() );
+	BA::to_lower( path );
+	// like DataList, a later duplicate doesn't replace the first one
+	if ( wanted.erase( path ) )
+		values[path] = value.to_string();
+	return !wanted.empty();
+}
+
+bool PathCollector::LeaveSection() {
+	if ( skipped > 0 ) {
+		--skipped;
+	} else if ( !lengths.empty() ) {
+		current.resize( lengths.back() );
+		lengths.pop_back();
+	}
+	return true;
+}
+
+} } // namespace LSL { namespace TDF {
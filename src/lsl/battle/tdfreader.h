@@ -0,0 +1,121 @@
+#ifndef LSL_HEADERGUARD_TDFREADER_H
+#define LSL_HEADERGUARD_TDFREADER_H
+
+#include "tdfcontainer.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace LSL { namespace TDF {
+
+/** \brief what a Reader reports while it walks a TDF text
+ * Names and values are views into the buffer passed to the reader, only valid during the
+ * call. Returning false from any callback stops the reader.
+ **/
+class Handler {
+	public:
+		virtual ~Handler() {}
+		virtual bool EnterSection( StringRef /*name*/ ) { return true; }
+		virtual bool Entry( StringRef /*name*/, StringRef /*value*/ ) { return true; }
+		virtual bool LeaveSection() { return true; }
+};
+
+/** \brief event driven TDF parsing, no tree is built
+ * Accepts the text in pieces: Feed() handles every complete entry and section header
+ * of a piece and \return s how much of it it used, the caller passes the rest again
+ * with more text behind it. Finish() takes the last piece and closes the sections
+ * still open. Memory use only depends on the nesting depth. Errors are the ones
+ * ParseTDF would report, positions counted from the start of the piece at hand.
+ **/
+class Reader {
+	public:
+		Reader( Handler& handler, const std::string& name = "" );
+
+		size_t Feed( const char* data, size_t length ) { return Read( data, length, false ); }
+		size_t Finish( const char* data = NULL, size_t length = 0 ) { return Read( data, length, true ); }
+
+		//! a handler callback returned false, or a stray '}' ended the text
+		bool Stopped() const { return stopped; }
+		size_t Depth() const { return depth; }
+		int NumErrors() const { return errors; }
+
+	private:
+		size_t Read( const char* data, size_t length, bool final );
+
+		Handler& handler;
+		const std::string name;
+		//! unescaped section name, handed out as view
+		std::string scratch;
+		size_t depth;
+		bool stopped;
+		int errors;
+};
+
+//! reads all of \param data, \return false if the reader stopped early
+bool ReadTDF( const char* data, size_t length, Handler& handler, int *error_count = NULL );
+
+/** \brief collects the values of a few known entries, stops once it has all of them
+ * Paths look like "GAME/MapName", are case insensitive and relative to the root.
+ * Good for one read, it doesn't know where a stopped reader left it.
+ **/
+class PathCollector : public Handler {
+	public:
+		PathCollector(): skipped( 0 ) {}
+		template<class T> PathCollector( T begin, T end ): skipped( 0 ) {
+			for ( ; begin != end; ++begin ) Want( *begin );
+		}
+		void Want( const std::string& path );
+
+		bool Found( const std::string& path ) const;
+		std::string Get( const std::string& path, const std::string& default_value = std::string() ) const;
+		const std::map<std::string, std::string>& Values() const { return values; }
+
+		virtual bool EnterSection( StringRef name );
+		virtual bool Entry( StringRef name, StringRef value );
+		virtual bool LeaveSection();
+
+	private:
+		//! lowercase paths still missing
+		std::set<std::string> wanted;
+		//! lowercase sections that lead to a wanted path
+		std::set<std::string> prefixes;
+		std::map<std::string, std::string> values;
+		//! lowercase path of the open section, with a trailing '/'
+		std::string current;
+		//! lengths of current before each open section was entered
+		std::vector<size_t> lengths;
+		//! open sections below one that can't lead anywhere
+		size_t skipped;
+};
+
+} } // namespace LSL { namespace TDF {
+
+/**
+ * \file tdfreader.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#endif // LSL_HEADERGUARD_TDFREADER_H
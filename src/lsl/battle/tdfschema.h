@@ -0,0 +1,188 @@
+#ifndef LSL_HEADERGUARD_TDFSCHEMA_H
+#define LSL_HEADERGUARD_TDFSCHEMA_H
+
+#include "tdfcontainer.h"
+#include "tdfdocument.h"
+#include <lslutils/conversion.h>
+
+#include <string>
+#include <vector>
+
+namespace LSL { namespace TDF {
+
+/** \brief fills the fields of a T from the entries of one section
+ * Describe the struct once, every field with its Key and default, then Extract each
+ * PLAYERn/TEAMn/ALLYTEAMn section into it: no name is lowercased or hashed twice and no
+ * number goes through a stream. Works on DataList trees and Documents alike.
+ * \code
+ * Schema<Team> schema;
+ * schema.Int( "TeamLeader", &Team::leader ).Colour( "RGBColor", &Team::colour );
+ * schema.Extract( root->Find( Key( "TEAM", 3 ) ), team );
+ * \endcode
+ **/
+template<class T>
+class Schema {
+	public:
+		Schema& Int( const std::string& name, int T::*member, int default_value = 0 );
+		Schema& Double( const std::string& name, double T::*member, double default_value = 0 );
+		Schema& String( const std::string& name, std::string T::*member, const std::string& default_value = std::string() );
+		//! RGBColor style "r g b", see ParseFloatColour, black if missing
+		Schema& Colour( const std::string& name, lslColor T::*member );
+
+		//! sets every field, missing entries get their default, \return false (out untouched) without a section
+		bool Extract( const PDataList& section, T& out ) const;
+		bool Extract( const NodeRef& section, T& out ) const;
+
+	private:
+		enum Kind {
+			kind_int,
+			kind_double,
+			kind_string,
+			kind_colour
+		};
+		struct Field {
+			Field( const std::string& name, Kind kind_ )
+				: key( name ), kind( kind_ ), int_member( NULL ), double_member( NULL ),
+				string_member( NULL ), colour_member( NULL ), int_default( 0 ), double_default( 0 )
+			{}
+			Key key;
+			Kind kind;
+			int T::*int_member;
+			double T::*double_member;
+			std::string T::*string_member;
+			lslColor T::*colour_member;
+			int int_default;
+			double double_default;
+			std::string string_default;
+		};
+
+		//! \param value is NULL if the section has no such entry
+		static void Assign( const Field& field, const StringRef* value, T& out );
+
+		std::vector<Field> fields;
+};
+
+template<class T>
+Schema<T>& Schema<T>::Int( const std::string& name, int T::*member, int default_value ) {
+	Field field( name, kind_int );
+	field.int_member = member;
+	field.int_default = default_value;
+	fields.push_back( field );
+	return *this;
+}
+
+template<class T>
+Schema<T>& Schema<T>::Double( const std::string& name, double T::*member, double default_value ) {
+	Field field( name, kind_double );
+	field.double_member = member;
+	field.double_default = default_value;
+	fields.push_back( field );
+	return *this;
+}
+
+template<class T>
+Schema<T>& Schema<T>::String( const std::string& name, std::string T::*member, const std::string& default_value ) {
+	Field field( name, kind_string );
+	field.string_member = member;
+	field.string_default = default_value;
+	fields.push_back( field );
+	return *this;
+}
+
+template<class T>
+Schema<T>& Schema<T>::Colour( const std::string& name, lslColor T::*member ) {
+	Field field( name, kind_colour );
+	field.colour_member = member;
+	fields.push_back( field );
+	return *this;
+}
+
+template<class T>
+bool Schema<T>::Extract( const PDataList& section, T& out ) const {
+	if ( !section.ok() )
+		return false;
+	for ( size_t i = 0; i < fields.size(); ++i ) {
+		const PDataLeaf leaf( section->Find( fields[i].key ) );
+		if ( leaf.ok() ) {
+			const StringRef value( leaf->Value() );
+			Assign( fields[i], &value, out );
+		} else {
+			Assign( fields[i], NULL, out );
+		}
+	}
+	return true;
+}
+
+template<class T>
+bool Schema<T>::Extract( const NodeRef& section, T& out ) const {
+	if ( !section.IsSection() )
+		return false;
+	for ( size_t i = 0; i < fields.size(); ++i ) {
+		const NodeRef leaf = section.Find( fields[i].key );
+		if ( leaf.IsLeaf() ) {
+			const StringRef value( leaf.Value() );
+			Assign( fields[i], &value, out );
+		} else {
+			Assign( fields[i], NULL, out );
+		}
+	}
+	return true;
+}
+
+template<class T>
+void Schema<T>::Assign( const Field& field, const StringRef* value, T& out ) {
+	switch ( field.kind ) {
+		case kind_int:
+			if ( value ) {
+				out.*field.int_member = Util::ParseLong( value->data(), value->data() + value->size() );
+			} else {
+				out.*field.int_member = field.int_default;
+			}
+			break;
+		case kind_double:
+			if ( value )
+				out.*field.double_member = Util::ParseDouble( value->data(), value->data() + value->size() );
+			else
+				out.*field.double_member = field.double_default;
+			break;
+		case kind_string:
+			if ( value )
+				( out.*field.string_member ).assign( value->data(), value->size() );
+			else
+				out.*field.string_member = field.string_default;
+			break;
+		case kind_colour:
+			out.*field.colour_member = ParseFloatColour( value ? *value : StringRef() );
+			break;
+	}
+}
+
+} } // namespace LSL { namespace TDF {
+
+/**
+ * \file tdfschema.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+#endif // LSL_HEADERGUARD_TDFSCHEMA_H
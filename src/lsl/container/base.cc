@@ -1,4 +1,5 @@
 #include <boost/format.hpp>
+#include <algorithm>
 
 namespace LSL {
 
@@ -8,62 +9,104 @@ ContainerBase<T>::ContainerBase()
 }
 
 template < class T >
-void ContainerBase<T>::Add( PointerType item )
+typename ContainerBase<T>::PointerType ContainerBase<T>::Add( PointerType item )
 {
-    m_map[item->key()] = item;
-    m_seekpos = SEEKPOS_INVALID;
+    const std::pair<typename IndexType::iterator, bool> slot =
+            m_index.insert( std::make_pair( item->key(), m_items.size() ) );
+    if ( slot.second )
+        m_items.push_back( item );
+    else
+        m_items[slot.first->second] = item;
+    return item;
 }
 
 template < class T >
 typename ContainerBase<T>::PointerType ContainerBase<T>::Add( ItemType* item )
 {
-    PointerType p( item );
-    Add( p );
-    return p;
+    return Add( PointerType( item ) );
 }
 
 template < class T >
 void ContainerBase<T>::Remove( const KeyType& index )
 {
-    typename ContainerBase<T>::MapType::iterator
-        it = m_map.find( index );
-    const bool found = it != m_map.end();
-    if ( found ) {
-        m_map.erase( it );
-        m_seekpos = SEEKPOS_INVALID;
+    typename IndexType::iterator it = m_index.find( index );
+    if ( it == m_index.end() )
+        return;
+    const size_type slot = it->second;
+    m_index.erase( it );
+    if ( slot + 1 != m_items.size() ) {
+        //the last item fills the gap
+        m_items[slot].swap( m_items.back() );
+        m_index[m_items[slot]->key()] = slot;
     }
+    m_items.pop_back();
+}
+
+template < class T >
+void ContainerBase<T>::reserve( size_type count )
+{
+    m_items.reserve( count );
+    m_index.rehash( static_cast<size_type>( count / m_index.max_load_factor() ) + 1 );
 }
 
 template < class T >
 const typename ContainerBase<T>::PointerType ContainerBase<T>::Get( const KeyType& index ) const
 {
-    typename ContainerBase<T>::MapType::const_iterator
-        it = m_map.find( index );
-    if ( it == m_map.end() )
+    typename IndexType::const_iterator it = m_index.find( index );
+    if ( it == m_index.end() )
         throw MissingItemException( index );
-    return it->second;
+    return m_items[it->second];
 }
 
 template < class T >
 typename ContainerBase<T>::PointerType ContainerBase<T>::Get( const KeyType& index )
 {
-    typename ContainerBase<T>::MapType::iterator
-        it = m_map.find( index );
-    if ( it == m_map.end() )
+    typename IndexType::const_iterator it = m_index.find( index );
+    if ( it == m_index.end() )
         throw MissingItemException( index );
-    return it->second;
+    return m_items[it->second];
+}
+
+template < class T >
+const typename ContainerBase<T>::PointerType ContainerBase<T>::Find( const KeyType& index ) const
+{
+    typename IndexType::const_iterator it = m_index.find( index );
+    if ( it == m_index.end() )
+        return PointerType();
+    return m_items[it->second];
 }
 
 template < class T >
 bool ContainerBase<T>::Exists( const KeyType& index ) const
 {
-    return m_map.find( index ) != m_map.end();
+    return m_index.find( index ) != m_index.end();
 }
 
 template < class T >
-typename ContainerBase<T>::MapType::size_type ContainerBase<T>::size() const
+bool ContainerBase<T>::Exists( const ConstPointerType ptr ) const
+{
+    if ( !ptr )
+        return false;
+    typename IndexType::const_iterator it = m_index.find( ptr->key() );
+    return it != m_index.end() && m_items[it->second] == ptr;
+}
+
+template < class T >
+typename ContainerBase<T>::VectorType::const_iterator ContainerBase<T>::find( const KeyType& key ) const
 {
-    return m_map.size();
+    typename IndexType::const_iterator it = m_index.find( key );
+    if ( it == m_index.end() )
+        return m_items.end();
+    return m_items.begin() + it->second;
+}
+
+template < class T >
+typename ContainerBase<T>::VectorType::iterator ContainerBase<T>::find( const KeyType& key )
+{
+    typename IndexType::const_iterator it = m_index.find( key );
+    if ( it == m_index.end() )
+        return m_items.end();
+    return m_items.begin() + it->second;
 }
 
 template < class T >
@@ -72,77 +115,40 @@ ContainerBase<T>::MissingItemException::MissingItemException( const typename Con
 {}
 
 template < class T >
-ContainerBase<T>::MissingItemException::MissingItemException( const typename ContainerBase<T>::MapType::size_type& index )
+ContainerBase<T>::MissingItemException::MissingItemException( const typename ContainerBase<T>::size_type& index )
     : std::runtime_error( (boost::format( "No %s found in list for item with pseudo index %s" ) % T::className() % index).str() )
 {}
 
 template < class T >
 const typename ContainerBase<T>::ConstPointerType
-ContainerBase<T>::At( const typename ContainerBase<T>::MapType::size_type index) const
+ContainerBase<T>::At( const typename ContainerBase<T>::size_type index) const
 {
-    if ((m_seekpos == SEEKPOS_INVALID) || (m_seekpos > index)) {
-        m_seek = m_map.begin();
-        m_seekpos = 0;
-    }
-    std::advance( m_seek, index - m_seekpos );
-    m_seekpos = index;
-    return m_seek->second;
+    if ( index >= m_items.size() )
+        throw MissingItemException( index );
+    return m_items[index];
 }
 
 template < class T >
 const typename ContainerBase<T>::PointerType
-ContainerBase<T>::At( const typename ContainerBase<T>::MapType::size_type index)
+ContainerBase<T>::At( const typename ContainerBase<T>::size_type index)
 {
-    if ((m_seekpos == SEEKPOS_INVALID) || (m_seekpos > index)) {
-        m_seek = m_map.begin();
-        m_seekpos = 0;
-    }
-    std::advance( m_seek, index - m_seekpos );
-    m_seekpos = index;
-    return m_seek->second;
+    if ( index >= m_items.size() )
+        throw MissingItemException( index );
+    return m_items[index];
 }
 
 template < class T >
 typename ContainerBase<T>::ConstVectorType
 ContainerBase<T>::Vectorize() const
 {
-    std::vector< ConstPointerType > ret;
-    for( typename MapType::const_iterator it = m_map.begin(); it != m_map.end(); ++it ) {
-        ret.push_back( it->second );
-    }
-    return ret;
+    return ConstVectorType( m_items.begin(), m_items.end() );
 }
 
 template < class T >
 typename ContainerBase<T>::VectorType
 ContainerBase<T>::Vectorize()
 {
-    std::vector< PointerType > ret;
-    for( typename MapType::iterator it = m_map.begin(); it != m_map.end(); ++it ) {
-        ret.push_back( it->second );
-    }
-    return ret;
-}
-
-template < class PtrType >
-struct map_data_compare
-{
-    const PtrType ptr_;
-    map_data_compare( const PtrType ptr ) : ptr_(ptr) {}
-    template < class PairType >
-    bool operator() ( const PairType& pair ) const
-    {
-        return pair.second == ptr_;
-    }
-};
-
-template < class T >
-bool ContainerBase<T>::Exists( const ConstPointerType ptr ) const
-{
-    typedef ContainerBase<T>::ConstPointerType
-            PP;
-    return end() != std::find_if( begin(), end(),
-                                  map_data_compare<PP>(ptr) );
+    return m_items;
 }
 
 }
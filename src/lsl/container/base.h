@@ -2,14 +2,21 @@
 #define LIBSPRINGLOBBY_HEADERGUARD_CONTAINERBASE_H
 
 
+#include <boost/range/adaptor/filtered.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <boost/smart_ptr.hpp>
-#include <map>
+#include <boost/unordered_map.hpp>
 #include <vector>
 #include <stdexcept>
 
 namespace LSL {
 
-//! common base class for *List classes
+/** \brief common base class for *List classes
+ * Items live in a dense vector, so At() and iteration are plain array accesses, and a
+ * hash index maps keys to their slot. Remove() moves the last item into the freed slot:
+ * positions are only stable until the next Remove(), hold on to the PointerType or the key
+ * to keep track of an item.
+ */
 template < class ItemImp >
 class ContainerBase {
 public:
@@ -21,60 +28,77 @@ public:
         PointerType;
 	typedef boost::shared_ptr< const ItemType >
 		ConstPointerType;
+	typedef std::size_t
+		size_type;
 
 protected:
-	typedef std::map< const KeyType, PointerType >
-		MapType;
     typedef std::vector< PointerType >
         VectorType;
     typedef std::vector< ConstPointerType >
         ConstVectorType;
+	typedef boost::unordered_map< KeyType, size_type >
+		IndexType;
 
 public:
+    typedef typename VectorType::const_iterator
+        const_iterator;
+    typedef boost::iterator_range< const_iterator >
+        RangeType;
     //! putting this here makes it inherently distinguishable on a per *List basis
 	struct MissingItemException : public std::runtime_error {
 		MissingItemException( const KeyType& key );
-		MissingItemException( const typename MapType::size_type& idx );
+		MissingItemException( const size_type& idx );
     };
 
 public:
     ContainerBase();
 
-    void Add( PointerType item );
+    //! replaces the item with the same key, if any
+    PointerType Add( PointerType item );
     PointerType Add( ItemType* item );
 	void Remove( const KeyType& key );
 	//! throws MissingItemException if no item at \param key
 	const PointerType Get( const KeyType& key ) const;
 	PointerType Get( const KeyType& key );
+	//! like Get, but returns a null pointer if no item at \param key
+	const PointerType Find( const KeyType& key ) const;
 	bool Exists( const KeyType& key ) const;
     bool Exists( const ConstPointerType ptr ) const;
 
-    typename MapType::size_type size() const;
+    size_type size() const { return m_items.size(); }
+    void reserve( size_type count );
 
 protected:
-	typename MapType::const_iterator begin() const { return m_map.begin(); }
-	typename MapType::iterator begin() { return m_map.begin(); }
-	typename MapType::const_iterator end() const { return m_map.end(); }
-	typename MapType::iterator end() { return m_map.end(); }
-    typename MapType::const_iterator find( const KeyType& key ) const { return m_map.find( key ); }
-    typename MapType::iterator find( const KeyType& key ) { return m_map.find( key ); }
+	typename VectorType::const_iterator begin() const { return m_items.begin(); }
+	typename VectorType::iterator begin() { return m_items.begin(); }
+	typename VectorType::const_iterator end() const { return m_items.end(); }
+	typename VectorType::iterator end() { return m_items.end(); }
+    typename VectorType::const_iterator find( const KeyType& key ) const;
+    typename VectorType::iterator find( const KeyType& key );
 
 public:
-	const ConstPointerType At( const typename MapType::size_type index ) const;
-	const PointerType At( const typename MapType::size_type index );
-	const ConstPointerType operator[]( typename MapType::size_type index ) const { return At(index); }
-	const PointerType operator[]( typename MapType::size_type index ) { return At(index); }
+	//! throws MissingItemException if \param index >= size()
+	const ConstPointerType At( const size_type index ) const;
+	const PointerType At( const size_type index );
+	const ConstPointerType operator[]( size_type index ) const { return At(index); }
+	const PointerType operator[]( size_type index ) { return At(index); }
 
+    //! copies, prefer Range() unless the result has to survive an Add or Remove
     ConstVectorType Vectorize() const;
     VectorType Vectorize();
 
+    /** \brief the items in storage order, without copying them or touching their refcounts
+     * Invalidated by Add and Remove, like the vector iterators it is made of.
+     */
+    RangeType Range() const { return RangeType( m_items.begin(), m_items.end() ); }
+    //! a lazy view of the items \param pred( const PointerType& ) holds for, evaluated while iterating
+    template < class Predicate >
+    boost::filtered_range< Predicate, const RangeType > Filter( Predicate pred ) const
+        { return boost::adaptors::filter( Range(), pred ); }
 
 private:
-	MapType m_map;
-	// The following are used as internal cache to speed up random access:
-	mutable typename MapType::const_iterator m_seek;
-	mutable typename MapType::size_type m_seekpos;
-	static const typename MapType::size_type SEEKPOS_INVALID = typename MapType::size_type(-1);
+	VectorType m_items;
+	IndexType m_index;
 };
 
 } //namespace LSL
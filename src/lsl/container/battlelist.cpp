@@ -1,12 +1,15 @@
 #include "battlelist.h"
 
+#include <lslutils/conversion.h>
+
 namespace LSL {
 namespace Battle {
 
-std::string BattleList::GetChannelName( const ConstIBattlePtr /*battle*/ )
+std::string BattleList::GetChannelName( const ConstIBattlePtr battle )
 {
-    assert( false );
-    return "";
+    if ( !battle )
+        return "";
+    return "B" + Util::ToString( battle->Id() );
 }
 
 } } //namespace LSL { namespace Battle {
@@ -15,6 +15,13 @@ public:
     std::string GetChannelName( const ConstIBattlePtr battle );
 };
 
+//! Filter() predicate for battles that still take players
+struct HasFreeSlots {
+    template < class BattlePointer >
+    bool operator()( const BattlePointer& battle ) const
+        { return battle->GetNumActivePlayers() < battle->GetMaxPlayers(); }
+};
+
 } //namespace Battle
 } //namespace LSL
 
@@ -0,0 +1,184 @@
+#include "battlequery.h"
+
+#include <algorithm>
+#include <boost/foreach.hpp>
+
+namespace LSL {
+namespace Battle {
+
+BattleFilterSpec::BattleFilterSpec()
+    : max_rank_needed( -1 )
+    , show_passworded( true )
+    , show_locked( true )
+    , show_full( true )
+    , show_in_game( true )
+{
+}
+
+bool BattleFilterSpec::operator()( const IBattle& battle ) const
+{
+    if ( !show_passworded && battle.IsPassworded() )
+        return false;
+    if ( !show_locked && battle.IsLocked() )
+        return false;
+    if ( !show_in_game && battle.InGame() )
+        return false;
+    if ( !show_full && battle.GetNumActivePlayers() >= battle.GetMaxPlayers() )
+        return false;
+    if ( max_rank_needed >= 0 && battle.GetRankNeeded() > max_rank_needed )
+        return false;
+    if ( !modname.empty() && battle.GetHostModName() != modname )
+        return false;
+    if ( !mapname.empty() && battle.GetHostMapName() != mapname )
+        return false;
+    return true;
+}
+
+long SortByPlayers( const IBattle& battle )
+{
+    return battle.GetNumActivePlayers();
+}
+
+long SortByFreeSlots( const IBattle& battle )
+{
+    return long( battle.GetMaxPlayers() ) - long( battle.GetNumActivePlayers() );
+}
+
+long SortByRankNeeded( const IBattle& battle )
+{
+    return battle.GetRankNeeded();
+}
+
+BattleQuery::BattleQuery( const BattleFilter& filter, const BattleSortKey& key, bool descending, const BattleDeltaCallback& callback )
+    : m_filter( filter )
+    , m_key( key )
+    , m_descending( descending )
+    , m_callback( callback )
+{
+}
+
+int BattleQuery::IndexOf( int battle_id ) const
+{
+    boost::unordered_map<int, long>::const_iterator it = m_keys.find( battle_id );
+    if ( it == m_keys.end() )
+        return -1;
+    return m_order.IndexOf( it->second, battle_id );
+}
+
+long BattleQuery::Key( const IBattle& battle ) const
+{
+    const long key = m_key ? m_key( battle ) : 0;
+    return m_descending ? -key : key;
+}
+
+void BattleQuery::Notify( BattleDelta::Type type, const BattlePtr& battle, int from, int to ) const
+{
+    if ( m_callback )
+        m_callback( BattleDelta( type, battle, from, to ) );
+}
+
+void BattleQuery::Update( const BattlePtr& battle, bool notify )
+{
+    const int id = battle->Id();
+    const bool match = !m_filter || m_filter( *battle );
+    boost::unordered_map<int, long>::iterator it = m_keys.find( id );
+    if ( it == m_keys.end() ) {
+        if ( !match )
+            return;
+        const long key = Key( *battle );
+        m_keys[id] = key;
+        const int to = m_order.Insert( key, id, battle );
+        if ( notify )
+            Notify( BattleDelta::Inserted, battle, -1, to );
+        return;
+    }
+    if ( !match ) {
+        const int from = m_order.Erase( it->second, id );
+        m_keys.erase( it );
+        if ( notify )
+            Notify( BattleDelta::Removed, battle, from, -1 );
+        return;
+    }
+    const long key = Key( *battle );
+    if ( key == it->second ) {
+        const int at = m_order.IndexOf( key, id );
+        if ( notify )
+            Notify( BattleDelta::Changed, battle, at, at );
+        return;
+    }
+    const int from = m_order.Erase( it->second, id );
+    it->second = key;
+    const int to = m_order.Insert( key, id, battle );
+    if ( notify )
+        Notify( BattleDelta::Moved, battle, from, to );
+}
+
+void BattleQuery::Remove( int battle_id )
+{
+    boost::unordered_map<int, long>::iterator it = m_keys.find( battle_id );
+    if ( it == m_keys.end() )
+        return;
+    const int from = m_order.IndexOf( it->second, battle_id );
+    const BattlePtr battle = m_order.At( from );
+    m_order.Erase( it->second, battle_id );
+    m_keys.erase( it );
+    Notify( BattleDelta::Removed, battle, from, -1 );
+}
+
+void BattleQuery::Clear()
+{
+    //from the back, so every delta's position is still valid when it arrives
+    while ( m_order.size() > 0 )
+        Remove( At( m_order.size() - 1 )->Id() );
+}
+
+BattleQueryPtr BattleQueryEngine::Register( const BattleList& battles, const BattleFilter& filter, const BattleSortKey& key,
+                                            bool descending, const BattleDeltaCallback& callback )
+{
+    BattleQueryPtr query( new BattleQuery( filter, key, descending, callback ) );
+    BOOST_FOREACH( const BattlePtr& battle, battles.Range() )
+        query->Update( battle, false );
+    m_queries.push_back( query );
+    return query;
+}
+
+void BattleQueryEngine::Unregister( const BattleQueryPtr& query )
+{
+    m_queries.erase( std::remove( m_queries.begin(), m_queries.end(), query ), m_queries.end() );
+}
+
+void BattleQueryEngine::Touch( int battle_id )
+{
+    if ( !m_queries.empty() )
+        m_touched.insert( battle_id );
+}
+
+void BattleQueryEngine::Flush( const BattleList& battles )
+{
+    if ( m_touched.empty() )
+        return;
+    //a callback may unregister its query
+    const std::vector<BattleQueryPtr> queries( m_queries );
+    for ( boost::unordered_set<int>::const_iterator id = m_touched.begin(); id != m_touched.end(); ++id )
+    {
+        const BattlePtr battle = battles.Find( *id );
+        for ( std::vector<BattleQueryPtr>::const_iterator query = queries.begin(); query != queries.end(); ++query )
+        {
+            if ( battle )
+                ( *query )->Update( battle );
+            else
+                ( *query )->Remove( *id );
+        }
+    }
+    m_touched.clear();
+}
+
+void BattleQueryEngine::Clear()
+{
+    m_touched.clear();
+    const std::vector<BattleQueryPtr> queries( m_queries );
+    for ( std::vector<BattleQueryPtr>::const_iterator query = queries.begin(); query != queries.end(); ++query )
+        ( *query )->Clear();
+}
+
+} } //namespace LSL { namespace Battle {
@@ -0,0 +1,151 @@
+#ifndef LIBSPRINGLOBBY_HEADERGUARD_BATTLEQUERY_H
+#define LIBSPRINGLOBBY_HEADERGUARD_BATTLEQUERY_H
+
+#include "battlelist.h"
+#include "orderedindex.h"
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <string>
+#include <vector>
+
+namespace LSL {
+namespace Battle {
+
+//! one change to the result of a BattleQuery, positions are in the sorted result
+struct BattleDelta
+{
+	enum Type {
+		Inserted,
+		Removed,
+		//! the sort key changed, \ref from and \ref to may be the same
+		Moved,
+		//! something else changed, the position did not
+		Changed
+	};
+	BattleDelta( Type type, const BattlePtr& battle, int from, int to )
+		: type( type ), battle( battle ), from( from ), to( to ) {}
+	Type type;
+	BattlePtr battle;
+	//! position before the change, -1 for Inserted
+	int from;
+	//! position after the change, -1 for Removed
+	int to;
+};
+
+typedef boost::function<bool (const IBattle&)> BattleFilter;
+typedef boost::function<long (const IBattle&)> BattleSortKey;
+typedef boost::function<void (const BattleDelta&)> BattleDeltaCallback;
+
+//! the usual battle list filters in one BattleFilter, empty strings match anything
+struct BattleFilterSpec
+{
+	BattleFilterSpec();
+	bool operator()( const IBattle& battle ) const;
+	std::string modname;
+	std::string mapname;
+	//! hide battles that need a higher rank than this, -1 shows all
+	int max_rank_needed;
+	bool show_passworded;
+	bool show_locked;
+	bool show_full;
+	bool show_in_game;
+};
+
+//! BattleSortKeys
+long SortByPlayers( const IBattle& battle );
+long SortByFreeSlots( const IBattle& battle );
+long SortByRankNeeded( const IBattle& battle );
+
+/** \brief a filtered, sorted view of the battle list that is kept up to date
+ * Every change costs O(log n) and is reported as a BattleDelta, in the order applied:
+ * a list widget can replay them instead of rebuilding. Ties sort by battle id.
+ * Get one from BattleQueryEngine::Register.
+ */
+class BattleQuery
+{
+public:
+	std::size_t size() const { return m_order.size(); }
+	const BattlePtr& At( std::size_t index ) const { return m_order.At( index ); }
+	//! -1 if \param battle_id is not in the result
+	int IndexOf( int battle_id ) const;
+
+private:
+	friend class BattleQueryEngine;
+	BattleQuery( const BattleFilter& filter, const BattleSortKey& key, bool descending, const BattleDeltaCallback& callback );
+	long Key( const IBattle& battle ) const;
+	//! with \param notify false the caller is not told, used while filling a new query
+	void Update( const BattlePtr& battle, bool notify = true );
+	void Remove( int battle_id );
+	void Clear();
+	void Notify( BattleDelta::Type type, const BattlePtr& battle, int from, int to ) const;
+
+	const BattleFilter m_filter;
+	const BattleSortKey m_key;
+	const bool m_descending;
+	const BattleDeltaCallback m_callback;
+	OrderedIndex< BattlePtr > m_order;
+	//! the key each battle was sorted in with, needed to find it again
+	boost::unordered_map< int, long > m_keys;
+};
+
+typedef boost::shared_ptr< BattleQuery >
+	BattleQueryPtr;
+
+/** \brief keeps any number of BattleQuery results current
+ * The server marks battles it changed with Touch and calls Flush once a batch of
+ * protocol lines was handled, so each battle is looked at once per batch however many
+ * lines touched it. Everything here, the callbacks included, runs on the network thread.
+ */
+class BattleQueryEngine
+{
+public:
+	//! the result is filled from \param battles right away, without deltas
+	BattleQueryPtr Register( const BattleList& battles, const BattleFilter& filter, const BattleSortKey& key,
+							 bool descending, const BattleDeltaCallback& callback );
+	void Unregister( const BattleQueryPtr& query );
+
+	void Touch( int battle_id );
+	//! bring every query up to date with the touched battles in \param battles
+	void Flush( const BattleList& battles );
+	//! every query reports all its battles removed
+	void Clear();
+
+private:
+	std::vector< BattleQueryPtr > m_queries;
+	boost::unordered_set< int > m_touched;
+};
+
+} //namespace Battle
+} //namespace LSL
+
+/**
+ * \file battlequery.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LIBSPRINGLOBBY_HEADERGUARD_BATTLEQUERY_H
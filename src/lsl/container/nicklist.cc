@@ -0,0 +1,177 @@
+#include <algorithm>
+
+namespace LSL {
+
+template < class T >
+std::string NickIndexedList<T>::FoldNick( const std::string& nick )
+{
+    //lobby nicks are ASCII, no need for locale aware folding on every chat line
+    std::string folded( nick );
+    for ( std::string::iterator it = folded.begin(); it != folded.end(); ++it )
+        if ( *it >= 'A' && *it <= 'Z' )
+            *it += 'a' - 'A';
+    return folded;
+}
+
+template < class T >
+NickIndexedList<T>::NickIndexedList( const NickIndexedList& other )
+    : BaseType( other ),
+    m_nicks( other.m_nicks ),
+    m_sorted_nicks( other.m_sorted_nicks )
+{
+    WatchAll();
+}
+
+template < class T >
+NickIndexedList<T>& NickIndexedList<T>::operator=( const NickIndexedList& other )
+{
+    if ( this == &other )
+        return *this;
+    UnwatchAll();
+    BaseType::operator=( other );
+    m_nicks = other.m_nicks;
+    m_sorted_nicks = other.m_sorted_nicks;
+    WatchAll();
+    return *this;
+}
+
+template < class T >
+NickIndexedList<T>::~NickIndexedList()
+{
+    //the items may well outlive the list
+    UnwatchAll();
+}
+
+template < class T >
+void NickIndexedList<T>::WatchAll()
+{
+    for ( typename BaseType::const_iterator it = BaseType::begin(); it != BaseType::end(); ++it )
+        ( *it )->WatchNick( this );
+}
+
+template < class T >
+void NickIndexedList<T>::UnwatchAll()
+{
+    for ( typename BaseType::const_iterator it = BaseType::begin(); it != BaseType::end(); ++it )
+        ( *it )->UnwatchNick( this );
+}
+
+template < class T >
+void NickIndexedList<T>::OnNickChanged( HasNick& item, const std::string& old_nick )
+{
+    ItemType& changed = static_cast<ItemType&>( item );
+    const PointerType indexed = BaseType::Find( changed.key() );
+    if ( indexed.get() != &changed )
+        return;
+    UnindexNick( indexed, old_nick );
+    IndexNick( indexed );
+}
+
+template < class T >
+void NickIndexedList<T>::IndexNick( const PointerType& item )
+{
+    const std::string folded = FoldNick( item->Nick() );
+    m_nicks[folded] = item;
+    m_sorted_nicks[folded] = item;
+}
+
+template < class T >
+void NickIndexedList<T>::UnindexNick( const PointerType& item, const std::string& nick )
+{
+    const std::string folded = FoldNick( nick );
+    typename NickMapType::iterator it = m_nicks.find( folded );
+    //another item may have taken over the nick meanwhile
+    if ( it == m_nicks.end() || it->second != item )
+        return;
+    m_nicks.erase( it );
+    m_sorted_nicks.erase( folded );
+}
+
+template < class T >
+typename NickIndexedList<T>::PointerType NickIndexedList<T>::Add( PointerType item )
+{
+    const PointerType replaced = BaseType::Find( item->key() );
+    if ( replaced ) {
+        UnindexNick( replaced, replaced->Nick() );
+        replaced->UnwatchNick( this );
+    }
+    BaseType::Add( item );
+    IndexNick( item );
+    item->WatchNick( this );
+    return item;
+}
+
+template < class T >
+typename NickIndexedList<T>::PointerType NickIndexedList<T>::Add( ItemType* item )
+{
+    return Add( PointerType( item ) );
+}
+
+template < class T >
+void NickIndexedList<T>::Remove( const KeyType& key )
+{
+    const PointerType item = BaseType::Find( key );
+    if ( !item )
+        return;
+    UnindexNick( item, item->Nick() );
+    item->UnwatchNick( this );
+    BaseType::Remove( key );
+}
+
+template < class T >
+void NickIndexedList<T>::Rename( PointerType item, const std::string& nick )
+{
+    item->SetNick( nick );
+}
+
+template < class T >
+typename NickIndexedList<T>::PointerType NickIndexedList<T>::Lookup( const std::string& nick ) const
+{
+    const std::string folded = FoldNick( nick );
+    typename NickMapType::const_iterator it = m_nicks.find( folded );
+    if ( it == m_nicks.end() )
+        return PointerType();
+    return it->second;
+}
+
+template < class T >
+const typename NickIndexedList<T>::ConstPointerType NickIndexedList<T>::FindByNick( const std::string& nick ) const
+{
+    return Lookup( nick );
+}
+
+template < class T >
+const typename NickIndexedList<T>::PointerType NickIndexedList<T>::FindByNick( const std::string& nick )
+{
+    return Lookup( nick );
+}
+
+template < class T >
+typename NickIndexedList<T>::VectorType NickIndexedList<T>::LookupPrefix( const std::string& prefix, size_t limit ) const
+{
+    const std::string folded = FoldNick( prefix );
+    VectorType matches;
+    for ( typename SortedNickMapType::const_iterator it = m_sorted_nicks.lower_bound( folded );
+          it != m_sorted_nicks.end() && it->first.compare( 0, folded.size(), folded ) == 0; ++it )
+    {
+        matches.push_back( it->second );
+        if ( matches.size() == limit )
+            break;
+    }
+    return matches;
+}
+
+template < class T >
+typename NickIndexedList<T>::ConstVectorType NickIndexedList<T>::FindByNickPrefix( const std::string& prefix, size_t limit ) const
+{
+    const VectorType matches = LookupPrefix( prefix, limit );
+    return ConstVectorType( matches.begin(), matches.end() );
+}
+
+template < class T >
+typename NickIndexedList<T>::VectorType NickIndexedList<T>::FindByNickPrefix( const std::string& prefix, size_t limit )
+{
+    return LookupPrefix( prefix, limit );
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef LIBSPRINGLOBBY_HEADERGUARD_NICKLIST_H
+#define LIBSPRINGLOBBY_HEADERGUARD_NICKLIST_H
+
+#include "base.h"
+#include <lslutils/global_interfaces.h>
+
+#include <boost/unordered_map.hpp>
+#include <map>
+#include <string>
+
+namespace LSL {
+
+/** \brief ContainerBase for users, with a case-insensitive index of their nicks
+ * Exact lookups go through a hash map, prefix queries (nick completion) through a sorted map,
+ * both keyed by the ASCII-lowercased nick. Add/Remove keep them current, and the list watches
+ * its items (ItemImp is a HasNick) so a SetNick anywhere reindexes them.
+ */
+template < class ItemImp >
+class NickIndexedList : public ContainerBase< ItemImp >, private NickObserver {
+	typedef ContainerBase< ItemImp >
+		BaseType;
+public:
+	typedef typename BaseType::ItemType
+		ItemType;
+	typedef typename BaseType::KeyType
+		KeyType;
+	typedef typename BaseType::PointerType
+		PointerType;
+	typedef typename BaseType::ConstPointerType
+		ConstPointerType;
+	typedef typename BaseType::VectorType
+		VectorType;
+	typedef typename BaseType::ConstVectorType
+		ConstVectorType;
+
+	NickIndexedList() {}
+	NickIndexedList( const NickIndexedList& other );
+	NickIndexedList& operator=( const NickIndexedList& other );
+	~NickIndexedList();
+
+	PointerType Add( PointerType item );
+	PointerType Add( ItemType* item );
+	void Remove( const KeyType& key );
+	//! same as \param item->SetNick( \param nick )
+	void Rename( PointerType item, const std::string& nick );
+
+	//! case-insensitive
+	const ConstPointerType FindByNick( const std::string& nick ) const;
+	const PointerType FindByNick( const std::string& nick );
+	//! case-insensitive, sorted by nick; \param limit 0 returns every match
+	ConstVectorType FindByNickPrefix( const std::string& prefix, size_t limit = 0 ) const;
+	VectorType FindByNickPrefix( const std::string& prefix, size_t limit = 0 );
+
+	//! the form nicks are indexed by
+	static std::string FoldNick( const std::string& nick );
+
+private:
+	virtual void OnNickChanged( HasNick& item, const std::string& old_nick );
+	void WatchAll();
+	void UnwatchAll();
+	void IndexNick( const PointerType& item );
+	//! drops \param item from the index entry of \param nick, if it still has that entry
+	void UnindexNick( const PointerType& item, const std::string& nick );
+	PointerType Lookup( const std::string& nick ) const;
+	VectorType LookupPrefix( const std::string& prefix, size_t limit ) const;
+
+	typedef boost::unordered_map< std::string, PointerType >
+		NickMapType;
+	typedef std::map< std::string, PointerType >
+		SortedNickMapType;
+	NickMapType m_nicks;
+	SortedNickMapType m_sorted_nicks;
+};
+
+} // namespace LSL
+
+#include "nicklist.cc"
+
+#endif // LIBSPRINGLOBBY_HEADERGUARD_NICKLIST_H
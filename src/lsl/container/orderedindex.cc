@@ -0,0 +1,153 @@
+#include <stdexcept>
+
+namespace LSL {
+
+template < class V >
+OrderedIndex<V>::OrderedIndex()
+    : m_root( 0 )
+    , m_seed( 2463534242u )
+{
+}
+
+template < class V >
+OrderedIndex<V>::~OrderedIndex()
+{
+    Destroy( m_root );
+}
+
+template < class V >
+void OrderedIndex<V>::clear()
+{
+    Destroy( m_root );
+    m_root = 0;
+}
+
+template < class V >
+unsigned int OrderedIndex<V>::NextPriority()
+{
+    //xorshift, the treap only needs priorities that don't correlate with the keys
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+template < class V >
+void OrderedIndex<V>::Split( Node* node, long key, int id, Node*& left, Node*& right )
+{
+    if ( !node ) {
+        left = right = 0;
+        return;
+    }
+    if ( Before( node, key, id ) ) {
+        Split( node->right, key, id, node->right, right );
+        left = node;
+    }
+    else {
+        Split( node->left, key, id, left, node->left );
+        right = node;
+    }
+    Update( node );
+}
+
+template < class V >
+typename OrderedIndex<V>::Node* OrderedIndex<V>::Merge( Node* left, Node* right )
+{
+    if ( !left )
+        return right;
+    if ( !right )
+        return left;
+    if ( left->priority > right->priority ) {
+        left->right = Merge( left->right, right );
+        Update( left );
+        return left;
+    }
+    right->left = Merge( left, right->left );
+    Update( right );
+    return right;
+}
+
+template < class V >
+typename OrderedIndex<V>::Node* OrderedIndex<V>::EraseFrom( Node* node, long key, int id )
+{
+    if ( !node )
+        throw std::logic_error( "OrderedIndex::Erase: no such entry" );
+    if ( Less( key, id, node ) )
+        node->left = EraseFrom( node->left, key, id );
+    else if ( key != node->key || id != node->id )
+        node->right = EraseFrom( node->right, key, id );
+    else {
+        Node* merged = Merge( node->left, node->right );
+        delete node;
+        return merged;
+    }
+    Update( node );
+    return node;
+}
+
+template < class V >
+void OrderedIndex<V>::Destroy( Node* node )
+{
+    if ( !node )
+        return;
+    Destroy( node->left );
+    Destroy( node->right );
+    delete node;
+}
+
+template < class V >
+std::size_t OrderedIndex<V>::Insert( long key, int id, const V& value )
+{
+    Node* left;
+    Node* right;
+    Split( m_root, key, id, left, right );
+    const std::size_t index = Size( left );
+    m_root = Merge( Merge( left, new Node( key, id, value, NextPriority() ) ), right );
+    return index;
+}
+
+template < class V >
+std::size_t OrderedIndex<V>::Erase( long key, int id )
+{
+    const std::size_t index = IndexOf( key, id );
+    m_root = EraseFrom( m_root, key, id );
+    return index;
+}
+
+template < class V >
+std::size_t OrderedIndex<V>::IndexOf( long key, int id ) const
+{
+    std::size_t index = 0;
+    const Node* node = m_root;
+    while ( node ) {
+        if ( Less( key, id, node ) )
+            node = node->left;
+        else if ( key != node->key || id != node->id ) {
+            index += Size( node->left ) + 1;
+            node = node->right;
+        }
+        else
+            return index + Size( node->left );
+    }
+    throw std::logic_error( "OrderedIndex::IndexOf: no such entry" );
+}
+
+template < class V >
+const V& OrderedIndex<V>::At( std::size_t index ) const
+{
+    const Node* node = m_root;
+    while ( node ) {
+        const std::size_t left = Size( node->left );
+        if ( index < left )
+            node = node->left;
+        else if ( index == left )
+            return node->value;
+        else {
+            index -= left + 1;
+            node = node->right;
+        }
+    }
+    throw std::out_of_range( "OrderedIndex::At" );
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef LIBSPRINGLOBBY_HEADERGUARD_ORDEREDINDEX_H
+#define LIBSPRINGLOBBY_HEADERGUARD_ORDEREDINDEX_H
+
+#include <cstddef>
+
+namespace LSL {
+
+/** \brief a sorted sequence that also knows the position of every entry
+ * Entries are ordered by ( key, id ), ids have to be unique. Insert, Erase, At and IndexOf
+ * are all O(log n) expected: it is a treap whose nodes count their subtree.
+ */
+template < class Value >
+class OrderedIndex {
+public:
+	OrderedIndex();
+	~OrderedIndex();
+
+	//! \return the position \param value ended up at
+	std::size_t Insert( long key, int id, const Value& value );
+	//! \return the position the entry had, it has to exist
+	std::size_t Erase( long key, int id );
+	//! \return the position of an existing entry
+	std::size_t IndexOf( long key, int id ) const;
+	const Value& At( std::size_t index ) const;
+	std::size_t size() const { return Size( m_root ); }
+	void clear();
+
+private:
+	OrderedIndex( const OrderedIndex& );
+	OrderedIndex& operator=( const OrderedIndex& );
+
+	struct Node {
+		Node( long key, int id, const Value& value, unsigned int priority )
+			: key( key ), id( id ), value( value ), priority( priority ), size( 1 ), left( 0 ), right( 0 ) {}
+		long key;
+		int id;
+		Value value;
+		unsigned int priority;
+		std::size_t size;
+		Node* left;
+		Node* right;
+	};
+
+	static std::size_t Size( const Node* node ) { return node ? node->size : 0; }
+	static bool Less( long key, int id, const Node* node ) { return key < node->key || ( key == node->key && id < node->id ); }
+	static bool Before( const Node* node, long key, int id ) { return node->key < key || ( node->key == key && node->id < id ); }
+	static void Update( Node* node ) { node->size = 1 + Size( node->left ) + Size( node->right ); }
+	//! entries before ( key, id ) go to \param left, the rest to \param right
+	static void Split( Node* node, long key, int id, Node*& left, Node*& right );
+	static Node* Merge( Node* left, Node* right );
+	static Node* EraseFrom( Node* node, long key, int id );
+	static void Destroy( Node* node );
+	unsigned int NextPriority();
+
+	Node* m_root;
+	unsigned int m_seed;
+};
+
+} // namespace LSL
+
+#include "orderedindex.cc"
+
+#endif // LIBSPRINGLOBBY_HEADERGUARD_ORDEREDINDEX_H
@@ -1,24 +1,20 @@
 #ifndef LIBSPRINGLOBBY_HEADERGUARD_USERLIST_H
 #define LIBSPRINGLOBBY_HEADERGUARD_USERLIST_H
 
-#include "base.h"
+#include "nicklist.h"
 #include <lsl/user/user.h>
 
 namespace LSL {
 
-//! container for user pointers
-class UserList : public ContainerBase< User >
-{
-public:
-    const ConstUserPtr FindByNick( const std::string& nick ) const;
-    const UserPtr FindByNick( const std::string& nick );
-};
+//! container for user pointers, keyed by id and indexed by nick
+class UserList : public NickIndexedList< User > {};
+
+class CommonUserList : public NickIndexedList< CommonUser > {};
 
-class CommonUserList : public ContainerBase< CommonUser >
-{
-public:
-    const ConstCommonUserPtr FindByNick( const std::string& nick ) const;
-    const CommonUserPtr FindByNick( const std::string& nick );
+//! Filter() predicate for users currently playing
+struct IsInGame {
+    template < class UserPointer >
+    bool operator()( const UserPointer& user ) const { return user->Status().in_game; }
 };
 
 } // namespace LSL
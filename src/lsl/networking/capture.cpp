@@ -0,0 +1,94 @@
+#include "capture.h"
+
+#include <chrono>
+
+namespace LSL {
+
+static const char capture_magic[] = "LSLCAP1\n";
+static const size_t capture_magic_length = sizeof( capture_magic ) - 1;
+
+static void WriteLittleEndian( std::ofstream& file, unsigned long long value, int bytes )
+{
+    char buf[8];
+    for ( int i = 0; i < bytes; ++i )
+        buf[i] = static_cast<char>( ( value >> ( 8 * i ) ) & 0xFF );
+    file.write( buf, bytes );
+}
+
+static bool ReadLittleEndian( std::ifstream& file, unsigned long long& value, int bytes )
+{
+    unsigned char buf[8];
+    if ( !file.read( reinterpret_cast<char*>( buf ), bytes ) )
+        return false;
+    value = 0;
+    for ( int i = bytes - 1; i >= 0; --i )
+        value = ( value << 8 ) | buf[i];
+    return true;
+}
+
+unsigned long long CaptureClockMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+CaptureWriter::CaptureWriter()
+    : m_start_us( 0 )
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    Close();
+}
+
+bool CaptureWriter::Open( const std::string& filename )
+{
+    Close();
+    m_file.open( filename.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !m_file.is_open() )
+        return false;
+    m_file.write( capture_magic, capture_magic_length );
+    m_start_us = CaptureClockMicroseconds();
+    return true;
+}
+
+void CaptureWriter::Close()
+{
+    if ( m_file.is_open() )
+        m_file.close();
+}
+
+void CaptureWriter::Write( const char* data, size_t length )
+{
+    if ( !m_file.is_open() || length == 0 )
+        return;
+    WriteLittleEndian( m_file, CaptureClockMicroseconds() - m_start_us, 8 );
+    WriteLittleEndian( m_file, length, 4 );
+    m_file.write( data, length );
+}
+
+bool CaptureReader::Open( const std::string& filename )
+{
+    m_file.open( filename.c_str(), std::ios::binary | std::ios::ate );
+    m_size = m_file.tellg();
+    m_file.seekg( 0 );
+    char magic[capture_magic_length];
+    if ( !m_file.read( magic, capture_magic_length ) )
+        return false;
+    return std::string( magic, capture_magic_length ) == capture_magic;
+}
+
+bool CaptureReader::Next( CaptureRecord& record )
+{
+    unsigned long long length = 0;
+    if ( !ReadLittleEndian( m_file, record.offset_us, 8 ) || !ReadLittleEndian( m_file, length, 4 ) )
+        return false;
+    //a corrupt length must not turn into a huge allocation before the read fails
+    if ( std::streamoff( length ) > m_size - std::streamoff( m_file.tellg() ) )
+        return false;
+    record.data.resize( length );
+    return length == 0 || m_file.read( &record.data[0], length );
+}
+
+} // namespace LSL
@@ -0,0 +1,89 @@
+#ifndef LSL_CAPTURE_H
+#define LSL_CAPTURE_H
+
+#include <fstream>
+#include <string>
+
+namespace LSL {
+
+/** \brief one chunk of the inbound byte stream as it came off the socket
+ * Chunk boundaries are kept so a replay exercises the same partial lines.
+ */
+struct CaptureRecord
+{
+	//! microseconds since the capture was started
+	unsigned long long offset_us;
+	std::string data;
+};
+
+/** \brief writes the raw inbound byte stream to a file
+ * The format is a "LSLCAP1\n" header followed by records of a little endian
+ * 64bit timestamp, a 32bit length and the payload.
+ */
+class CaptureWriter
+{
+public:
+	CaptureWriter();
+	~CaptureWriter();
+
+	//! \return false if \param filename could not be opened for writing
+	bool Open( const std::string& filename );
+	void Close();
+	bool IsOpen() const { return m_file.is_open(); }
+
+	void Write( const char* data, size_t length );
+
+private:
+	std::ofstream m_file;
+	unsigned long long m_start_us;
+};
+
+//! reads files produced by CaptureWriter
+class CaptureReader
+{
+public:
+	CaptureReader() : m_size( 0 ) {}
+	//! \return false if \param filename can't be read or isn't a capture
+	bool Open( const std::string& filename );
+	//! \return false at the end of the capture or on a truncated or corrupt record
+	bool Next( CaptureRecord& record );
+
+private:
+	std::ifstream m_file;
+	//! bytes in the file, no record can be longer than what is left of it
+	std::streamoff m_size;
+};
+
+//! monotonic microseconds, only meaningful as differences
+unsigned long long CaptureClockMicroseconds();
+
+} //namespace LSL
+
+/**
+ * \file capture.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_CAPTURE_H
@@ -2,30 +2,32 @@
 
 #include <utility>
 #include <boost/shared_ptr.hpp>
+#include <boost/config.hpp>
 
 #define NEWCMD(Name,Func,...) \
-    cmd_map_[Name] = CommandFactory< __VA_ARGS__ >::make(&ServerImpl::Func, m_tas)
+    m_commands.Insert( Name, CommandFactory< __VA_ARGS__ >::make(&ServerImpl::Func, m_tas) )
 
 namespace LSL {
 
 //! mini factory to turn a given number of Tokens, a TASServer instance and a
 //! member function pointer into an actual Command instance wrapped in a shared pointer
-template <	class T0 = NoToken, class T1 = NoToken, class T2 = NoToken, class T3 = NoToken, class T4= NoToken, class T5= NoToken,
-			class T6 = NoToken, class T7 = NoToken, class T8 = NoToken, class T9 = NoToken >
+template < class... TokenTypes >
 struct CommandFactory {
-	typedef Command<T0,T1,T2,T3,T4,T5,T6,T7,T8,T9>
-		ActualCommandType;
 	typedef boost::shared_ptr< CommandBase >
 		ReturnType;
 
 	template < class F >
     static ReturnType	make(F f, ServerImpl* tas)
 	{
-		ReturnType tmp ( new ActualCommandType(f,tas) );
+		ReturnType tmp ( new Command< F, TokenTypes... >(f,tas) );
 		return tmp;
 	}
 };
 
+//! commands without parameters are registered with a single NoToken
+template <>
+struct CommandFactory< Tokens::NoToken > : public CommandFactory<> {};
+
 CommandDictionary::CommandDictionary( ServerImpl* tas )
     :m_tas(tas)
 {
@@ -36,8 +38,7 @@ CommandDictionary::CommandDictionary( ServerImpl* tas )
 	NEWCMD("ACCEPTED",OnLogin,Word);
 	NEWCMD("MOTD",OnMotd,All);
 	NEWCMD("CLIENTSTATUS",OnUserStatusChanged,Word,Int);
-	//meh on 14 args >_>
-//    NEWCMD("BATTLEOPENED",OnBattleOpened,Int,Int,Int,Word,Word,Int,Int,Int,Int,Word,Sentence,Sentence,Sentence,Sentence);
+	NEWCMD("BATTLEOPENED",OnBattleOpened,Int,Int,Int,Word,Word,Int,Int,Int,Int,Word,Sentence,Sentence,Sentence);
 	NEWCMD("JOINEDBATTLE",OnUserJoinedBattle,Int,Word,Word);
 	NEWCMD("UPDATEBATTLEINFO",OnBattleInfoUpdated,Int,Int,Int,Word,Sentence);
 	NEWCMD("LOGININFOEND",OnLoginInfoComplete,NoToken);
@@ -95,14 +96,21 @@ CommandDictionary::CommandDictionary( ServerImpl* tas )
 	NEWCMD("MUTELIST",OnMutelistItem,Word,All);
 	NEWCMD("MUTELISTEND",OnMutelistEnd,NoToken);
 	NEWCMD("OFFERFILE",OnFileDownload,Int,Sentence,Sentence,All);
+	m_commands.Build();
+}
+
+void CommandDictionary::Process( const StringRef cmd, const StringRef params ) const
+{
+	const boost::shared_ptr<CommandBase>* command = m_commands.Find( cmd );
+	if ( BOOST_LIKELY( command != NULL ) )
+		(*command)->process( params );
+	else
+		UnknownCommand( cmd, params );
 }
 
-void CommandDictionary::Process(const std::string& cmd, std::string& params ) const
+BOOST_NOINLINE void CommandDictionary::UnknownCommand( const StringRef cmd, const StringRef params )
 {
-	const MapType::const_iterator it = cmd_map_.find( cmd );
-	if ( it != cmd_map_.end() )
-		it->second->process( params );
-	LslError( "no way to process command \"%s\" with parameters %s", cmd.c_str(), params.c_str() );
+	LslError( "no way to process command \"%s\" with parameters %s", cmd.to_string().c_str(), params.to_string().c_str() );
 }
 
 } //namespace LSL {
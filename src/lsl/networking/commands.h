@@ -4,15 +4,12 @@
 #include <string>
 #include <sstream>
 #include <map>
-#include <boost/tuple/tuple.hpp>
-#include <boost/typeof/typeof.hpp>
-#include <boost/function.hpp>
+#include <utility>
 #include <boost/bind.hpp>
 
 #include <lslutils/conversion.h>
 #include "tasserver.h"
-
-namespace BT = boost::tuples;
+#include "commandtable.h"
 
 namespace LSL {
 /** \param params pre: string with N >= 0 seperators
@@ -53,7 +50,17 @@ inline std::string GetSentenceParam( std::string& params )
 inline long GetIntParam( std::string& params )
 {
 	const std::string d = GetParamByChar( params, ' ');
-	return Util::FromString<long>( d );
+	return Util::ParseLong( d.data(), d.data() + d.size() );
+}
+
+inline long ParseLong( const StringRef token )
+{
+	return Util::ParseLong( token.data(), token.data() + token.size() );
+}
+
+inline double ParseDouble( const StringRef token )
+{
+	return Util::ParseDouble( token.data(), token.data() + token.size() );
 }
 
 //! convenience wrapper around GetParamByChar for whitespace delimited booleans
@@ -62,52 +69,83 @@ inline bool GetBoolParam( std::string& params )
 	return (bool)GetIntParam( params );
 }
 
+/** \brief non-owning read position in a command's parameter string
+ * Tokens consume their part of the parameters by advancing the cursor, nothing
+ * is copied until a token converts its view into its real_type.
+ */
+class ParamCursor {
+public:
+	explicit ParamCursor( const StringRef params )
+		:m_rest( params )
+	{}
+	//! everything before the next \param sep, or the remainder if there's none
+	StringRef Next( const char sep )
+	{
+		const StringRef::size_type pos = m_rest.find( sep );
+		StringRef ret = m_rest.substr( 0, pos );
+		if ( pos == StringRef::npos )
+			m_rest.clear();
+		else
+			m_rest.remove_prefix( pos + 1 );
+		return ret;
+	}
+	StringRef Rest()
+	{
+		StringRef ret = m_rest;
+		m_rest.clear();
+		return ret;
+	}
+	bool empty() const { return m_rest.empty(); }
+
+private:
+	StringRef m_rest;
+};
+
 namespace Tokens {
 //! base class for all tokens with a call operator that yields the actual value
 template < class TypeImp >
 struct Basic {
 	typedef TypeImp
 		real_type;
-	const real_type value;
+	real_type value;
 
 	Basic( real_type v )
-		:value(v)
+		:value( std::move( v ) )
 	{}
 
 	real_type operator ()() const
 	{ return value; }
 };
+//! single whitespace delimited word
 struct Word : public Basic<std::string>{
-	Word( std::string& params )
-		:Basic<std::string>( GetWordParam( params ) ){}
+	Word( ParamCursor& params )
+		:Basic<std::string>( params.Next( ' ' ).to_string() ){}
 };
+//! tabulator delimited sentence, may contain whitespace
 struct Sentence : public Basic<std::string> {
-	Sentence( std::string& params )
-		:Basic<std::string>( GetWordParam( params ) ){}
+	Sentence( ParamCursor& params )
+		:Basic<std::string>( params.Next( '\t' ).to_string() ){}
 } ;
 struct Int : public Basic<int>{
-	Int( std::string& params )
-		:Basic<int>( GetIntParam( params ) ){}
+	Int( ParamCursor& params )
+		:Basic<int>( ParseLong( params.Next( ' ' ) ) ){}
 } ;
 struct Float: public Basic<float>{
-	Float( std::string& params )
-		:Basic<float>( GetIntParam( params ) ){}
+	Float( ParamCursor& params )
+		:Basic<float>( ParseDouble( params.Next( ' ' ) ) ){}
 } ;
 struct Double: public Basic<double>{
-	Double( std::string& params )
-		:Basic<double>( GetIntParam( params ) ){}
+	Double( ParamCursor& params )
+		:Basic<double>( ParseDouble( params.Next( ' ' ) ) ){}
 } ;
 //! this effectively ends further parsing by consuming all params
 struct All: public Basic<std::string>{
-	All( std::string& params )
-		:Basic<std::string>( params )
-	{ params = ""; }
+	All( ParamCursor& params )
+		:Basic<std::string>( params.Rest().to_string() )
+	{}
 } ;
-//struct NoToken{
-//	template < class T > NoToken( T& ){}
-//};
-
-#define NoToken boost::tuples::null_type
+//! placeholder for commands without parameters
+struct NoToken {};
 
 } //namespace Tokens
 } //namespace LSL
@@ -123,41 +161,41 @@ namespace LSL {
  * a map in CommandDictionary
  */
 struct CommandBase {
-	virtual void process( std::string& /*params*/ )
+	virtual void process( const StringRef /*params*/ )
 	{
 		assert( false ); //means we've called a non-mapped command
 	}
 };
 
 /** \brief Protocol command handler abstraction
- * encapsulate constructing and calling a given function pointer into a boost::function for
- * handling a command with max. 9 Tokens as paramters. Using Signature::call
- * automates parsing a given input string in order of the input Token Types.
+ * holds a member function pointer and the instance it's called on, handling a command
+ * with any number of Tokens as parameters. Using Signature::call automates parsing a
+ * given input string in order of the input Token Types.
+ * \tparam F the member function pointer type to be called
  * \todo should prolly be named CommandHandler instead
  **/
-template < class T0 = NoToken, class T1 = NoToken, class T2 = NoToken, class T3 = NoToken, class T4 = NoToken,
-           class T5 = NoToken, class T6 = NoToken, class T7 = NoToken, class T8 = NoToken, class T9 = NoToken>
+template < class F, class... TokenTypes >
 struct Command : public CommandBase  {
-    typedef boost::tuples::tuple<T0,T1,T2,T3,T4,T5,T6,T7,T8,T9>
-        TokenTuple;
-    typedef Signature<TokenTuple,boost::tuples::length<TokenTuple>::value>
+	typedef Signature< F, TokenTypes... >
 		SignatureType;
-	typedef typename SignatureType::Type
-		CallBackType;
-	CallBackType func;
-    /** \tparam F the member function pointer type to be called
-      * \tparam X the Tasserver type
+	typedef typename SignatureType::ClassType
+		ClassType;
+    /** \param f the member function pointer
       * \param x a TASServer type instance on which f will be called
-      * \param f the member function pointer
       */
-	template < class F, class X >
-	Command( F f, X* x)
-		:func ( SignatureType::make( f, x ) )
+	Command( F f, ClassType* x )
+		:m_func( f ),
+		m_obj( x )
 	{}
-	virtual void process( std::string& params )
+	virtual void process( const StringRef params )
 	{
-		SignatureType::call( func, params );
+		ParamCursor cursor( params );
+		SignatureType::call( m_obj, m_func, cursor );
 	}
+
+private:
+	const F m_func;
+	ClassType* const m_obj;
 };
 
 /**
@@ -170,12 +208,14 @@ private:
     CommandDictionary( ServerImpl* tas );
 
     ServerImpl* m_tas;
-	typedef std::map<std::string,boost::shared_ptr<CommandBase> >
-		MapType;
-	MapType cmd_map_;
+	typedef CommandTable<boost::shared_ptr<CommandBase> >
+		TableType;
+	TableType m_commands;
+
+	static void UnknownCommand( const StringRef cmd, const StringRef params );
 
 public:
-	void Process(const std::string& cmd, std::string& params ) const;
+	void Process( const StringRef cmd, const StringRef params ) const;
 };
 
 } //namespace LSL
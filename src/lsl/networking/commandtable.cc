@@ -0,0 +1,90 @@
+#include <cstring>
+#include <assert.h>
+
+namespace LSL {
+
+template < class T >
+CommandTable<T>::CommandTable()
+	: m_seed( 0 )
+	, m_mask( 0 )
+{
+}
+
+template < class T >
+void CommandTable<T>::Insert( const std::string& name, const T& value )
+{
+	assert( m_index.empty() );
+	for ( size_t i = 0; i < m_entries.size(); ++i )
+	{
+		//re-registering a name replaces the handler, like map::operator[] did
+		if ( m_entries[i].first == name )
+		{
+			m_entries[i].second = value;
+			return;
+		}
+	}
+	assert( m_entries.size() < 0xFFFF );
+	m_entries.push_back( EntryType( name, value ) );
+}
+
+template < class T >
+void CommandTable<T>::Build()
+{
+	//~8 slots per name finds a collision free seed after a handful of tries
+	size_t index_size = 64;
+	while ( index_size < m_entries.size() * 8 )
+		index_size *= 2;
+	for ( ;; index_size *= 2 )
+	{
+		for ( unsigned int seed = 1; seed < 4096; ++seed )
+		{
+			if ( TrySeed( seed, index_size ) )
+				return;
+		}
+	}
+}
+
+template < class T >
+bool CommandTable<T>::TrySeed( unsigned int seed, size_t index_size )
+{
+	m_index.assign( index_size, 0 );
+	for ( size_t i = 0; i < m_entries.size(); ++i )
+	{
+		unsigned short& slot = m_index[Hash( m_entries[i].first, seed ) & ( index_size - 1 )];
+		if ( slot != 0 )
+			return false;
+		slot = static_cast<unsigned short>( i + 1 );
+	}
+	m_seed = seed;
+	m_mask = index_size - 1;
+	return true;
+}
+
+template < class T >
+unsigned int CommandTable<T>::Hash( const StringRef name, unsigned int seed )
+{
+	//FNV-1a, the seed only perturbs the offset basis
+	unsigned int h = 2166136261u ^ ( seed * 0x9E3779B9u );
+	for ( StringRef::const_iterator it = name.begin(); it != name.end(); ++it )
+	{
+		h ^= static_cast<unsigned char>( *it );
+		h *= 16777619u;
+	}
+	return h ^ ( h >> 15 );
+}
+
+template < class T >
+const T* CommandTable<T>::Find( const StringRef name ) const
+{
+	if ( m_index.empty() )
+		return NULL;
+	const unsigned short pos = m_index[Hash( name, m_seed ) & m_mask];
+	if ( pos == 0 )
+		return NULL;
+	const EntryType& entry = m_entries[pos - 1];
+	if ( entry.first.size() != name.size() || std::memcmp( entry.first.data(), name.data(), name.size() ) != 0 )
+		return NULL;
+	return &entry.second;
+}
+
+} //namespace LSL
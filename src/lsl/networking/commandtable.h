@@ -0,0 +1,76 @@
+#ifndef LSL_COMMANDTABLE_H
+#define LSL_COMMANDTABLE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "lineframer.h"
+
+namespace LSL {
+
+/** \brief lookup table for protocol command names
+ * All names are inserted once, Build() then searches a seed for which the name hash
+ * maps every command to its own slot. A lookup is one hash, one index load and one
+ * compare, with no string allocation for the probed name.
+ */
+template < class ValueType >
+class CommandTable {
+public:
+	CommandTable();
+
+	//! only valid before Build()
+	void Insert( const std::string& name, const ValueType& value );
+	void Build();
+	//! \return NULL for unknown names
+	const ValueType* Find( const StringRef name ) const;
+
+	size_t size() const { return m_entries.size(); }
+	//! number of index slots, mostly of interest for benchmarks
+	size_t IndexSize() const { return m_index.size(); }
+
+private:
+	bool TrySeed( unsigned int seed, size_t index_size );
+	static unsigned int Hash( const StringRef name, unsigned int seed );
+
+	typedef std::pair< std::string, ValueType >
+		EntryType;
+	std::vector< EntryType > m_entries;
+	//! 1-based position in m_entries, 0 marks an empty slot
+	std::vector< unsigned short > m_index;
+	unsigned int m_seed;
+	size_t m_mask;
+};
+
+} //namespace LSL
+
+#include "commandtable.cc"
+
+/**
+ * \file commandtable.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_COMMANDTABLE_H
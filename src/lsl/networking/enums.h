@@ -19,6 +19,15 @@ enum SocketError
   SE_Connect_Host_Failed
 };
 
+//! outgoing lanes, lower values are written first when the send rate limit kicks in
+enum SendPriority
+{
+  SP_Urgent,  //!< PING and other keepalive traffic
+  SP_Normal,  //!< chat and regular commands
+  SP_Bulk,    //!< script tags, start rects, unit restrictions
+  SP_Count
+};
+
 typedef int Protocolerror;
 
 } //namespace Enum {
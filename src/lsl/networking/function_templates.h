@@ -3,243 +3,67 @@
 
 /* BEWARE, this file is included in the middle of commands.h */
 
-#define PARSED_VAR(idx) BOOST_AUTO(t ## idx,  (typename boost::tuples::element<idx,Tuple>::type( params )() ) )
+#include <tuple>
+#include <type_traits>
 
 namespace LSL {
 
-/** This is the generic Signature with no specialization. No instances of it can
- * be created. If you're trying to you're hitting the current max tuple length.
- * Given a tuple of LSL::Tokens::Basic derivatives this provides a factory method
- * to get a boost::function with each Token's real_type as call args. The "call"
- * function provides a way fitting boost::function with automagically
- * parsing an input string through the given Token Tuple.
- * \tparam Tuple
- * \note since the engine won't depend on availability of c++0x we're limited to 9 args for now
+//! compile time list of tuple indices, std::index_sequence is c++14
+template < size_t... I >
+struct Indices {};
+template < size_t N, size_t... I >
+struct MakeIndices : MakeIndices< N - 1, N - 1, I... > {};
+template < size_t... I >
+struct MakeIndices< 0, I... > { typedef Indices< I... > type; };
+
+//! a parsed token whose type matches the handler's argument is passed by reference
+template < class Arg, class Value >
+inline typename std::enable_if< std::is_same< typename std::decay< Arg >::type, Value >::value, const Value& >::type
+ArgumentCast( const Value& value )
+{
+	return value;
+}
+
+//! everything else (enums, bool, unsigned ports) gets converted
+template < class Arg, class Value >
+inline typename std::enable_if< !std::is_same< typename std::decay< Arg >::type, Value >::value, typename std::decay< Arg >::type >::type
+ArgumentCast( const Value& value )
+{
+	return static_cast< typename std::decay< Arg >::type >( value );
+}
+
+/** Given a member function pointer type and the Tokens its arguments are read from
+ * this provides parsing an input string in order of the Tokens straight into the
+ * handler's argument list. There's no limit on the number of Tokens.
+ * \tparam F member function pointer type of the handler
+ * \tparam TokenTypes LSL::Tokens::Basic derivatives, one per handler argument
  **/
-template < class Tuple, int p_count >
-struct Signature{};
+template < class F, class... TokenTypes >
+struct Signature;
 
-//! specialization for 9 Tokens
-template < class Tuple >
-struct Signature<Tuple,9> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&,
-								   const typename BT::element<3,Tuple>::type::real_type&,
-								   const typename BT::element<4,Tuple>::type::real_type&,
-								   const typename BT::element<5,Tuple>::type::real_type&,
-								   const typename BT::element<6,Tuple>::type::real_type&,
-								   const typename BT::element<7,Tuple>::type::real_type&,
-								   const typename BT::element<8,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x, _1, _2, _3, _4, _5, _6, _7, _8, _9 ) );
-	}
-	static void call( Type& func, std::string& params )
-	{
-		PARSED_VAR(0);
-		PARSED_VAR(1);PARSED_VAR(2);
-		PARSED_VAR(3);PARSED_VAR(4);
-		PARSED_VAR(5);PARSED_VAR(6);
-		PARSED_VAR(7);PARSED_VAR(8);
-		func( t0, t1, t2, t3, t4, t5, t6, t7, t8 );
-	}
-};
-
-//! specialization for 8 Tokens
-template < class Tuple >
-struct Signature<Tuple,8> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&,
-								   const typename BT::element<3,Tuple>::type::real_type&,
-								   const typename BT::element<4,Tuple>::type::real_type&,
-								   const typename BT::element<5,Tuple>::type::real_type&,
-								   const typename BT::element<6,Tuple>::type::real_type&,
-								   const typename BT::element<7,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x, _1, _2, _3, _4, _5, _6, _7, _8 ) );
-	}
-	static void call( Type& func, std::string& params )
-	{
-		PARSED_VAR(0);
-		PARSED_VAR(1);PARSED_VAR(2);
-		PARSED_VAR(3);PARSED_VAR(4);
-		PARSED_VAR(5);PARSED_VAR(6);
-		PARSED_VAR(7);
-		func( t0, t1, t2, t3, t4, t5, t6, t7 );
-	}
-};
-
-//! specialization for 7 Tokens
-template < class Tuple >
-struct Signature<Tuple,7> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&,
-								   const typename BT::element<3,Tuple>::type::real_type&,
-								   const typename BT::element<4,Tuple>::type::real_type&,
-								   const typename BT::element<5,Tuple>::type::real_type&,
-								   const typename BT::element<6,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x, _1, _2, _3, _4, _5, _6, _7 ) );
-	}
-	static void call( Type& func, std::string& params )
-	{
-		PARSED_VAR(0);
-		PARSED_VAR(1);PARSED_VAR(2);
-		PARSED_VAR(3);PARSED_VAR(4);
-		PARSED_VAR(5);PARSED_VAR(6);
-		func( t0, t1, t2, t3, t4, t5, t6 );
-	}
-};
-
-//! specialization for 6 Tokens
-template < class Tuple >
-struct Signature<Tuple,6> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&,
-								   const typename BT::element<3,Tuple>::type::real_type&,
-								   const typename BT::element<4,Tuple>::type::real_type&,
-								   const typename BT::element<5,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x, _1, _2, _3, _4, _5, _6 ) );
-	}
-	static void call( Type& func, std::string& params )
-	{
-		PARSED_VAR(0);
-		PARSED_VAR(1);PARSED_VAR(2);
-		PARSED_VAR(3);PARSED_VAR(4);
-		PARSED_VAR(5);
-		func( t0, t1, t2, t3, t4, t5 );
-	}
-};
-
-//! specialization for 5 Tokens
-template < class Tuple >
-struct Signature<Tuple,5> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&,
-								   const typename BT::element<3,Tuple>::type::real_type&,
-								   const typename BT::element<4,Tuple>::type::real_type&) > Type; //call traits ftw
-    template < class F, class T >
-    static Type make( F f, T* x )
-    {
-        return Type( boost::bind( f, x, _1, _2, _3, _4, _5 ) );
-    }
-    static void call( Type& func, std::string& params )
-    {
-		PARSED_VAR(0);
-		PARSED_VAR(1);PARSED_VAR(2);
-		PARSED_VAR(3);PARSED_VAR(4);
-		func( t0, t1, t2, t3, t4 );
-    }
-};
+template < class Class, class... Args, class... TokenTypes >
+struct Signature< void (Class::*)( Args... ), TokenTypes... > {
+	static_assert( sizeof...( Args ) == sizeof...( TokenTypes ), "handler arity doesn't match the number of Tokens" );
+	typedef Class
+		ClassType;
+	typedef void (Class::*Type)( Args... );
 
-//! specialization for 4 Tokens
-template < class Tuple >
-struct Signature<Tuple,4> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&,
-								   const typename BT::element<3,Tuple>::type::real_type&) > Type; //call traits ftw
-    template < class F, class T >
-    static Type make( F f, T* x )
-    {
-        return Type( boost::bind( f, x, _1, _2, _3, _4 ) );
-    }
-
-    static void call( Type& func, std::string& params )
-    {
-		PARSED_VAR(0);PARSED_VAR(1);
-		PARSED_VAR(2);PARSED_VAR(3);
-		func( t0, t1, t2, t3 );
-    }
-};
-
-//! specialization for 3 Tokens
-template < class Tuple >
-struct Signature<Tuple,3> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&,
-								   const typename BT::element<2,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
+	static void call( Class* obj, Type func, ParamCursor& params )
 	{
-		return Type( boost::bind( f, x, _1, _2, _3 ) );
+		Invoke( obj, func, params, typename MakeIndices< sizeof...( TokenTypes ) >::type() );
 	}
 
-	static void call( Type& func, std::string& params )
+private:
+	template < size_t... I >
+	static void Invoke( Class* obj, Type func, ParamCursor& params, Indices< I... > )
 	{
-		PARSED_VAR(0);PARSED_VAR(1);
-		PARSED_VAR(2);
-		func( t0, t1, t2 );
+		(void)params;
+		//braced initialisation guarantees the Tokens consume params left to right
+		std::tuple< TokenTypes... > parsed{ TokenTypes( params )... };
+		(obj->*func)( ArgumentCast< Args >( std::get< I >( parsed ).value )... );
 	}
 };
 
-//! specialization for 2 Tokens
-template < class Tuple >
-struct Signature<Tuple,2> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&,
-								   const typename BT::element<1,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x, _1, _2 ) );
-	}
-
-	static void call( Type& func, std::string& params )
-	{
-		PARSED_VAR(0);PARSED_VAR(1);
-		func( t0, t1 );
-	}
-};
-
-//! specialization for 1 Token
-template < class Tuple >
-struct Signature<Tuple,1> {
-	typedef boost::function< void (const typename BT::element<0,Tuple>::type::real_type&) > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x, _1 ) );
-	}
-
-	static void call( Type& func, std::string& params )
-	{
-		PARSED_VAR(0);
-		func( t0 );
-	}
-};
-
-//! specialization for no Tokens
-template < class Tuple >
-struct Signature<Tuple,0> {
-	typedef boost::function< void () > Type; //call traits ftw
-	template < class F, class T >
-	static Type make( F f, T* x )
-	{
-		return Type( boost::bind( f, x ) );
-	}
-
-    //string param is empty
-    static void call( Type& func, std::string& params )
-	{
-        assert(params.empty());
-        func();
-	}
-};
-
-
 } // namespace LSL {
 
 /**
@@ -7,10 +7,17 @@
 #include <lsl/battle/ibattle.h>
 #include <lsl/user/user.h>
 
+#include <lslutils/debug.h>
+
 #include <boost/typeof/typeof.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
 
+//! commands from other threads are queued for the network thread, which owns the server state
+#define RUN_ON_NETWORK_THREAD(task) do { if ( !m_impl->m_sock->InNetworkThread() ) { m_impl->m_sock->Post( task ); return; } } while (0)
+//! queries can't be queued, they race with the network thread if made elsewhere, say so but carry on
+#define WARN_OFF_NETWORK_THREAD() do { if ( !m_impl->m_sock->InNetworkThread() ) { \
+	LslWarning( "Server::%s called off the network thread, use GetSnapshot or Server::Post", __FUNCTION__ ); } } while (0)
 
 namespace LSL {
 
@@ -27,10 +34,15 @@ Server::~Server()
     delete m_impl->m_sock;
 }
 
-void Server::Connect( const std::string& /*servername */,const std::string& addr, const int port )
+void Server::Post( const boost::function<void ()>& task )
+{
+    m_impl->m_sock->Post( task );
+}
+
+void Server::Connect( const std::string& servername, const std::string& addr, const int port )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::Connect, this, servername, addr, port ) );
     m_impl->m_buffer = "";
-    m_impl->m_sock->Connect( addr, port );
     m_impl->m_sock->SetSendRateLimit( m_impl-> m_server_rate_limit );
     m_impl->m_connected = false;
     m_impl->m_online = false;
@@ -39,10 +51,13 @@ void Server::Connect( const std::string& /*servername */,const std::string& addr
     m_impl->m_crc.ResetCRC();
     std::string handle = m_impl->m_sock->GetHandle();
     if ( handle.length() > 0 ) m_impl->m_crc.UpdateData( handle + addr );
+    //the socket's network thread may report back before this returns
+    m_impl->m_sock->Connect( addr, port );
 }
 
 void Server::Disconnect(const std::string& reason)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::Disconnect, this, reason ) );
     if ( !m_impl->m_connected )
     {
         return;
@@ -53,6 +68,7 @@ void Server::Disconnect(const std::string& reason)
 
 bool Server::IsOnline() const
 {
+    WARN_OFF_NETWORK_THREAD();
     if ( !m_impl->m_connected ) return false;
     return m_impl->m_online;
 }
@@ -64,6 +80,8 @@ bool Server::IsConnected()
 
 void Server::TimerUpdate()
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::TimerUpdate, this ) );
+    m_impl->m_requests.Expire( RequestTracker::Now() );
 	if ( !IsConnected() )
 		return;
     if ( m_impl->m_sock->InTimeout( m_impl->m_ping_timeout ) )
@@ -108,28 +126,54 @@ void Server::TimerUpdate()
 
 void Server::SayChannel(const ChannelPtr channel, const std::string &msg)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SayChannel, this, channel, msg ) );
     m_impl->SayChannel( channel->Name(), msg );
 }
 
-void Server::HandlePong( int replyid )
+namespace {
+void FulfillRequestPromise( boost::shared_ptr<boost::promise<RequestReply> > promise, const RequestReply& reply )
 {
-    PingList& pinglist = m_impl->GetPingList();
-	PingList::iterator itor = pinglist.find(replyid);
-	if ( itor != pinglist.end() )
-	{
-		sig_Pong( time(0) - itor->second );
-		pinglist.erase( itor );
-    }
+    promise->set_value( reply );
+}
+}
+
+int Server::Request( const std::string& cmd, const std::string& params, const RequestCallback& callback, int timeout_ms )
+{
+    WARN_OFF_NETWORK_THREAD();
+    return m_impl->SendCmd( cmd, params, callback, timeout_ms );
+}
+
+boost::unique_future<RequestReply> Server::Request( const std::string& cmd, const std::string& params, int timeout_ms )
+{
+    boost::shared_ptr<boost::promise<RequestReply> > promise( new boost::promise<RequestReply>() );
+    boost::unique_future<RequestReply> reply = promise->get_future();
+    const RequestCallback callback = boost::bind( &FulfillRequestPromise, promise, _1 );
+    //the id isn't needed here, the request can wait for the network thread
+    int (Server::*request)( const std::string&, const std::string&, const RequestCallback&, int ) = &Server::Request;
+    Post( boost::bind( request, this, cmd, params, callback, timeout_ms ) );
+    return boost::move( reply );
+}
+
+RttStatistics Server::GetRequestStatistics() const
+{
+    return m_impl->m_requests.GetStatistics();
+}
+
+size_t Server::GetOutstandingRequests() const
+{
+    return m_impl->m_requests.Outstanding();
 }
 
 void Server::JoinChannel( const std::string& channel, const std::string& key )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::JoinChannel, this, channel, key ) );
     m_impl->m_channel_pw[channel] = key;
     m_impl->JoinChannel(channel,key);
 }
 
 UserPtr Server::AcquireRelayhost()
 {
+    WARN_OFF_NETWORK_THREAD();
     const unsigned int numbots = m_impl->m_relay_masters.size();
 	if ( numbots > 0 )
 	{
@@ -144,6 +188,7 @@ UserPtr Server::AcquireRelayhost()
 
 void Server::OpenBattle( Battle::BattleOptions bo )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::OpenBattle, this, bo ) );
 	if ( bo.userelayhost )
 	{
 		AcquireRelayhost();
@@ -164,6 +209,7 @@ std::string Server::GenerateScriptPassword() const
 
 void Server::JoinBattle( const IBattlePtr battle, const std::string& password )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::JoinBattle, this, battle, password ) );
 	if (battle)
 	{
 		if ( battle->GetNatType() == Enum::NAT_Hole_punching
@@ -182,24 +228,28 @@ void Server::JoinBattle( const IBattlePtr battle, const std::string& password )
 
 void Server::SayBattle(const IBattlePtr battle, const std::string &msg)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SayBattle, this, battle, msg ) );
     if( battle )
         m_impl->SayBattle( battle->Id(), msg );
 }
 
 void Server::DoActionBattle(const IBattlePtr battle, const std::string &msg)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::DoActionBattle, this, battle, msg ) );
     if(battle)
         m_impl->DoActionBattle(battle->Id(), msg);
 }
 
 void Server::Ring(const ConstCommonUserPtr user)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::Ring, this, user ) );
     if(user)
         m_impl->Ring( user );
 }
 
 void Server::StartHostedBattle()
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::StartHostedBattle, this ) );
     if ( !m_impl->m_current_battle ) return;
     if ( !m_impl->m_current_battle ->IsFounderMe()) return;
     if ( m_impl->m_current_battle->GetNatType() == Enum::NAT_Hole_punching
@@ -217,6 +267,7 @@ void Server::StartHostedBattle()
 
 void Server::LeaveBattle( const IBattlePtr battle)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::LeaveBattle, this, battle ) );
     if(!battle)
         return;
     m_impl->m_relay_host_bot = UserPtr();
@@ -225,6 +276,7 @@ void Server::LeaveBattle( const IBattlePtr battle)
 
 void Server::AddBot(const IBattlePtr battle, const std::string& nick, UserBattleStatus& status )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::AddBot, this, battle, nick, status ) );
     if (!battle) return;
 
     UTASBattleStatus tasbs;
@@ -236,12 +288,13 @@ void Server::AddBot(const IBattlePtr battle, const std::string& nick, UserBattle
     tascl.color.zero = 0;
     //ADDBOT name battlestatus teamcolor {AIDLL}
     std::string ailib;
-    ailib += status.aishortname; // + "|" + status.aiversion;
+    ailib += status.Extras().aishortname; // + "|" + status.Extras().aiversion;
     m_impl->SendCmd( "ADDBOT", nick + Util::ToString(tasbs.data) + " " + Util::ToString( tascl.data ) + " " + ailib );
 }
 
 void Server::RemoveBot( const IBattlePtr battle, const CommonUserPtr user )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::RemoveBot, this, battle, user ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -253,6 +306,7 @@ void Server::RemoveBot( const IBattlePtr battle, const CommonUserPtr user )
 
 void Server::UpdateBot( const IBattlePtr battle, const CommonUserPtr bot, const UserBattleStatus& status )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::UpdateBot, this, battle, bot, status ) );
     if (!battle) return;
     if (!bot) return;
     if (!status.IsBot()) return;
@@ -295,25 +349,32 @@ UserVector Server::GetAvailableRelayHostList()
 
 void Server::SetRelayIngamePassword( const CommonUserPtr user )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SetRelayIngamePassword, this, user ) );
 	if (!user) return;
     if ( !m_impl->m_current_battle ) return;
     if ( !m_impl->m_current_battle ->InGame() ) return;
-        m_impl->RelayCmd( "SETINGAMEPASSWORD", user->Nick() + " " + user->BattleStatus().scriptPassword );
+        m_impl->RelayCmd( "SETINGAMEPASSWORD", user->Nick() + " " + user->BattleStatus().Extras().scriptPassword );
 }
 
 int Server::RelayScriptSendETA(const std::string& script)
 {
+    WARN_OFF_NETWORK_THREAD();
     const StringVector strings = Util::StringTokenize( script, "\n");
     int relaylengthprefix = 10 + 1 + m_impl->m_relay_host_bot->Nick().length() + 2; // SAYPRIVATE + space + botname + space + exclamation mark length
 	int length = script.length();
 	length += relaylengthprefix + 11 + 1; // CLEANSCRIPT command size
 	length += strings.size() * ( relaylengthprefix + 16 + 1 ); // num lines * APPENDSCRIPTLINE + space command size ( \n is already counted in script.size)
 	length += relaylengthprefix + 9 + 1; // STARTGAME command size
-    return length / m_impl->m_sock->GetSendRateLimit(); // calculate time in seconds to upload script
+	const int rate = m_impl->m_sock->GetSendRateLimit();
+	if ( rate <= 0 )
+		return 0;
+	length += m_impl->m_sock->GetQueuedBytes(); // whatever is queued already goes out first
+    return length / rate; // calculate time in seconds to upload script
 }
 
 void Server::SendScriptToProxy( const std::string& script )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SendScriptToProxy, this, script ) );
     const StringVector strings = Util::StringTokenize( script, "\n" );
     m_impl->RelayCmd( "CLEANSCRIPT" );
 	for (StringVector::const_iterator itor; itor != strings.end(); ++itor)
@@ -391,8 +452,8 @@ void Server::UdpPingAllClients()
 		if (!user)
 			continue;
 		const UserBattleStatus& status = user->BattleStatus();
-        const std::string ip = status.ip;
-        unsigned int port = status.udpport;
+        const std::string ip = status.Extras().ip;
+        unsigned int port = status.Extras().udpport;
         const unsigned int src_port = m_impl->m_udp_private_port;
         if ( m_impl->m_current_battle->GetNatType() == Enum::NAT_Fixed_source_ports )
 		{
@@ -415,11 +476,13 @@ void Server::OnSocketConnected(bool connection_ok, const std::string& msg)
     assert( connection_ok );//add proper error handling
     m_impl->m_connected = connection_ok;
     m_impl->m_online = false;
+    m_impl->m_ingesting_login = false;
+    m_impl->m_snapshots.Clear();
+    m_impl->m_battle_queries.Clear();
     m_impl->m_last_udp_ping = 0;
     m_impl->m_min_required_spring_ver = "";
     m_impl->m_relay_masters.clear();
-    m_impl->GetLastPingID() = 0;
-    m_impl->GetPingList().clear();
+    m_impl->m_requests.FailAll( "disconnected" );
 }
 
 void Server::OnDisconnected()
@@ -433,8 +496,9 @@ void Server::OnDisconnected()
     m_impl->m_last_denied = "";
     m_impl->m_min_required_spring_ver = "";
     m_impl->m_relay_masters.clear();
-    m_impl->GetLastPingID() = 0;
-    m_impl->GetPingList().clear();
+    m_impl->m_requests.FailAll( "disconnected" );
+    m_impl->m_snapshots.Clear();
+    m_impl->m_battle_queries.Clear();
 	// delete all users, battles, channels
 	sig_Disconnected( connectionwaspresent );
 }
@@ -470,7 +534,6 @@ void Server::OnNewUser( const UserPtr user )
 void Server::OnUserStatus( const UserPtr user, UserStatus status )
 {
 	if ( !user ) return;
-    UserStatus oldStatus = user->Status();
 	user->SetStatus( status );
 	//TODO: event
 }
@@ -532,13 +595,13 @@ void Server::OnBattleOpened(const IBattlePtr battle )
 	}
 }
 
-void Server::OnBattleMapChanged(const IBattlePtr battle, UnitsyncMap map)
+void Server::OnBattleMapChanged(const IBattlePtr battle, const UnitsyncMap& map)
 {
 	if (!battle) return;
 	battle->SetHostMap( map.name, map.hash );
 }
 
-void Server::OnBattleModChanged( const IBattlePtr battle, UnitsyncMod mod )
+void Server::OnBattleModChanged( const IBattlePtr battle, const UnitsyncMod& mod )
 {
 	if (!battle) return;
 	battle->SetHostMod( mod.name, mod.hash );
@@ -553,7 +616,7 @@ void Server::OnBattleMaxPlayersChanged( const IBattlePtr battle, int maxplayers
 void Server::OnBattleHostChanged( const IBattlePtr battle, UserPtr host, const std::string& ip, int port )
 {
 	if (!battle) return;
-    if (!host) battle->SetFounder( host->Nick() );
+    if (host) battle->SetFounder( host->Nick() );
 	battle->SetHostIp( ip );
 	battle->SetHostPort( port );
 }
@@ -597,7 +660,9 @@ void Server::OnUserLeftBattle(const IBattlePtr battle, const CommonUserPtr user)
 {
 	if (!user) return;
 	//bool isbot = user->BattleStatus().IsBot();
-	user->BattleStatus().scriptPassword.clear();
+	//most users never had a password, don't allocate extras just to clear one
+	if ( !user->BattleStatus().Extras().scriptPassword.empty() )
+		user->BattleStatus().MutableExtras().scriptPassword.clear();
 	if (!battle) return;
 	battle->OnUserRemoved( user );
     if (user == m_impl->m_me)
@@ -763,13 +828,13 @@ void Server::OnUserInternalUdpPort( const CommonUserPtr user, int udpport )
 void Server::OnUserExternalUdpPort( const CommonUserPtr user, int udpport )
 {
 	if (!user) return;
-    user->BattleStatus().udpport = udpport;
+    user->BattleStatus().MutableExtras().udpport = udpport;
 }
 
 void Server::OnUserIP( const CommonUserPtr user, const std::string& ip )
 {
 	if (!user) return;
-	user->BattleStatus().ip = ip;
+	user->BattleStatus().MutableExtras().ip = ip;
 }
 
 void Server::OnChannelJoinUserList( const ChannelPtr channel, const UserVector& users)
@@ -796,7 +861,8 @@ void Server::OnRequestBattleStatus(IBattlePtr battle)
 
 void Server::OnUserScriptPassword(const CommonUserPtr user, const std::string &pw)
 {
-    assert( false );
+	if (!user) return;
+	user->BattleStatus().MutableExtras().scriptPassword = pw;
 }
 
 void Server::OnBattleHostchanged(IBattlePtr battle, int udpport)
@@ -814,41 +880,49 @@ int Server::GetNextAvailableID()
 
 void Server::SayPrivate( const ConstCommonUserPtr user, const std::string& msg )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SayPrivate, this, user, msg ) );
     m_impl->SayPrivate( user->Nick(), msg );
 }
 
 void Server::DoActionPrivate(const ConstCommonUserPtr user, const std::string& msg )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::DoActionPrivate, this, user, msg ) );
     m_impl->DoActionPrivate( user->Nick(), msg );
 }
 
 void Server::SendHostInfo(Enum::HostInfo update)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( static_cast<void (Server::*)(Enum::HostInfo)>( &Server::SendHostInfo ), this, update ) );
     m_impl->SendHostInfo(update);
 }
 
 void Server::SendHostInfo(const std::string &key)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( static_cast<void (Server::*)(const std::string&)>( &Server::SendHostInfo ), this, key ) );
     m_impl->SendHostInfo(key);
 }
 
 void Server::RemoveUser(const CommonUserPtr user)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::RemoveUser, this, user ) );
     m_impl->m_users.Remove( user->key() );
 }
 
 void Server::RemoveChannel(const ChannelPtr chan)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::RemoveChannel, this, chan ) );
     m_impl->m_channels.Remove( chan->key() );
 }
 
 void Server::RemoveBattle(const IBattlePtr battle)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::RemoveBattle, this, battle ) );
     m_impl->m_battles.Remove( battle->key() );
 }
 
 void Server::SendMyBattleStatus( const UserBattleStatus& bs )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SendMyBattleStatus, this, bs ) );
     UTASBattleStatus tasbs;
     tasbs.tasdata = ConvTasbattlestatus( bs );
     UTASColor tascl;
@@ -862,6 +936,7 @@ void Server::SendMyBattleStatus( const UserBattleStatus& bs )
 
 void Server::SendMyUserStatus()
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SendMyUserStatus, this ) );
     const UserStatus& us = GetMe()->Status();
     UTASClientStatus taus;
     taus.tasdata.in_game = us.in_game;
@@ -874,6 +949,7 @@ void Server::SendMyUserStatus()
 
 void Server::ForceSide( const IBattlePtr battle, const CommonUserPtr user, int side )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::ForceSide, this, battle, user, side ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -894,6 +970,7 @@ void Server::ForceSide( const IBattlePtr battle, const CommonUserPtr user, int s
 
 void Server::ForceTeam( const IBattlePtr battle, const CommonUserPtr user, int team )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::ForceTeam, this, battle, user, team ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -917,6 +994,7 @@ void Server::ForceTeam( const IBattlePtr battle, const CommonUserPtr user, int t
 
 void Server::ForceAlly( const IBattlePtr battle, const CommonUserPtr user, int ally )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::ForceAlly, this, battle, user, ally ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -942,6 +1020,7 @@ void Server::ForceAlly( const IBattlePtr battle, const CommonUserPtr user, int a
 
 void Server::ForceColor(const IBattlePtr battle, const CommonUserPtr user, const lslColor& rgb)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::ForceColor, this, battle, user, rgb ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -971,6 +1050,7 @@ void Server::ForceColor(const IBattlePtr battle, const CommonUserPtr user, const
 
 void Server::ForceSpectator( const IBattlePtr battle, const CommonUserPtr user, bool spectator )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::ForceSpectator, this, battle, user, spectator ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -995,6 +1075,7 @@ void Server::ForceSpectator( const IBattlePtr battle, const CommonUserPtr user,
 
 void Server::BattleKickPlayer( const IBattlePtr battle, const CommonUserPtr user )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::BattleKickPlayer, this, battle, user ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -1014,7 +1095,7 @@ void Server::BattleKickPlayer( const IBattlePtr battle, const CommonUserPtr user
     if( !m_impl->m_current_battle->IsProxy() )
     {
         // reset his password to something random, so he can't rejoin
-        user->BattleStatus().scriptPassword = (boost::format("%04x%04x") % (rand()&0xFFFF) % (rand()&0xFFFF) ).str();
+        user->BattleStatus().MutableExtras().scriptPassword = (boost::format("%04x%04x") % (rand()&0xFFFF) % (rand()&0xFFFF) ).str();
         SetRelayIngamePassword( user );
     }
     //KICKFROMBATTLE username
@@ -1023,6 +1104,7 @@ void Server::BattleKickPlayer( const IBattlePtr battle, const CommonUserPtr user
 
 void Server::SetHandicap( const IBattlePtr battle, const CommonUserPtr user, int handicap)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SetHandicap, this, battle, user, handicap ) );
     if (!battle) return;
     if (!user) return;
     UserBattleStatus status = user->BattleStatus();
@@ -1042,6 +1124,7 @@ void Server::SetHandicap( const IBattlePtr battle, const CommonUserPtr user, int
 
 void Server::SendUserPosition( const CommonUserPtr user )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SendUserPosition, this, user ) );
     if (!m_impl->m_current_battle) return;
     if (!m_impl->m_current_battle->IsFounderMe()) return;
     if (!user) return;
@@ -1055,6 +1138,7 @@ void Server::SendUserPosition( const CommonUserPtr user )
 
 void Server::SendScriptToClients( const std::string& script )
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SendScriptToClients, this, script ) );
     m_impl->RelayCmd( "SCRIPTSTART" );
     const StringVector lines = Util::StringTokenize(script,"\n");
     for(StringVector::iterator itor; itor != lines.end(); ++itor)
@@ -1078,19 +1162,76 @@ void Server::OnUserStartPositionUpdated(IBattlePtr battle, CommonUserPtr player,
 }
 
 //**************Get/Setters ******************
-IBattlePtr Server::GetCurrentBattle() { return m_impl->m_current_battle; }
-const ConstIBattlePtr Server::GetCurrentBattle() const { return m_impl->m_current_battle; }
+IBattlePtr Server::GetCurrentBattle() { WARN_OFF_NETWORK_THREAD(); return m_impl->m_current_battle; }
+const ConstIBattlePtr Server::GetCurrentBattle() const { WARN_OFF_NETWORK_THREAD(); return m_impl->m_current_battle; }
 
-void Server::SetKeepaliveInterval( int seconds ) { m_impl->m_keepalive = seconds; }
-int Server::GetKeepaliveInterval() { return m_impl->m_keepalive; }
+UserList::RangeType Server::GetUsers() const { WARN_OFF_NETWORK_THREAD(); return m_impl->m_users.Range(); }
+Battle::BattleList::RangeType Server::GetBattles() const { WARN_OFF_NETWORK_THREAD(); return m_impl->m_battles.Range(); }
+LobbySnapshotPtr Server::GetSnapshot() const { return m_impl->m_snapshots.Current(); }
 
-std::string Server::GetRequiredSpring() const { return m_impl->m_min_required_spring_ver; }
-void Server::SetRequiredSpring( const std::string& version ) { m_impl->m_min_required_spring_ver = version; }
+Battle::BattleQueryPtr Server::RegisterBattleQuery( const Battle::BattleFilter& filter, const Battle::BattleSortKey& key,
+                                                    bool descending, const Battle::BattleDeltaCallback& callback )
+{
+    WARN_OFF_NETWORK_THREAD();
+    return m_impl->m_battle_queries.Register( m_impl->m_battles, filter, key, descending, callback );
+}
 
-const UserPtr Server::GetMe() const {return m_impl->m_me;}
-std::string Server::GetServerName() const { return m_impl->m_server_name; }
+void Server::UnregisterBattleQuery( const Battle::BattleQueryPtr& query )
+{
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::UnregisterBattleQuery, this, query ) );
+    m_impl->m_battle_queries.Unregister( query );
+}
+
+boost::filtered_range< Battle::HasFreeSlots, const Battle::BattleList::RangeType > Server::GetOpenBattles() const
+{
+    WARN_OFF_NETWORK_THREAD();
+    return m_impl->m_battles.Filter( Battle::HasFreeSlots() );
+}
+
+boost::filtered_range< IsInGame, const UserList::RangeType > Server::GetUsersInGame() const
+{
+    WARN_OFF_NETWORK_THREAD();
+    return m_impl->m_users.Filter( IsInGame() );
+}
+
+void Server::SetKeepaliveInterval( int seconds )
+{
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SetKeepaliveInterval, this, seconds ) );
+    m_impl->m_keepalive = seconds;
+}
+int Server::GetKeepaliveInterval() { WARN_OFF_NETWORK_THREAD(); return m_impl->m_keepalive; }
 
-void Server::SetPrivateUdpPort(int port) { m_impl->m_udp_private_port = port;}
+void Server::SetSendRateLimit( int Bps )
+{
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SetSendRateLimit, this, Bps ) );
+    m_impl->m_server_rate_limit = Bps;
+    m_impl->m_sock->SetSendRateLimit( Bps );
+}
+int Server::GetSendRateLimit() const { return m_impl->m_sock->GetSendRateLimit(); }
+SendStatistics Server::GetSendStatistics() const { return m_impl->m_sock->GetSendStatistics(); }
+
+bool Server::StartCapture( const std::string& filename ) { return m_impl->m_sock->StartCapture( filename ); }
+void Server::StopCapture()
+{
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::StopCapture, this ) );
+    m_impl->m_sock->StopCapture();
+}
+
+std::string Server::GetRequiredSpring() const { WARN_OFF_NETWORK_THREAD(); return m_impl->m_min_required_spring_ver; }
+void Server::SetRequiredSpring( const std::string& version )
+{
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SetRequiredSpring, this, version ) );
+    m_impl->m_min_required_spring_ver = version;
+}
+
+const UserPtr Server::GetMe() const { WARN_OFF_NETWORK_THREAD(); return m_impl->m_me; }
+std::string Server::GetServerName() const { WARN_OFF_NETWORK_THREAD(); return m_impl->m_server_name; }
+
+void Server::SetPrivateUdpPort(int port)
+{
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::SetPrivateUdpPort, this, port ) );
+    m_impl->m_udp_private_port = port;
+}
 
 void Server::OnUserLeftChannel(ChannelPtr channel, UserPtr user)
 {
@@ -1106,6 +1247,7 @@ void Server::OnChannelTopic(ChannelPtr channel, UserPtr user, const std::string
 
 void Server::Login(const std::string &user, const std::string &password)
 {
+    RUN_ON_NETWORK_THREAD( boost::bind( &Server::Login, this, user, password ) );
     m_impl->Login( user, password );
 }
 
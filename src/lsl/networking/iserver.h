@@ -6,16 +6,22 @@
 #include <vector>
 #include <boost/signals2/signal.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/future.hpp>
 
 #include <lslutils/mutexwrapper.h>
 #include <lslutils/crc.h>
 #include <lsl/battle/enum.h>
 #include <lsl/container/battlelist.h>
+#include <lsl/container/battlequery.h>
 #include <lsl/container/channellist.h>
 #include <lsl/container/userlist.h>
 
 #include <lslutils/type_forwards.h>
 #include "enums.h"
+#include "ratelimiter.h"
+#include "requests.h"
+#include "snapshot.h"
 
 namespace LSL {
 
@@ -52,6 +58,21 @@ struct MuteListEntry {
 typedef std::list<MuteListEntry>
     MuteList;
 
+//! the lobby state as of LOGININFOEND, see Server::sig_InitialStateReady
+struct InitialState {
+    UserVector users;
+    std::vector<BattlePtr> battles;
+    std::vector<ChannelPtr> channels;
+};
+
+/** \brief a lobby server connection
+ * All server state belongs to the network thread, which runs the protocol handlers and emits
+ * every signal. Commands (the methods returning nothing) may be called from any thread, off
+ * the network thread they are queued for it and run in call order. Queries should only be made
+ * on the network thread (from a signal handler or a task given to Post) or before Connect,
+ * elsewhere they race with the protocol handlers and log a warning. Other threads use
+ * GetSnapshot, the statistics and the future returning Request, or Post a task.
+ */
 class Server : public boost::enable_shared_from_this<Server>
 {
   public:
@@ -59,6 +80,7 @@ class Server : public boost::enable_shared_from_this<Server>
     virtual ~Server();
 
     friend class ServerImpl;
+    friend class ProtocolReplay;
 
     boost::signals2::signal<void ()> sig_NATPunchFailed;
     //! battle_id
@@ -74,6 +96,15 @@ class Server : public boost::enable_shared_from_this<Server>
     boost::signals2::signal<void (bool)> sig_Disconnected;
     //! the udp port
     boost::signals2::signal<void (int)> sig_MyInternalUdpSourcePort;
+    //! the server greeted us, Login can be called now
+    boost::signals2::signal<void ()> sig_Connected;
+    /** LOGININFOEND: everything the server sent after ACCEPTED, in one go.
+     * Users, battles and statuses in here had no individual events fired for them.
+     */
+    boost::signals2::signal<void (const InitialState&)> sig_InitialStateReady;
+
+	//! runs \param task on the network thread, where it may use the whole interface
+	void Post( const boost::function<void ()>& task );
 
 	void Connect( const std::string& servername, const std::string& addr, const int port );
     void Disconnect(const std::string& reason);
@@ -95,13 +126,59 @@ class Server : public boost::enable_shared_from_this<Server>
     IBattlePtr GetCurrentBattle();
     const ConstIBattlePtr GetCurrentBattle() const;
 
+    /** \brief everyone and every battle on the server, as views into the lists kept here
+     * Nothing is copied. Use them from signal handlers, the network thread changes the lists
+     * in between.
+     */
+    UserList::RangeType GetUsers() const;
+    Battle::BattleList::RangeType GetBattles() const;
+    //! lazy views: battles that still take players, users currently in a game
+    boost::filtered_range< Battle::HasFreeSlots, const Battle::BattleList::RangeType > GetOpenBattles() const;
+    boost::filtered_range< IsInGame, const UserList::RangeType > GetUsersInGame() const;
+    /** \brief the users and battles as of the last complete update, for any thread
+     * Never blocks and never sees a half applied batch; hold on to it as long as needed,
+     * later updates go into new snapshots.
+     */
+    LobbySnapshotPtr GetSnapshot() const;
+
+    /** \brief a battle list view that stays filtered and sorted, see Battle::BattleQuery
+     * Register from the network thread (a signal handler) or before Connect. \param callback
+     * runs on the network thread with the deltas of every batch of updates.
+     */
+    Battle::BattleQueryPtr RegisterBattleQuery( const Battle::BattleFilter& filter, const Battle::BattleSortKey& key,
+                                                bool descending, const Battle::BattleDeltaCallback& callback );
+    void UnregisterBattleQuery( const Battle::BattleQueryPtr& query );
+
     void SetKeepaliveInterval( int seconds );
     int GetKeepaliveInterval();
 
+    //! bytes per second the outgoing queue is metered to, -1 means unlimited
+    void SetSendRateLimit( int Bps );
+    int GetSendRateLimit() const;
+    //! queued bytes per priority lane and time spent throttled
+    SendStatistics GetSendStatistics() const;
+
+    /** \brief send \param cmd and hand the first reply carrying its message id to \param callback
+     * The callback runs on the network thread, or with success false and error "timeout" from
+     * TimerUpdate once \param timeout_ms passed. Any number of requests may be in flight.
+     * Network thread only, the future returning overload can be used from anywhere.
+     * \return the message id, 0 if the request failed right away
+     */
+    int Request( const std::string& cmd, const std::string& params, const RequestCallback& callback, int timeout_ms = 10000 );
+    //! Request() for callers that would rather wait on the reply
+    boost::unique_future<RequestReply> Request( const std::string& cmd, const std::string& params, int timeout_ms = 10000 );
+    //! round trip histograms of requests and pings, by command
+    RttStatistics GetRequestStatistics() const;
+    size_t GetOutstandingRequests() const;
+
+    //! record all inbound traffic into \param filename for ProtocolReplay, call before Connect
+    bool StartCapture( const std::string& filename );
+    void StopCapture();
+
     std::string GetRequiredSpring() const;
     void SetRequiredSpring( const std::string& version );
 
-    void OnSocketConnected(bool connection_ok, const std::string msg);
+    void OnSocketConnected(bool connection_ok, const std::string& msg);
 
     const UserPtr GetMe() const;
 
@@ -145,7 +222,6 @@ class Server : public boost::enable_shared_from_this<Server>
 
 private:
     UserVector GetAvailableRelayHostList();
-    void HandlePong( int replyid );
 
 public:
 
@@ -170,8 +246,8 @@ public:
     void OnBattleStarted(const IBattlePtr battle);
     void OnBattleStopped(const IBattlePtr battle);
     void OnBattleOpened( const IBattlePtr battle );
-	void OnBattleMapChanged(const IBattlePtr battle,UnitsyncMap map);
-	void OnBattleModChanged( const IBattlePtr battle, UnitsyncMod mod );
+	void OnBattleMapChanged(const IBattlePtr battle, const UnitsyncMap& map);
+	void OnBattleModChanged( const IBattlePtr battle, const UnitsyncMod& mod );
 	void OnBattleMaxPlayersChanged( const IBattlePtr battle, int maxplayers );
 	void OnBattleHostChanged( const IBattlePtr battle, UserPtr host, const std::string& ip, int port );
 	void OnBattleSpectatorCountUpdated(const IBattlePtr battle,int spectators);
@@ -0,0 +1,82 @@
+#include "lineframer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
+
+namespace LSL {
+
+LineFramer::LineFramer( size_t initial_capacity )
+    : m_buffer( initial_capacity )
+    , m_begin( 0 )
+    , m_end( 0 )
+{
+}
+
+void LineFramer::Clear()
+{
+    m_begin = m_end = 0;
+}
+
+boost::asio::mutable_buffers_1 LineFramer::Prepare( size_t min_size )
+{
+    if ( m_begin > 0 )
+    {
+        //only the partial tail line is moved, complete lines are already consumed
+        const size_t pending = m_end - m_begin;
+        if ( pending > 0 )
+            std::memmove( &m_buffer[0], &m_buffer[m_begin], pending );
+        m_begin = 0;
+        m_end = pending;
+    }
+    if ( m_buffer.size() - m_end < min_size )
+        m_buffer.resize( std::max( m_buffer.size() * 2, m_end + min_size ) );
+    return boost::asio::buffer( &m_buffer[m_end], m_buffer.size() - m_end );
+}
+
+size_t LineFramer::Commit( size_t bytes, const LineHandler& handler )
+{
+    assert( m_end + bytes <= m_buffer.size() );
+    m_end += bytes;
+    return Dispatch( handler );
+}
+
+size_t LineFramer::Feed( const char* data, size_t length, const LineHandler& handler )
+{
+    boost::asio::mutable_buffers_1 target = Prepare( length );
+    std::memcpy( boost::asio::buffer_cast<char*>( target ), data, length );
+    return Commit( length, handler );
+}
+
+size_t LineFramer::Dispatch( const LineHandler& handler )
+{
+    size_t lines = 0;
+    const char* const base = &m_buffer[0];
+    const char* pos = base + m_begin;
+    const char* const end = base + m_end;
+    while ( pos < end )
+    {
+        const char* eol = static_cast<const char*>( std::memchr( pos, '\n', end - pos ) );
+        if ( !eol )
+            break;
+        const char* line_end = eol;
+        if ( line_end > pos && *( line_end - 1 ) == '\r' )
+            --line_end;
+        if ( line_end > pos )
+        {
+            const char* sep = static_cast<const char*>( std::memchr( pos, ' ', line_end - pos ) );
+            const char* params = sep ? sep + 1 : line_end;
+            if ( !sep )
+                sep = line_end;
+            handler( StringRef( pos, sep - pos ), StringRef( params, line_end - params ) );
+            ++lines;
+        }
+        pos = eol + 1;
+    }
+    m_begin = pos - base;
+    if ( m_begin == m_end )
+        m_begin = m_end = 0;
+    return lines;
+}
+
+} // namespace LSL
@@ -0,0 +1,75 @@
+#ifndef LSL_LINEFRAMER_H
+#define LSL_LINEFRAMER_H
+
+#include <boost/asio/buffer.hpp>
+#include <boost/function.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <vector>
+
+namespace LSL {
+
+//! non-owning view into a receive buffer, only valid for the duration of a handler call
+typedef boost::string_ref StringRef;
+
+/** \brief splits a byte stream into protocol lines without copying them
+ * Data is read straight into a reusable buffer, every complete line of a chunk is
+ * handed to the handler as (command,params) views, an incomplete tail line is kept
+ * at the buffer front until the rest of it arrives.
+ */
+class LineFramer
+{
+public:
+	//! cmd_name,params
+	typedef boost::function<void (StringRef,StringRef)> LineHandler;
+
+	explicit LineFramer( size_t initial_capacity = 64 * 1024 );
+
+	//! writable region behind pending data, at least \param min_size bytes big
+	boost::asio::mutable_buffers_1 Prepare( size_t min_size = 4096 );
+	//! marks \param bytes of the last Prepare()'d region as received and dispatches all complete lines
+	size_t Commit( size_t bytes, const LineHandler& handler );
+	//! copies \param data into the buffer and dispatches, \return number of lines handled
+	size_t Feed( const char* data, size_t length, const LineHandler& handler );
+
+	//! bytes of an incomplete line waiting for more data
+	size_t Pending() const { return m_end - m_begin; }
+	void Clear();
+
+private:
+	size_t Dispatch( const LineHandler& handler );
+
+	std::vector<char> m_buffer;
+	size_t m_begin;
+	size_t m_end;
+};
+
+} //namespace LSL
+
+/**
+ * \file lineframer.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_LINEFRAMER_H
@@ -0,0 +1,76 @@
+#include "ratelimiter.h"
+
+#include <algorithm>
+
+namespace LSL {
+
+TokenBucket::TokenBucket( int bytes_per_second )
+    : m_rate( bytes_per_second )
+    , m_tokens( std::max( bytes_per_second, 0 ) )
+    , m_last_refill( Now() )
+{
+}
+
+TokenBucket::TimePoint TokenBucket::Now()
+{
+    return boost::posix_time::microsec_clock::universal_time();
+}
+
+void TokenBucket::SetRate( int bytes_per_second )
+{
+    m_rate = bytes_per_second;
+    m_tokens = std::max( bytes_per_second, 0 );
+    m_last_refill = Now();
+}
+
+void TokenBucket::Refill( const TimePoint& now )
+{
+    if ( now <= m_last_refill )
+        return;
+    const double elapsed = ( now - m_last_refill ).total_microseconds() / 1e6;
+    m_tokens = std::min( m_tokens + elapsed * m_rate, double( m_rate ) );
+    m_last_refill = now;
+}
+
+bool TokenBucket::Available( const TimePoint& now )
+{
+    if ( Unlimited() )
+        return true;
+    Refill( now );
+    return m_tokens > 0;
+}
+
+void TokenBucket::Consume( size_t bytes )
+{
+    if ( !Unlimited() )
+        m_tokens -= bytes;
+}
+
+TokenBucket::Duration TokenBucket::Delay( const TimePoint& now )
+{
+    if ( !Available( now ) )
+    {
+        //one extra millisecond so the refill after waking is guaranteed to be positive
+        const double seconds = -m_tokens / m_rate;
+        return boost::posix_time::microseconds( static_cast<long>( seconds * 1e6 ) + 1000 );
+    }
+    return Duration( 0, 0, 0 );
+}
+
+SendStatistics::SendStatistics()
+    : sent_bytes( 0 )
+    , throttle_count( 0 )
+    , throttle_seconds( 0 )
+{
+    std::fill( queued_bytes, queued_bytes + Enum::SP_Count, 0 );
+}
+
+size_t SendStatistics::QueuedBytes() const
+{
+    size_t sum = 0;
+    for ( int i = 0; i < Enum::SP_Count; ++i )
+        sum += queued_bytes[i];
+    return sum;
+}
+
+} // namespace LSL
@@ -0,0 +1,90 @@
+#ifndef LSL_RATELIMITER_H
+#define LSL_RATELIMITER_H
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <cstddef>
+
+#include "enums.h"
+
+namespace LSL {
+
+/** \brief byte based token bucket
+ * Tokens refill at the configured rate up to one second worth of traffic. A message
+ * may be sent as long as the bucket isn't empty, so messages bigger than the bucket
+ * still go out and simply leave a deficit that has to be paid back before the next one.
+ */
+class TokenBucket
+{
+public:
+	typedef boost::posix_time::ptime TimePoint;
+	typedef boost::posix_time::time_duration Duration;
+
+	//! \param bytes_per_second <= 0 disables limiting
+	explicit TokenBucket( int bytes_per_second = -1 );
+
+	void SetRate( int bytes_per_second );
+	int GetRate() const { return m_rate; }
+	bool Unlimited() const { return m_rate <= 0; }
+
+	//! \return true if sending is allowed at \param now, the caller then has to Consume()
+	bool Available( const TimePoint& now );
+	void Consume( size_t bytes );
+	//! time until Available() turns true again
+	Duration Delay( const TimePoint& now );
+
+	static TimePoint Now();
+
+private:
+	void Refill( const TimePoint& now );
+
+	int m_rate;
+	double m_tokens;
+	TimePoint m_last_refill;
+};
+
+//! counters of the outgoing queue, for tuning the rate limit
+struct SendStatistics
+{
+	SendStatistics();
+	//! bytes waiting in each Enum::SendPriority lane
+	size_t queued_bytes[Enum::SP_Count];
+	//! bytes that went through the socket since connecting
+	size_t sent_bytes;
+	//! number of times writing had to wait for the token bucket
+	size_t throttle_count;
+	//! accumulated waiting time for the token bucket
+	double throttle_seconds;
+
+	size_t QueuedBytes() const;
+};
+
+} //namespace LSL
+
+/**
+ * \file ratelimiter.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_RATELIMITER_H
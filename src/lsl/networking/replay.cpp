@@ -0,0 +1,135 @@
+#include "replay.h"
+
+#include "iserver.h"
+#include "tasserver.h"
+#include "capture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace LSL {
+
+static double NowSeconds()
+{
+    return std::chrono::duration_cast< std::chrono::duration<double> >(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//! nearest rank percentile of sorted \param samples
+static double Percentile( const std::vector<double>& samples, double p )
+{
+    if ( samples.empty() )
+        return 0;
+    const size_t rank = static_cast<size_t>( p * ( samples.size() - 1 ) + 0.5 );
+    return samples[std::min( rank, samples.size() - 1 )];
+}
+
+ReplayStatistics::ReplayStatistics()
+    : lines( 0 )
+    , bytes( 0 )
+    , seconds( 0 )
+    , allocations( 0 )
+{
+}
+
+double ReplayStatistics::LinesPerSecond() const
+{
+    return seconds > 0 ? lines / seconds : 0;
+}
+
+double ReplayStatistics::AllocationsPerLine() const
+{
+    return lines > 0 ? double( allocations ) / lines : 0;
+}
+
+ProtocolReplay::ProtocolReplay( Server& server )
+    : m_impl( server.m_impl )
+    , m_line_handler( boost::bind( &ProtocolReplay::OnLine, this, _1, _2 ) )
+    , m_start( 0 )
+{
+}
+
+void ProtocolReplay::Begin()
+{
+    m_framer.Clear();
+    m_stats = ReplayStatistics();
+    m_samples.clear();
+    m_start = NowSeconds();
+}
+
+void ProtocolReplay::Feed( const char* data, size_t length )
+{
+    m_stats.bytes += length;
+    m_framer.Feed( data, length, m_line_handler );
+    //what the socket does after every read: flush the battle queries, publish the snapshot
+    const size_t allocations_before = m_allocation_counter ? m_allocation_counter() : 0;
+    m_impl->OnReceiveBatchDone();
+    if ( m_allocation_counter )
+        m_stats.allocations += m_allocation_counter() - allocations_before;
+}
+
+ReplayStatistics ProtocolReplay::Finish()
+{
+    m_stats.seconds = NowSeconds() - m_start;
+    for ( std::map< std::string, std::vector< double > >::iterator it = m_samples.begin(); it != m_samples.end(); ++it )
+    {
+        std::vector< double >& samples = it->second;
+        std::sort( samples.begin(), samples.end() );
+        ReplayStatistics::Latency& latency = m_stats.commands[it->first];
+        latency.count = samples.size();
+        latency.p50 = Percentile( samples, 0.5 );
+        latency.p90 = Percentile( samples, 0.9 );
+        latency.p99 = Percentile( samples, 0.99 );
+        latency.max = samples.back();
+    }
+    return m_stats;
+}
+
+ReplayStatistics ProtocolReplay::Run( CaptureReader& capture, bool realtime )
+{
+    Begin();
+    CaptureRecord record;
+    while ( capture.Next( record ) )
+    {
+        if ( realtime )
+        {
+            const double due = m_start + record.offset_us / 1e6;
+            const double wait = due - NowSeconds();
+            if ( wait > 0 )
+                boost::this_thread::sleep( boost::posix_time::microseconds( static_cast<long>( wait * 1e6 ) ) );
+        }
+        Feed( record.data.data(), record.data.size() );
+    }
+    return Finish();
+}
+
+ReplayStatistics ProtocolReplay::Run( const std::string& stream, size_t chunk )
+{
+    Begin();
+    for ( size_t off = 0; off < stream.size(); off += chunk )
+        Feed( stream.data() + off, std::min( chunk, stream.size() - off ) );
+    return Finish();
+}
+
+void ProtocolReplay::OnLine( StringRef cmd, StringRef params )
+{
+    //"#id CMD" lines are keyed by the actual command
+    StringRef name = cmd;
+    if ( !name.empty() && name[0] == '#' )
+        name = params.substr( 0, params.find( ' ' ) );
+
+    const size_t allocations_before = m_allocation_counter ? m_allocation_counter() : 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_impl->OnDataReceived( cmd, params );
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    if ( m_allocation_counter )
+        m_stats.allocations += m_allocation_counter() - allocations_before;
+
+    ++m_stats.lines;
+    m_samples[name.to_string()].push_back(
+                std::chrono::duration_cast< std::chrono::duration<double, std::micro> >( end - start ).count() );
+}
+
+} // namespace LSL
@@ -0,0 +1,107 @@
+#ifndef LSL_REPLAY_H
+#define LSL_REPLAY_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+
+#include "lineframer.h"
+
+namespace LSL {
+
+class Server;
+class ServerImpl;
+class CaptureReader;
+
+//! outcome of a ProtocolReplay run
+struct ReplayStatistics
+{
+	//! per command latency of ServerImpl::ExecuteCommand, in microseconds
+	struct Latency
+	{
+		size_t count;
+		double p50;
+		double p90;
+		double p99;
+		double max;
+	};
+
+	ReplayStatistics();
+
+	size_t lines;
+	size_t bytes;
+	double seconds;
+	//! heap allocations made while executing commands, 0 without an allocation counter
+	size_t allocations;
+	std::map< std::string, Latency > commands;
+
+	double LinesPerSecond() const;
+	double AllocationsPerLine() const;
+};
+
+/** \brief feeds recorded protocol traffic into a Server without any socket
+ * Lines are framed exactly like Socket does and handed to ServerImpl one by one, and every
+ * fed record or chunk ends like a socket read does, with the battle query flush and the
+ * snapshot publish. That makes inbound processing benchmarkable and reproducible offline.
+ */
+class ProtocolReplay
+{
+public:
+	//! \return number of heap allocations so far, supplied by whoever hooks operator new
+	typedef boost::function< size_t () > AllocationCounter;
+
+	explicit ProtocolReplay( Server& server );
+
+	void SetAllocationCounter( const AllocationCounter& counter ) { m_allocation_counter = counter; }
+
+	//! \param realtime keep the recorded pacing instead of replaying as fast as possible
+	ReplayStatistics Run( CaptureReader& capture, bool realtime = false );
+	//! replays a raw byte stream as fast as possible, split into \param chunk sized reads
+	ReplayStatistics Run( const std::string& stream, size_t chunk = 4096 );
+
+private:
+	void Begin();
+	void Feed( const char* data, size_t length );
+	ReplayStatistics Finish();
+	void OnLine( StringRef cmd, StringRef params );
+
+	ServerImpl* m_impl;
+	AllocationCounter m_allocation_counter;
+	LineFramer m_framer;
+	LineFramer::LineHandler m_line_handler;
+	ReplayStatistics m_stats;
+	std::map< std::string, std::vector< double > > m_samples;
+	double m_start;
+};
+
+} //namespace LSL
+
+/**
+ * \file replay.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_REPLAY_H
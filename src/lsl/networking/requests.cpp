@@ -0,0 +1,220 @@
+#include "requests.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace LSL {
+
+RttHistogram::RttHistogram()
+    : timeouts( 0 )
+    , failures( 0 )
+{
+    std::fill( buckets, buckets + BUCKETS, 0 );
+}
+
+void RttHistogram::Add( long rtt_us )
+{
+    int bucket = 0;
+    while ( rtt_us > 1 && bucket < BUCKETS - 1 )
+    {
+        rtt_us >>= 1;
+        ++bucket;
+    }
+    ++buckets[bucket];
+}
+
+unsigned long RttHistogram::Count() const
+{
+    unsigned long count = 0;
+    for ( int b = 0; b < BUCKETS; ++b )
+        count += buckets[b];
+    return count;
+}
+
+long RttHistogram::Percentile( double p ) const
+{
+    const unsigned long count = Count();
+    if ( count == 0 )
+        return 0;
+    const unsigned long rank = std::min( count, static_cast<unsigned long>( p * count ) + 1 );
+    unsigned long seen = 0;
+    for ( int b = 0; b < BUCKETS; ++b )
+    {
+        seen += buckets[b];
+        if ( seen >= rank )
+            return ( 2L << b ) - 1;
+    }
+    return ( 2L << ( BUCKETS - 1 ) ) - 1;
+}
+
+namespace {
+struct IdLess
+{
+    template <class P>
+    bool operator()( const P& pending, int id ) const { return pending.id < id; }
+    template <class P>
+    bool operator()( int id, const P& pending ) const { return id < pending.id; }
+};
+}
+
+RequestTracker::RequestTracker()
+    : m_outstanding( 0 )
+{
+}
+
+RequestTracker::TimePoint RequestTracker::Now()
+{
+    return boost::posix_time::microsec_clock::universal_time();
+}
+
+void RequestTracker::Add( int id, const std::string& command, int timeout_ms, const RequestCallback& callback )
+{
+    Pending pending;
+    pending.id = id;
+    pending.sent = Now();
+    pending.deadline = pending.sent + boost::posix_time::milliseconds( timeout_ms );
+    pending.command = command;
+    pending.callback = callback;
+    pending.done = false;
+    boost::mutex::scoped_lock lock( m_mutex );
+    //ids are handed out in order, but two senders may register the other way round
+    m_pending.insert( std::upper_bound( m_pending.begin(), m_pending.end(), id, IdLess() ), pending );
+    ++m_outstanding;
+}
+
+RequestTracker::Pending* RequestTracker::Find( int id )
+{
+    PendingQueue::iterator it = std::lower_bound( m_pending.begin(), m_pending.end(), id, IdLess() );
+    if ( it == m_pending.end() || it->id != id || it->done )
+        return NULL;
+    return &*it;
+}
+
+RequestCallback RequestTracker::Finish( Pending& pending, RequestReply& reply, const TimePoint& now )
+{
+    pending.done = true;
+    --m_outstanding;
+    reply.id = pending.id;
+    reply.rtt_us = ( now - pending.sent ).total_microseconds();
+    RttHistogram& histogram = m_stats[pending.command];
+    if ( reply.success )
+        histogram.Add( reply.rtt_us );
+    else if ( reply.error == "timeout" )
+        histogram.timeouts++;
+    else
+        histogram.failures++;
+    RequestCallback callback;
+    callback.swap( pending.callback );
+    return callback;
+}
+
+void RequestTracker::PopFinished()
+{
+    while ( !m_pending.empty() && m_pending.front().done )
+        m_pending.pop_front();
+}
+
+bool RequestTracker::Complete( int id, StringRef command, StringRef params )
+{
+    RequestReply reply;
+    RequestCallback callback;
+    {
+        boost::mutex::scoped_lock lock( m_mutex );
+        Pending* pending = Find( id );
+        if ( !pending )
+            return false;
+        reply.success = true;
+        reply.command = command.to_string();
+        reply.params = params.to_string();
+        callback = Finish( *pending, reply, Now() );
+        PopFinished();
+    }
+    if ( callback )
+        callback( reply );
+    return true;
+}
+
+void RequestTracker::Fail( int id, const std::string& error )
+{
+    RequestReply reply;
+    RequestCallback callback;
+    {
+        boost::mutex::scoped_lock lock( m_mutex );
+        Pending* pending = Find( id );
+        if ( !pending )
+            return;
+        reply.error = error;
+        callback = Finish( *pending, reply, Now() );
+        PopFinished();
+    }
+    if ( callback )
+        callback( reply );
+}
+
+void RequestTracker::FailAll( const std::string& error )
+{
+    PendingQueue failed;
+    {
+        boost::mutex::scoped_lock lock( m_mutex );
+        failed.swap( m_pending );
+        m_outstanding = 0;
+        for ( PendingQueue::iterator it = failed.begin(); it != failed.end(); ++it )
+        {
+            if ( !it->done )
+                m_stats[it->command].failures++;
+        }
+    }
+    for ( PendingQueue::iterator it = failed.begin(); it != failed.end(); ++it )
+    {
+        if ( it->done || !it->callback )
+            continue;
+        RequestReply reply;
+        reply.id = it->id;
+        reply.error = error;
+        it->callback( reply );
+    }
+}
+
+size_t RequestTracker::Expire( const TimePoint& now )
+{
+    std::vector<std::pair<RequestCallback, RequestReply> > expired;
+    {
+        boost::mutex::scoped_lock lock( m_mutex );
+        for ( PendingQueue::iterator it = m_pending.begin(); it != m_pending.end(); ++it )
+        {
+            if ( it->done || it->deadline > now )
+                continue;
+            RequestReply reply;
+            reply.error = "timeout";
+            const RequestCallback callback = Finish( *it, reply, now );
+            expired.push_back( std::make_pair( callback, reply ) );
+        }
+        PopFinished();
+    }
+    for ( size_t i = 0; i < expired.size(); ++i )
+    {
+        if ( expired[i].first )
+            expired[i].first( expired[i].second );
+    }
+    return expired.size();
+}
+
+size_t RequestTracker::Outstanding() const
+{
+    boost::mutex::scoped_lock lock( m_mutex );
+    return m_outstanding;
+}
+
+RttStatistics RequestTracker::GetStatistics() const
+{
+    boost::mutex::scoped_lock lock( m_mutex );
+    return m_stats;
+}
+
+void RequestTracker::ResetStatistics()
+{
+    boost::mutex::scoped_lock lock( m_mutex );
+    m_stats.clear();
+}
+
+} // namespace LSL
@@ -0,0 +1,132 @@
+#ifndef LSL_REQUESTS_H
+#define LSL_REQUESTS_H
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <map>
+#include <string>
+
+#include "lineframer.h"
+
+namespace LSL {
+
+//! outcome of a request sent with Server::Request
+struct RequestReply
+{
+	RequestReply() : success( false ), id( 0 ), rtt_us( 0 ) {}
+	//! false on timeout, disconnect or if sending failed, see \ref error
+	bool success;
+	std::string error;
+	//! message id the request went out with
+	int id;
+	//! first reply that carried the id
+	std::string command;
+	std::string params;
+	long rtt_us;
+};
+
+typedef boost::function<void (const RequestReply&)> RequestCallback;
+
+//! round trip times of one request command in power of two buckets
+struct RttHistogram
+{
+	//! bucket b counts round trips in [2^b, 2^(b+1)) microseconds
+	static const int BUCKETS = 30;
+
+	RttHistogram();
+	void Add( long rtt_us );
+	unsigned long Count() const;
+	//! upper bound of the bucket holding quantile \param p in [0,1], in microseconds; 0 if empty
+	long Percentile( double p ) const;
+
+	unsigned long buckets[BUCKETS];
+	unsigned long timeouts;
+	unsigned long failures;
+};
+
+//! histograms keyed by request command
+typedef std::map<std::string, RttHistogram> RttStatistics;
+
+/** \brief outstanding requests keyed by protocol message id
+ * Ids only grow, so the pending requests are kept in a deque ordered by id and
+ * looked up by binary search; finished entries are dropped from the front.
+ * Callbacks are called without the lock held, from whichever thread completes them.
+ */
+class RequestTracker
+{
+public:
+	typedef boost::posix_time::ptime TimePoint;
+
+	RequestTracker();
+
+	void Add( int id, const std::string& command, int timeout_ms, const RequestCallback& callback );
+	//! \return false if \param id is not outstanding, the reply then isn't ours
+	bool Complete( int id, StringRef command, StringRef params );
+	void Fail( int id, const std::string& error );
+	//! fails everything outstanding, on disconnect
+	void FailAll( const std::string& error );
+	//! fails requests whose deadline passed before \param now, \return their number
+	size_t Expire( const TimePoint& now );
+
+	size_t Outstanding() const;
+	RttStatistics GetStatistics() const;
+	void ResetStatistics();
+
+	static TimePoint Now();
+
+private:
+	struct Pending
+	{
+		int id;
+		TimePoint sent;
+		TimePoint deadline;
+		std::string command;
+		RequestCallback callback;
+		bool done;
+	};
+	typedef std::deque<Pending> PendingQueue;
+
+	//! \return the entry for \param id or NULL, call with the lock held
+	Pending* Find( int id );
+	//! marks \param pending done and fills \param reply, call with the lock held
+	RequestCallback Finish( Pending& pending, RequestReply& reply, const TimePoint& now );
+	void PopFinished();
+
+	mutable boost::mutex m_mutex;
+	PendingQueue m_pending;
+	size_t m_outstanding;
+	RttStatistics m_stats;
+};
+
+} //namespace LSL
+
+/**
+ * \file requests.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_REQUESTS_H
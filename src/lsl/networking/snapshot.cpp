@@ -0,0 +1,93 @@
+#include "snapshot.h"
+
+#include <lsl/battle/battle.h>
+#include <lsl/container/battlelist.h>
+#include <lsl/container/userlist.h>
+
+namespace LSL {
+
+SnapshotPublisher::SnapshotPublisher()
+    : m_serial( 0 )
+    , m_current( new LobbySnapshot() )
+{
+}
+
+void SnapshotPublisher::TouchUser( const std::string& id )
+{
+    m_touched_users.insert( id );
+}
+
+void SnapshotPublisher::TouchBattle( int id )
+{
+    m_touched_battles.insert( id );
+}
+
+void SnapshotPublisher::Publish( const UserList& users, const Battle::BattleList& battles )
+{
+    if ( m_touched_users.empty() && m_touched_battles.empty() )
+        return;
+    for ( boost::unordered_set<std::string>::const_iterator it = m_touched_users.begin(); it != m_touched_users.end(); ++it )
+    {
+        const UserPtr user = users.Find( *it );
+        if ( !user )
+        {
+            m_users.Remove( *it );
+            continue;
+        }
+        boost::shared_ptr<UserInfo> info( new UserInfo() );
+        info->id = user->Id();
+        info->nick = user->Nick();
+        info->country = user->GetCountry();
+        info->cpu = user->GetCpu();
+        info->status = user->Status();
+        const IBattlePtr battle = user->GetBattle();
+        info->battle_id = battle ? battle->Id() : -1;
+        m_users.Set( *it, info );
+    }
+    for ( boost::unordered_set<int>::const_iterator it = m_touched_battles.begin(); it != m_touched_battles.end(); ++it )
+    {
+        const BattlePtr battle = battles.Find( *it );
+        if ( !battle )
+        {
+            m_battles.Remove( *it );
+            continue;
+        }
+        boost::shared_ptr<BattleInfo> info( new BattleInfo() );
+        info->options = battle->GetBattleOptions();
+        info->users = battle->UserRange().size();
+        info->in_game = battle->InGame();
+        m_battles.Set( *it, info );
+    }
+    m_touched_users.clear();
+    m_touched_battles.clear();
+
+    boost::shared_ptr<LobbySnapshot> snapshot( new LobbySnapshot() );
+    snapshot->users = m_users.Publish();
+    snapshot->battles = m_battles.Publish();
+    snapshot->serial = ++m_serial;
+    Store( snapshot );
+}
+
+void SnapshotPublisher::Clear()
+{
+    m_touched_users.clear();
+    m_touched_battles.clear();
+    m_users.Clear();
+    m_battles.Clear();
+    boost::shared_ptr<LobbySnapshot> snapshot( new LobbySnapshot() );
+    snapshot->serial = ++m_serial;
+    Store( snapshot );
+}
+
+void SnapshotPublisher::Store( const LobbySnapshotPtr& snapshot )
+{
+    //readers holding the previous version keep it alive, the swap itself is all we wait for
+    boost::atomic_store( &m_current, snapshot );
+}
+
+LobbySnapshotPtr SnapshotPublisher::Current() const
+{
+    return boost::atomic_load( &m_current );
+}
+
+}
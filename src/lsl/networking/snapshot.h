@@ -0,0 +1,237 @@
+#ifndef LSL_SNAPSHOT_H
+#define LSL_SNAPSHOT_H
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <string>
+#include <vector>
+
+#include <lsl/battle/ibattle.h>
+#include <lsl/user/userdata.h>
+
+namespace LSL {
+
+class UserList;
+namespace Battle {
+class BattleList;
+}
+
+template < class Key, class Record >
+class SnapshotTableWriter;
+
+/** \brief an immutable table of records, as published by a SnapshotTableWriter
+ * Records sit in chunks shared with the tables published before and after this one,
+ * a new version only copies the chunks that changed. Order is arbitrary and not stable
+ * between versions.
+ */
+template < class Record >
+class SnapshotTable
+{
+public:
+	SnapshotTable() : m_size( 0 ) {}
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	const Record& operator[]( size_t index ) const { return *( *m_chunks[index / CHUNK_SIZE] )[index % CHUNK_SIZE]; }
+
+private:
+	template < class Key, class Rec >
+	friend class SnapshotTableWriter;
+	static const size_t CHUNK_SIZE = 64;
+	typedef std::vector< boost::shared_ptr< const Record > >
+		Chunk;
+	std::vector< boost::shared_ptr< const Chunk > > m_chunks;
+	size_t m_size;
+};
+
+/** \brief the mutable side of a SnapshotTable, for one writer thread
+ * A chunk still referenced by a published table is copied before it is changed, one
+ * only the writer holds is changed in place.
+ */
+template < class Key, class Record >
+class SnapshotTableWriter
+{
+public:
+	typedef boost::shared_ptr< const Record >
+		RecordPtr;
+
+	SnapshotTableWriter() : m_size( 0 ) {}
+	void Set( const Key& key, const RecordPtr& record );
+	void Remove( const Key& key );
+	void Clear();
+	SnapshotTable< Record > Publish() const;
+
+private:
+	typedef typename SnapshotTable< Record >::Chunk
+		Chunk;
+	static const size_t CHUNK_SIZE = SnapshotTable< Record >::CHUNK_SIZE;
+	RecordPtr& Slot( size_t index );
+
+	std::vector< boost::shared_ptr< Chunk > > m_chunks;
+	boost::unordered_map< Key, size_t > m_slots;
+	std::vector< Key > m_keys;
+	size_t m_size;
+};
+
+//! a user as of one snapshot
+struct UserInfo
+{
+	std::string id;
+	std::string nick;
+	std::string country;
+	int cpu;
+	UserStatus status;
+	//! -1 if not in a battle
+	int battle_id;
+};
+
+//! a battle as of one snapshot
+struct BattleInfo
+{
+	Battle::BattleOptions options;
+	//! including the founder and spectators
+	size_t users;
+	bool in_game;
+};
+
+/** \brief a point-in-time view of the server's users and battles
+ * Published by the network thread at LOGININFOEND and after every batch of received
+ * lines that changed something, so it never shows half an update.
+ */
+struct LobbySnapshot
+{
+	LobbySnapshot() : serial( 0 ) {}
+	SnapshotTable< UserInfo > users;
+	SnapshotTable< BattleInfo > battles;
+	//! counts up with every published version
+	unsigned long serial;
+};
+
+typedef boost::shared_ptr< const LobbySnapshot >
+	LobbySnapshotPtr;
+
+/** \brief builds LobbySnapshots on the network thread and hands them to any thread
+ * The network thread marks what it changed with Touch*, Publish re-reads those from the
+ * live lists. Readers get the current version with a pointer swap, nothing waits on them.
+ */
+class SnapshotPublisher
+{
+public:
+	SnapshotPublisher();
+
+	void TouchUser( const std::string& id );
+	void TouchBattle( int id );
+	//! network thread: fold everything touched since the last call into a new version
+	void Publish( const UserList& users, const Battle::BattleList& battles );
+	//! network thread: publish an empty version, on (re)connect and disconnect
+	void Clear();
+
+	//! any thread
+	LobbySnapshotPtr Current() const;
+
+private:
+	void Store( const LobbySnapshotPtr& snapshot );
+
+	boost::unordered_set< std::string > m_touched_users;
+	boost::unordered_set< int > m_touched_battles;
+	SnapshotTableWriter< std::string, UserInfo > m_users;
+	SnapshotTableWriter< int, BattleInfo > m_battles;
+	unsigned long m_serial;
+	//! only ever accessed through boost::atomic_load/atomic_store
+	LobbySnapshotPtr m_current;
+};
+
+template < class Key, class Record >
+typename SnapshotTableWriter< Key, Record >::RecordPtr& SnapshotTableWriter< Key, Record >::Slot( size_t index )
+{
+	boost::shared_ptr< Chunk >& chunk = m_chunks[index / CHUNK_SIZE];
+	if ( !chunk.unique() )
+		chunk.reset( new Chunk( *chunk ) );
+	return ( *chunk )[index % CHUNK_SIZE];
+}
+
+template < class Key, class Record >
+void SnapshotTableWriter< Key, Record >::Set( const Key& key, const RecordPtr& record )
+{
+	const std::pair< typename boost::unordered_map< Key, size_t >::iterator, bool > slot =
+			m_slots.insert( std::make_pair( key, m_size ) );
+	if ( slot.second )
+	{
+		if ( m_size % CHUNK_SIZE == 0 )
+			m_chunks.push_back( boost::shared_ptr< Chunk >( new Chunk( CHUNK_SIZE ) ) );
+		m_keys.push_back( key );
+		++m_size;
+	}
+	Slot( slot.first->second ) = record;
+}
+
+template < class Key, class Record >
+void SnapshotTableWriter< Key, Record >::Remove( const Key& key )
+{
+	typename boost::unordered_map< Key, size_t >::iterator it = m_slots.find( key );
+	if ( it == m_slots.end() )
+		return;
+	const size_t index = it->second;
+	const size_t last = m_size - 1;
+	m_slots.erase( it );
+	if ( index != last )
+	{
+		Slot( index ) = Slot( last );
+		m_keys[index] = m_keys[last];
+		m_slots[m_keys[index]] = index;
+	}
+	Slot( last ).reset();
+	m_keys.pop_back();
+	--m_size;
+	if ( m_size % CHUNK_SIZE == 0 )
+		m_chunks.pop_back();
+}
+
+template < class Key, class Record >
+void SnapshotTableWriter< Key, Record >::Clear()
+{
+	m_chunks.clear();
+	m_slots.clear();
+	m_keys.clear();
+	m_size = 0;
+}
+
+template < class Key, class Record >
+SnapshotTable< Record > SnapshotTableWriter< Key, Record >::Publish() const
+{
+	SnapshotTable< Record > table;
+	table.m_chunks.assign( m_chunks.begin(), m_chunks.end() );
+	table.m_size = m_size;
+	return table;
+}
+
+} // namespace LSL
+
+/**
+ * \file snapshot.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_SNAPSHOT_H
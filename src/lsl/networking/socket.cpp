@@ -5,8 +5,11 @@
 #include <lslutils/logging.h>
 
 #include <boost/asio.hpp>
+#include <boost/bind.hpp>
 #include <boost/system/error_code.hpp>
+#include <algorithm>
 #include <sstream>
+#include <assert.h>
 
 #ifdef WIN32
     #include <iphlpapi.h>
@@ -18,8 +21,24 @@ namespace IP = boost::asio::ip;
 
 namespace LSL {
 
+namespace {
+//! the network thread, holding on to \param service until it stops
+void RunNetService(boost::shared_ptr<BA::io_service> service)
+{
+    service->run();
+}
+} // namespace
+
 Socket::Socket()
-    : m_sock(m_netservice)
+    : m_netservice(new boost::asio::io_service)
+    , m_sock(*m_netservice)
+    , m_line_handler(boost::bind(&Socket::OnLine, this, _1, _2))
+    , m_receive_data(NULL)
+    , m_send_timer(*m_netservice)
+    , m_queued_bytes(0)
+    , m_send_high_water(1024 * 1024)
+    , m_write_in_progress(false)
+    , m_send_refused(false)
     , m_rate(-1)
     , m_last_net_packet(0)
 {
@@ -27,7 +46,16 @@ Socket::Socket()
 
 Socket::~Socket()
 {
-
+    m_work.reset();
+    m_netservice->stop();
+    if (!m_netthread)
+        return;
+    //dropped from one of our own handlers: the thread can't wait for itself, it returns from
+    //the stopped io_service once the handler is done and takes its copy of the service along
+    if (InNetworkThread())
+        m_netthread->detach();
+    else
+        m_netthread->join();
 }
 
 void Socket::Connect(const std::string &server, int port)
@@ -38,7 +66,7 @@ void Socket::Connect(const std::string &server, int port)
     if (err)
     {
         // error, maybe a hostname?
-        IP::tcp::resolver resolver(m_netservice);
+        IP::tcp::resolver resolver(*m_netservice);
         std::ostringstream portbuf;
         portbuf << port;
         IP::tcp::resolver::query query(server, portbuf.str());
@@ -52,6 +80,41 @@ void Socket::Connect(const std::string &server, int port)
     }
     IP::tcp::endpoint serverep(tempAddr, port);
     m_sock.async_connect(serverep, boost::bind(&Socket::ConnectCallback, this, BA::placeholders::error));
+    if (!m_netthread)
+    {
+        m_work.reset(new BA::io_service::work(*m_netservice));
+        m_netthread.reset(new boost::thread(boost::bind(&RunNetService, m_netservice)));
+    }
+}
+
+void Socket::Disconnect()
+{
+    m_netservice->post(boost::bind(&Socket::CloseSocket, this));
+}
+
+void Socket::Post(const boost::function<void ()>& task)
+{
+    if (m_netthread)
+        m_netservice->post(task);
+    else
+        task();
+}
+
+bool Socket::InNetworkThread() const
+{
+    return !m_netthread || boost::this_thread::get_id() == m_netthread->get_id();
+}
+
+void Socket::CloseSocket()
+{
+    if (!m_sock.is_open())
+        return;
+    boost::system::error_code err;
+    m_sock.shutdown(IP::tcp::socket::shutdown_both, err);
+    m_sock.close(err);
+    //pending write and throttle handlers fail their queued messages with operation_aborted
+    m_send_timer.cancel(err);
+    sig_socketDisconnected();
 }
 
 void Socket::ConnectCallback(const boost::system::error_code &error)
@@ -59,7 +122,8 @@ void Socket::ConnectCallback(const boost::system::error_code &error)
     if (!error)
     {
         sig_doneConnecting(true, "");
-        BA::async_read_until(m_sock, m_incoming_buffer, "\n", boost::bind(&Socket::ReceiveCallback, this, BA::placeholders::error, BA::placeholders::bytes_transferred));
+        m_framer.Clear();
+        AsyncReceive();
     }
     else
     {
@@ -72,15 +136,11 @@ void Socket::ReceiveCallback(const boost::system::error_code &error, size_t byte
     m_last_net_packet = time( 0 );
     if (!error)
     {
-        std::string msg;
-        std::string command;
-        std::istream buf(&m_incoming_buffer);
-        buf >> command;
-        std::getline(buf, msg);
-        if (!msg.empty())
-            msg = msg.substr(1);
-        //emits the signal
-        sig_dataReceived(command, msg);
+        if (m_capture.IsOpen())
+            m_capture.Write(m_receive_data, bytes);
+        //emits the signal once for every complete line in this chunk
+        m_framer.Commit(bytes, m_line_handler);
+        sig_receiveBatchDone();
     }
     else
     {
@@ -96,10 +156,32 @@ void Socket::ReceiveCallback(const boost::system::error_code &error, size_t byte
     }
     if (m_sock.is_open())
     {
-        BA::async_read_until(m_sock, m_incoming_buffer, "\n", boost::bind(&Socket::ReceiveCallback, this, BA::placeholders::error, BA::placeholders::bytes_transferred));
+        AsyncReceive();
     }
 }
 
+void Socket::AsyncReceive()
+{
+    const BA::mutable_buffers_1 region = m_framer.Prepare();
+    m_receive_data = BA::buffer_cast<const char*>(region);
+    m_sock.async_read_some(region, boost::bind(&Socket::ReceiveCallback, this, BA::placeholders::error, BA::placeholders::bytes_transferred));
+}
+
+bool Socket::StartCapture(const std::string& filename)
+{
+    return m_capture.Open(filename);
+}
+
+void Socket::StopCapture()
+{
+    m_capture.Close();
+}
+
+void Socket::OnLine(StringRef command, StringRef params)
+{
+    sig_dataReceived(command, params);
+}
+
 std::string Socket::GetHandle() const
 {
     std::string handle;
@@ -190,7 +272,9 @@ std::string Socket::GetLocalAddress() const
 
 void Socket::SetSendRateLimit(int Bps)
 {
+    boost::mutex::scoped_lock lock(m_send_mutex);
     m_rate = Bps;
+    m_bucket.SetRate(Bps);
 }
 
 Enum::SocketState Socket::State() const
@@ -198,14 +282,152 @@ Enum::SocketState Socket::State() const
 	return Enum::SS_Open;
 }
 
-bool Socket::SendData(const std::string &msg)
+bool Socket::SendData(const std::string &msg, const SendCallback& callback, Enum::SendPriority priority)
 {
-	if (m_sock.is_open())
+	assert(priority >= 0 && priority < Enum::SP_Count);
+	if (!m_sock.is_open())
+		return false;
+	{
+		boost::mutex::scoped_lock lock(m_send_mutex);
+		if (m_queued_bytes >= m_send_high_water)
+		{
+			m_send_refused = true;
+			return false;
+		}
+		LslDebug("SEND: %s",msg.c_str());
+		OutgoingMessage out;
+		out.data = msg;
+		out.callback = callback;
+		m_send_lanes[priority].push_back(out);
+		m_send_stats.queued_bytes[priority] += msg.size();
+		m_queued_bytes += msg.size();
+		if (m_write_in_progress)
+			return true; //picked up by WriteCallback together with whatever else arrives meanwhile
+		m_write_in_progress = true;
+	}
+	m_netservice->post(boost::bind(&Socket::StartWrite, this));
+	return true;
+}
+
+size_t Socket::GetQueuedBytes() const
+{
+	boost::mutex::scoped_lock lock(m_send_mutex);
+	return m_queued_bytes;
+}
+
+SendStatistics Socket::GetSendStatistics() const
+{
+	boost::mutex::scoped_lock lock(m_send_mutex);
+	return m_send_stats;
+}
+
+void Socket::StartWrite()
+{
+	{
+		boost::mutex::scoped_lock lock(m_send_mutex);
+		assert(m_send_inflight.empty());
+		const TokenBucket::TimePoint now = TokenBucket::Now();
+		bool pending = false;
+		for (int lane = 0; lane < Enum::SP_Count; ++lane)
+		{
+			SendQueue& queue = m_send_lanes[lane];
+			while (!queue.empty() && m_bucket.Available(now))
+			{
+				m_send_inflight.push_back(OutgoingMessage());
+				m_send_inflight.back().data.swap(queue.front().data);
+				m_send_inflight.back().callback.swap(queue.front().callback);
+				queue.pop_front();
+				const size_t size = m_send_inflight.back().data.size();
+				m_bucket.Consume(size);
+				m_send_stats.queued_bytes[lane] -= size;
+			}
+			pending = pending || !queue.empty();
+		}
+		if (m_send_inflight.empty())
+		{
+			if (!pending)
+			{
+				m_write_in_progress = false;
+				return;
+			}
+			//out of tokens, come back once the bucket refilled
+			const TokenBucket::Duration delay = m_bucket.Delay(now);
+			m_send_stats.throttle_count++;
+			m_send_stats.throttle_seconds += delay.total_microseconds() / 1e6;
+			m_send_timer.expires_from_now(delay);
+			m_send_timer.async_wait(boost::bind(&Socket::SendTimerCallback, this, BA::placeholders::error));
+			return;
+		}
+	}
+	//deque elements don't move while only the network thread touches m_send_inflight
+	m_send_buffers.clear();
+	for (SendQueue::const_iterator it = m_send_inflight.begin(); it != m_send_inflight.end(); ++it)
+		m_send_buffers.push_back(BA::buffer(it->data));
+	BA::async_write(m_sock, m_send_buffers, boost::bind(&Socket::WriteCallback, this, BA::placeholders::error, BA::placeholders::bytes_transferred));
+}
+
+void Socket::SendTimerCallback(const boost::system::error_code &error)
+{
+	if (error || !m_sock.is_open())
+	{
+		FailQueuedSends(error ? error.message() : "socket closed");
+		return;
+	}
+	StartWrite();
+}
+
+void Socket::WriteCallback(const boost::system::error_code &error, size_t bytes)
+{
+	SendQueue done;
+	done.swap(m_send_inflight);
+	bool writable = false;
+	{
+		boost::mutex::scoped_lock lock(m_send_mutex);
+		m_queued_bytes -= std::min(m_queued_bytes, bytes);
+		m_send_stats.sent_bytes += bytes;
+		if (m_send_refused && m_queued_bytes < m_send_high_water)
+		{
+			m_send_refused = false;
+			writable = true;
+		}
+	}
+	const std::string errmsg = error ? error.message() : std::string();
+	for (SendQueue::const_iterator it = done.begin(); it != done.end(); ++it)
+	{
+		if (it->callback)
+			it->callback(!error, errmsg);
+	}
+	if (error)
+	{
+		if (m_sock.is_open())
+			sig_networkError(errmsg);
+		FailQueuedSends(errmsg);
+		return;
+	}
+	if (writable)
+		sig_sendQueueWritable();
+	StartWrite();
+}
+
+void Socket::FailQueuedSends(const std::string& error)
+{
+	SendQueue dropped;
+	{
+		boost::mutex::scoped_lock lock(m_send_mutex);
+		for (int lane = 0; lane < Enum::SP_Count; ++lane)
+		{
+			dropped.insert(dropped.end(), m_send_lanes[lane].begin(), m_send_lanes[lane].end());
+			m_send_lanes[lane].clear();
+			m_send_stats.queued_bytes[lane] = 0;
+		}
+		m_queued_bytes = 0;
+		m_write_in_progress = false;
+	}
+	for (SendQueue::const_iterator it = dropped.begin(); it != dropped.end(); ++it)
 	{
-        LslDebug("SEND: %s",msg.c_str());
-		return m_sock.send(boost::asio::buffer(msg));
+		if (it->callback)
+			it->callback(false, error);
 	}
-    return false;
 }
 
 } // namespace LSL
@@ -2,11 +2,20 @@
 #define LSL_SOCKET_H
 
 #include <boost/signals2/signal.hpp>
-#include <boost/asio/streambuf.hpp>
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <vector>
 
 #include "enums.h"
+#include "lineframer.h"
+#include "ratelimiter.h"
+#include "capture.h"
 
 namespace LSL {
 
@@ -14,38 +23,102 @@ namespace LSL {
 class Socket
 {
 public:
-	//! cmd_name,params
-	boost::signals2::signal<void (std::string,std::string)> sig_dataReceived;
+	//! cmd_name,params; views into the receive buffer, copy what you need to keep
+	boost::signals2::signal<void (StringRef,StringRef)> sig_dataReceived;
+	//! every complete line of one read went out through sig_dataReceived
+	boost::signals2::signal<void ()> sig_receiveBatchDone;
 	//! connect_success,msg_if_failed
 	boost::signals2::signal<void (bool,std::string)> sig_doneConnecting;
 	//! the actual asio::tcp::socket got disconnected
 	boost::signals2::signal<void ()> sig_socketDisconnected;
 	//! error_msg
 	boost::signals2::signal<void (std::string)> sig_networkError;
+	//! the send queue drained below the high-water mark after SendData refused a message
+	boost::signals2::signal<void ()> sig_sendQueueWritable;
+
+	//! success,error_msg_if_failed; called from the network thread once the message left or was dropped
+	typedef boost::function<void (bool,std::string)> SendCallback;
 
 	Enum::SocketState State() const;
 
     Socket();
     virtual ~Socket();
 
+    //! starts the network thread on first use; all signals are emitted from that thread
     void Connect(const std::string& server, int port);
-    void Disconnect() {}
-
-	bool SendData(const std::string& msg);
-
+    //! closes the connection from the network thread, sig_socketDisconnected follows
+    void Disconnect();
+
+    //! runs \param task on the network thread, right away if there is none yet
+    void Post(const boost::function<void ()>& task);
+    //! called from the network thread, or before Connect started it
+    bool InNetworkThread() const;
+
+	/** \brief queue \param msg for an asynchronous write
+	 * Lanes are drained in \param priority order whenever the send rate limit holds messages back.
+	 * \return false if not connected or the queue is above the high-water mark, \param callback is not called then
+	 */
+	bool SendData(const std::string& msg, const SendCallback& callback = SendCallback(),
+				  Enum::SendPriority priority = Enum::SP_Normal);
+	void SetSendHighWaterMark( size_t bytes ) { m_send_high_water = bytes; }
+	size_t GetSendHighWaterMark() const { return m_send_high_water; }
+	//! bytes waiting to be written, including the batch currently in flight
+	size_t GetQueuedBytes() const;
+	SendStatistics GetSendStatistics() const;
+
+    //! bytes per second, enforced by a token bucket; -1 disables limiting
     void SetSendRateLimit( int Bps = -1 );
     int GetSendRateLimit() const { return m_rate; }
     std::string GetHandle() const;
 	bool InTimeout( int timeout_seconds ) const;
     std::string GetLocalAddress() const;
 
+	//! record everything received from now on into \param filename, for offline replay; not synchronised with a running receive
+	bool StartCapture( const std::string& filename );
+	void StopCapture();
+
 private:
     void ConnectCallback(const boost::system::error_code& error);
     void ReceiveCallback(const boost::system::error_code& error, size_t bytes);
-
-	boost::asio::io_service m_netservice;
+    void AsyncReceive();
+    void OnLine(StringRef command, StringRef params);
+    void StartWrite();
+    void WriteCallback(const boost::system::error_code& error, size_t bytes);
+    void SendTimerCallback(const boost::system::error_code& error);
+    void FailQueuedSends(const std::string& error);
+    void CloseSocket();
+
+    struct OutgoingMessage
+    {
+        std::string data;
+        SendCallback callback;
+    };
+    typedef std::deque<OutgoingMessage> SendQueue;
+
+	//! shared with the network thread, which may outlive the socket, see ~Socket
+	boost::shared_ptr<boost::asio::io_service> m_netservice;
 	boost::asio::ip::tcp::socket m_sock;
-	boost::asio::streambuf m_incoming_buffer;
+	//! keeps m_netservice running between connections, reset in the dtor
+	boost::scoped_ptr<boost::asio::io_service::work> m_work;
+	boost::scoped_ptr<boost::thread> m_netthread;
+	LineFramer m_framer;
+	LineFramer::LineHandler m_line_handler;
+	//! start of the region the pending async_read_some writes to
+	const char* m_receive_data;
+	CaptureWriter m_capture;
+	mutable boost::mutex m_send_mutex;
+	//! messages waiting for the next write, one queue per Enum::SendPriority
+	SendQueue m_send_lanes[Enum::SP_Count];
+	//! batch owned by the running async_write, gathered into m_send_buffers
+	SendQueue m_send_inflight;
+	std::vector<boost::asio::const_buffer> m_send_buffers;
+	TokenBucket m_bucket;
+	boost::asio::deadline_timer m_send_timer;
+	SendStatistics m_send_stats;
+	size_t m_queued_bytes;
+	size_t m_send_high_water;
+	bool m_write_in_progress;
+	bool m_send_refused;
     int m_rate;
 	time_t m_last_net_packet;
 };
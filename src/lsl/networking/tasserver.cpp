@@ -8,6 +8,7 @@
 #include <lslutils/md5.h>
 #include <lslutils/conversion.h>
 #include <lslutils/debug.h>
+#include <lslutils/pool.h>
 #include <lsl/battle/battle.h>
 
 #include "socket.h"
@@ -25,25 +26,28 @@ ServerImpl::ServerImpl(Server *serv)
     , m_ping_timeout(40)
     , m_ping_interval(10)
     , m_server_rate_limit(800)
-    , m_message_size_limit(1024)
+    , m_buffer("")
+    , m_ingesting_login( false )
     , m_id_transmission( true )
     , m_redirecting( false )
     , m_connected(false)
     , m_online(false)
     , m_udp_private_port(0)
     , m_udp_reply_timeout(0)
-    , m_buffer("")
+    , m_message_size_limit(1024)
     , m_iface( serv )
 {
-    m_sock->sig_dataReceived.connect( boost::bind( &ServerImpl::ExecuteCommand, this, _1, _2 ) );
+    m_sock->sig_dataReceived.connect( boost::bind( &ServerImpl::OnDataReceived, this, _1, _2 ) );
+    m_sock->sig_receiveBatchDone.connect( boost::bind( &ServerImpl::OnReceiveBatchDone, this ) );
 }
 
-void ServerImpl::ExecuteCommand(const std::string& cmd, std::string& inparams, int replyid )
+void ServerImpl::ExecuteCommand( const boost::string_ref cmd, const boost::string_ref params, int replyid )
 {
-    if ( cmd == "PONG")
-        m_iface->HandlePong( replyid );
-    else
-		m_cmd_dict->Process(cmd,inparams);
+    if ( cmd != "PONG" )
+		m_cmd_dict->Process( cmd, params );
+	// the reply goes to the requester after the state update it implies
+	if ( replyid )
+		m_requests.Complete( replyid, cmd, params );
 }
 
 void ServerImpl::GetInGameTime(const std::string& user)
@@ -113,8 +117,13 @@ void ServerImpl::_Disconnect(const std::string& reason)
 
 void ServerImpl::Ping()
 {
-    SendCmd("PING");
-    GetPingList()[GetLastPingID()] = time(0);
+    SendCmd( "PING", "", boost::bind( &ServerImpl::OnPingReply, this, _1 ), m_ping_timeout * 1000 );
+}
+
+void ServerImpl::OnPingReply( const RequestReply& reply )
+{
+    if ( reply.success )
+        m_iface->sig_Pong( reply.rtt_us / 1000000 );
 }
 
 void ServerImpl::GetLastLoginTime(const std::string& user)
@@ -224,6 +233,41 @@ void ServerImpl::AcceptAgreement()
 	SendCmd( "CONFIRMAGREEMENT" );
 }
 
+void ServerImpl::OnDataReceived( boost::string_ref cmd, boost::string_ref params )
+{
+	int replyid = 0;
+	if ( !cmd.empty() && cmd[0] == '#' )
+	{
+		// "#id CMD params": the id is split off without copying the line
+		replyid = Util::ParseLong( cmd.data() + 1, cmd.data() + cmd.size() );
+		const size_t sep = params.find( ' ' );
+		cmd = params.substr( 0, sep );
+		params = ( sep == boost::string_ref::npos ) ? boost::string_ref() : params.substr( sep + 1 );
+	}
+	// we're on the network thread, a throwing handler must not end the receive loop
+	try {
+		ExecuteCommand( cmd, params, replyid );
+	}
+	catch ( std::exception& e ) {
+		LslError( "handling %s failed: %s", cmd.to_string().c_str(), e.what() );
+	}
+}
+
+void ServerImpl::OnReceiveBatchDone()
+{
+	// the login burst spans many reads, it is published as a whole at LOGININFOEND
+	if ( m_ingesting_login )
+		return;
+	m_battle_queries.Flush( m_battles );
+	m_snapshots.Publish( m_users, m_battles );
+}
+
+void ServerImpl::TouchBattle( int battleid )
+{
+	m_snapshots.TouchBattle( battleid );
+	m_battle_queries.Touch( battleid );
+}
+
 void ServerImpl::ExecuteCommand( const std::string& cmd, std::string& params )
 {
 	int replyid = 0;
@@ -236,21 +280,61 @@ void ServerImpl::ExecuteCommand( const std::string& cmd, std::string& params )
 	ExecuteCommand( cmd, params, replyid );
 }
 
-void ServerImpl::SendCmd( const std::string& cmd, const std::string& param )
+//! keepalive must never wait behind a host's option sync, or the server drops us
+static Enum::SendPriority GetSendPriority( const std::string& cmd )
 {
+	if ( cmd == "PING" )
+		return Enum::SP_Urgent;
+	if ( cmd == "SETSCRIPTTAGS" || cmd == "REMOVESCRIPTTAGS"
+		 || cmd == "ADDSTARTRECT" || cmd == "REMOVESTARTRECT"
+		 || cmd == "DISABLEUNITS" || cmd == "ENABLEUNITS" || cmd == "ENABLEALLUNITS"
+		 || cmd == "SCRIPTSTART" || cmd == "SCRIPT" || cmd == "SCRIPTEND" )
+		return Enum::SP_Bulk;
+	return Enum::SP_Normal;
+}
+
+int ServerImpl::SendCmd( const std::string& cmd, const std::string& param, const RequestCallback& on_reply, int timeout_ms )
+{
+    if ( on_reply && !m_id_transmission )
+    {
+        RequestReply reply;
+        reply.error = "message ids are disabled";
+        on_reply( reply );
+        return 0;
+    }
     std::string msg;
+    int id;
     if ( m_id_transmission )
     {
-        GetLastID()++;
-        msg = msg + "#" + Util::ToString( GetLastID() ) + " ";
+        id = ++GetLastID();
+        msg = msg + "#" + Util::ToString( id ) + " ";
     }
+    else
+        id = GetLastID();
     if ( param.empty() )
         msg = msg + cmd + "\n";
     else
         msg = msg + cmd + " " + param + "\n";
-	bool send_success = m_sock->SendData( msg );
-    assert( send_success );
-//	sig_SentMessage(send_success, msg, GetLastID());
+	// registered before sending, the reply may arrive before SendData returns
+	if ( on_reply )
+		m_requests.Add( id, cmd, timeout_ms, on_reply );
+	if ( !m_sock->SendData( msg, boost::bind( &ServerImpl::OnCmdSent, this, _1, _2, msg, id ), GetSendPriority( cmd ) ) )
+	{
+		LslWarning( "send queue full or not connected, dropped: %s", msg.c_str() );
+		m_iface->sig_SentMessage( false, msg, id );
+		m_requests.Fail( id, "send queue full or not connected" );
+	}
+	return id;
+}
+
+void ServerImpl::OnCmdSent( bool success, const std::string& error, const std::string& msg, int id )
+{
+	if ( !success )
+	{
+		LslWarning( "sending %s failed: %s", msg.c_str(), error.c_str() );
+		m_requests.Fail( id, error );
+	}
+	m_iface->sig_SentMessage( success, msg, id );
 }
 
 void ServerImpl::JoinChannel( const std::string& channel, const std::string& key )
@@ -541,10 +625,10 @@ ChannelPtr ServerImpl::GetCreatePrivateChannel( const UserPtr user )
 {
     if (!user) return ChannelPtr();
     std::string channame = "U" + Util::ToString(user->Id());
-    ChannelPtr channel = m_channels.Get( channame );
+    ChannelPtr channel = m_channels.Find( channame );
     if (!channel)
     {
-        channel = m_channels.Add( new Channel( channame ) );
+        channel = m_channels.Add( Util::MakePooled<Channel>( channame ) );
         m_iface->OnUserJoinedChannel( channel, user );
         m_iface->OnUserJoinedChannel( channel, m_me );
     }
@@ -563,7 +647,7 @@ void ServerImpl::RequestInGameTime( const std::string& nick )
 
 BattlePtr ServerImpl::AddBattle(const int &id)
 {
-    BattlePtr b( new Battle::Battle(m_iface->shared_from_this(), id) );
+    BattlePtr b = Util::MakePooled<Battle::Battle>( m_iface->shared_from_this(), id );
     m_battles.Add(b);
     return b;
 }
@@ -592,18 +676,25 @@ void ServerImpl::OnAcceptAgreement()
 void ServerImpl::OnNewUser( const std::string& nick, const std::string& country, int cpu, int id )
 {
     std::string str_id;
-    if ( !id )
+    if ( id )
         str_id = Util::ToString(id);
     else
         str_id = User::GetNewUserId();
-    UserPtr user = m_users.Get( str_id );
+    UserPtr user = m_users.Find( str_id );
     if ( !user )  {
-        user = UserPtr( new User( m_iface->shared_from_this(), str_id, nick, country, cpu ) );
+        user = Util::MakePooled<User>( m_iface->shared_from_this(), str_id, nick, country, cpu );
+        m_users.Add( user );
     }
 	user->SetCountry( country );
 	user->SetCpu( cpu );
-	user->SetNick( nick );
-    m_iface->OnNewUser( user );
+	m_users.Rename( user, nick );
+    if ( nick == m_login_nick )
+        m_me = user;
+    m_snapshots.TouchUser( user->Id() );
+    if ( m_ingesting_login )
+        m_initial_state.users.push_back( user );
+    else
+        m_iface->OnNewUser( user );
 }
 
 std::string ServerImpl::GetBattleChannelName( const BattlePtr battle )
@@ -618,16 +709,22 @@ void ServerImpl::OnBattleOpened( int id, Enum::BattleType type, Enum::NatType na
 								   bool haspass, int rank, const std::string& maphash, const std::string& map,
 								   const std::string& title, const std::string& mod )
 {
-    BattlePtr battle = AddBattle( id );
     const UserPtr user = m_users.FindByNick( nick );
+    if ( !user ) return;
+    BattlePtr battle = AddBattle( id );
     battle->OnUserAdded( user );
+    TouchBattle( id );
+    m_snapshots.TouchUser( user->Id() );
 	battle->SetBattleType( type );
 	battle->SetNatType( nat );
 	battle->SetIsPassworded( haspass );
 	battle->SetRankNeeded( rank );
 	battle->SetDescription( title );
 
-    m_iface->OnBattleOpened( battle );
+    if ( m_ingesting_login )
+        m_initial_state.battles.push_back( battle );
+    else
+        m_iface->OnBattleOpened( battle );
     m_iface->OnBattleHostChanged( battle, user, host, port );
     if (user) m_iface->OnUserIP( user, host );
     m_iface->OnBattleMaxPlayersChanged(battle, maxplayers );
@@ -635,27 +732,33 @@ void ServerImpl::OnBattleOpened( int id, Enum::BattleType type, Enum::NatType na
     m_iface->OnBattleModChanged( battle, UnitsyncMod(mod, "") );
 
     const std::string battlechanname = m_battles.GetChannelName(battle);
-    ChannelPtr channel = m_channels.Get( battlechanname );
+    ChannelPtr channel = m_channels.Find( battlechanname );
 	if (!channel)
 	{
-        m_channels.Add( channel );
+        channel = m_channels.Add( Util::MakePooled<Channel>( battlechanname ) );
 		battle->SetChannel( channel );
 	}
 
 	if ( user->Status().in_game )
 	{
-        m_iface->OnBattleStarted(battle);
+		battle->SetInGame( true );
+		if ( !m_ingesting_login )
+			m_iface->OnBattleStarted(battle);
 	}
 }
 
 void ServerImpl::OnUserStatusChanged( const std::string& nick, int intstatus )
 {
-    const ConstUserPtr user = m_users.FindByNick( nick );
+    const UserPtr user = m_users.FindByNick( nick );
 	if (!user) return;
 	UTASClientStatus tasstatus;
 	tasstatus.byte = intstatus;
     const UserStatus status = ConvTasclientstatus( tasstatus.tasdata );
-    m_iface->sig_UserStatusChanged( user, status );
+    user->SetStatus( status );
+    m_snapshots.TouchUser( user->Id() );
+    //the login snapshot carries the statuses, no per user signal for those
+    if ( !m_ingesting_login )
+        m_iface->sig_UserStatusChanged( user, status );
     IBattlePtr battle = user->GetBattle();
 	if ( battle )
 	{
@@ -663,6 +766,9 @@ void ServerImpl::OnUserStatusChanged( const std::string& nick, int intstatus )
             if ( status.in_game != battle->InGame() )
 			{
 				battle->SetInGame( status.in_game );
+				TouchBattle( battle->Id() );
+                if ( m_ingesting_login )
+                    return;
                 if ( status.in_game )
                     m_iface->OnBattleStarted( battle );
                 else
@@ -673,7 +779,7 @@ void ServerImpl::OnUserStatusChanged( const std::string& nick, int intstatus )
 
 void ServerImpl::OnHostedBattle( int battleid )
 {
-    const BattlePtr battle = m_battles.Get( battleid );
+    const BattlePtr battle = m_battles.Find( battleid );
 	if(!battle) return;
     m_iface->OnSelfHostedBattle(battle);
     m_iface->OnSelfJoinedBattle(battle);
@@ -683,12 +789,16 @@ void ServerImpl::OnUserQuit(const std::string &nick )
 {
     const UserPtr user = m_users.FindByNick( nick );
 	if ( !user ) return;
+    m_snapshots.TouchUser( user->Id() );
+    const IBattlePtr battle = user->GetBattle();
+    if ( battle )
+        TouchBattle( battle->Id() );
     m_iface->OnUserQuit( user );
 }
 
 void ServerImpl::OnSelfJoinedBattle( int battleid, const std::string& hash )
 {
-    BattlePtr battle = m_battles.Get( battleid );
+    BattlePtr battle = m_battles.Find( battleid );
 	if ( !battle ) return;
     m_current_battle = battle;
     battle->SetHostMod( battle->GetHostModName(), hash );
@@ -703,6 +813,7 @@ void ServerImpl::OnStartHostedBattle()
 {
     IBattlePtr battle = m_current_battle;
 	battle->SetInGame( true );
+    TouchBattle( battle->Id() );
     m_iface->OnBattleStarted( battle );
 }
 
@@ -726,19 +837,22 @@ void ServerImpl::OnClientBattleStatus( const std::string& nick, int intstatus, i
 
 void ServerImpl::OnUserJoinedBattle( int battleid, const std::string& nick, const std::string& userScriptPassword )
 {
-    BattlePtr battle = m_battles.Get( battleid );
+    BattlePtr battle = m_battles.Find( battleid );
 	if ( !battle ) return;
     UserPtr user = m_users.FindByNick( nick );
 	if ( !user ) return;
     battle->OnUserAdded( user );
-    m_iface->OnUserJoinedBattle( battle, user );
+    TouchBattle( battleid );
+    m_snapshots.TouchUser( user->Id() );
+    if ( !m_ingesting_login )
+        m_iface->OnUserJoinedBattle( battle, user );
     if ( user == m_me ) m_current_battle = battle;
     m_iface->OnUserScriptPassword( user, userScriptPassword );
     const ChannelPtr channel = battle->GetChannel();
     if (channel)
         m_iface->OnUserJoinedChannel( channel, user );
 
-    if ( user == battle->GetFounder() )
+    if ( user == battle->GetFounder() && !m_ingesting_login )
 	{
 		if ( user->Status().in_game )
 		{
@@ -750,10 +864,12 @@ void ServerImpl::OnUserJoinedBattle( int battleid, const std::string& nick, cons
 void ServerImpl::OnUserLeftBattle( int battleid, const std::string& nick )
 {
     UserPtr user = m_users.FindByNick(nick);
-    BattlePtr battle = m_battles.Get( battleid );
+    BattlePtr battle = m_battles.Find( battleid );
 	if (!user) return;
+    m_snapshots.TouchUser( user->Id() );
 	if(battle)
 	{
+        TouchBattle( battleid );
         const ChannelPtr channel = battle->GetChannel();
         if (channel)
             m_iface->OnUserLeftChannel( channel, user );
@@ -764,8 +880,9 @@ void ServerImpl::OnUserLeftBattle( int battleid, const std::string& nick )
 
 void ServerImpl::OnBattleInfoUpdated( int battleid, int spectators, bool locked, const std::string& maphash, const std::string& mapname )
 {
-    BattlePtr battle = m_battles.Get( battleid );
+    BattlePtr battle = m_battles.Find( battleid );
 	if ( !battle ) return;
+    TouchBattle( battleid );
     if (battle->GetSpectators() != spectators )
         m_iface->OnBattleSpectatorCountUpdated( battle, spectators );
     if (battle->IsLocked() != locked )
@@ -792,7 +909,7 @@ void ServerImpl::OnSetBattleOption( std::string key, const std::string& value )
             int team = Util::FromString<int>( Util::BeforeFirst(key,"/").substr( 4, std::string::npos ) );
             if ( key.find( "startposx" ) != std::string::npos )
 			{
-                BOOST_FOREACH( const CommonUserPtr player, battle->Users() )
+                BOOST_FOREACH( const CommonUserPtr& player, battle->UserRange() )
 				{
                     UserBattleStatus& status = player->BattleStatus();
 					if ( status.team == team )
@@ -804,7 +921,7 @@ void ServerImpl::OnSetBattleOption( std::string key, const std::string& value )
 			 }
              else if ( key.find( "startposy" ) != std::string::npos )
 			 {
-                BOOST_FOREACH( const CommonUserPtr player, battle->Users() )
+                BOOST_FOREACH( const CommonUserPtr& player, battle->UserRange() )
 				{
                     UserBattleStatus& status = player->BattleStatus();
 					if ( status.team == team )
@@ -835,8 +952,11 @@ void ServerImpl::OnSetBattleInfo( std::string infos )
 
 void ServerImpl::OnBattleClosed( int battleid )
 {
-    BattlePtr battle = m_battles.Get( battleid );
+    BattlePtr battle = m_battles.Find( battleid );
 	if (!battle) return;
+    TouchBattle( battleid );
+    BOOST_FOREACH( const CommonUserPtr& user, battle->UserRange() )
+        m_snapshots.TouchUser( user->Id() );
     m_iface->OnBattleClosed(battle);
 }
 
@@ -873,21 +993,21 @@ void ServerImpl::OnBattleEnableAllUnits()
 
 void ServerImpl::OnJoinChannel(const std::string& channel , const std::string &rest)
 {
-    ChannelPtr chan = m_channels.Get( "#" + channel );
-    if(!chan) return;
+    ChannelPtr chan = m_channels.Find( "#" + channel );
+    if(!chan) chan = m_channels.Add( Util::MakePooled<Channel>("#" + channel) );
     m_iface->OnUserJoinedChannel( chan, m_me );
 }
 
 void ServerImpl::OnJoinChannelFailed( const std::string& name, const std::string& reason )
 {
-    ChannelPtr chan = m_channels.Get( "#" + name );
-    if(!chan) chan = m_channels.Add( new Channel("#" + name) );
+    ChannelPtr chan = m_channels.Find( "#" + name );
+    if(!chan) chan = m_channels.Add( Util::MakePooled<Channel>("#" + name) );
     m_iface->OnJoinChannelFailed( chan, reason );
 }
 
 void ServerImpl::OnChannelJoin( const std::string& name, const std::string& who )
 {
-    ChannelPtr channel = m_channels.Get( "#" + name );
+    ChannelPtr channel = m_channels.Find( "#" + name );
     UserPtr user = m_users.FindByNick( who );
     if(!channel) return;
 	if(!user) return;
@@ -896,7 +1016,7 @@ void ServerImpl::OnChannelJoin( const std::string& name, const std::string& who
 
 void ServerImpl::OnChannelJoinUserList( const std::string& channel_name, const std::string& usernames )
 {
-    ChannelPtr channel = m_channels.Get( "#" + channel_name );
+    ChannelPtr channel = m_channels.Find( "#" + channel_name );
 	if(!channel) return;
     UserVector users;
     BOOST_FOREACH( const std::string nick, Util::StringTokenize(usernames," ") )
@@ -920,12 +1040,15 @@ void ServerImpl::OnGetHandle()
 
 void ServerImpl::OnLogin(const std::string &msg)
 {
-	assert( false );
+    m_login_nick = msg;
+    m_ingesting_login = true;
+    m_initial_state = InitialState();
+    m_iface->OnLogin( m_users.FindByNick( msg ) );
 }
 
 void ServerImpl::OnUserJoinedChannel( const std::string& channel_name, const std::string& who )
 {
-    ChannelPtr channel = m_channels.Get( "#" + channel_name );
+    ChannelPtr channel = m_channels.Find( "#" + channel_name );
     UserPtr user = m_users.FindByNick( who );
 	if(!channel) return;
 	if(!user) return;
@@ -934,7 +1057,7 @@ void ServerImpl::OnUserJoinedChannel( const std::string& channel_name, const std
 
 void ServerImpl::OnChannelSaid( const std::string& channel_name, const std::string& who, const std::string& message )
 {
-    ChannelPtr channel = m_channels.Get( "#" + channel_name );
+    ChannelPtr channel = m_channels.Find( "#" + channel_name );
     UserPtr user = m_users.FindByNick( who );
 	if(!channel) return;
 	if(!user) return;
@@ -943,7 +1066,7 @@ void ServerImpl::OnChannelSaid( const std::string& channel_name, const std::stri
 
 void ServerImpl::OnChannelPart( const std::string& channel_name, const std::string& who, const std::string& message )
 {
-    ChannelPtr channel = m_channels.Get( "#" + channel_name );
+    ChannelPtr channel = m_channels.Find( "#" + channel_name );
     UserPtr user = m_users.FindByNick( who );
 	if(!channel) return;
 	if(!user) return;
@@ -952,7 +1075,7 @@ void ServerImpl::OnChannelPart( const std::string& channel_name, const std::stri
 
 void ServerImpl::OnChannelTopic( const std::string& channel_name, const std::string& who, int /*unused*/, const std::string& message )
 {
-    ChannelPtr channel = m_channels.Get( "#" + channel_name );
+    ChannelPtr channel = m_channels.Find( "#" + channel_name );
 	if(!channel) return;
     UserPtr user = m_users.FindByNick( who );
     if(!user) return;
@@ -962,7 +1085,7 @@ void ServerImpl::OnChannelTopic( const std::string& channel_name, const std::str
 
 void ServerImpl::OnChannelAction( const std::string& channel_name, const std::string& who, const std::string& action )
 {
-    ChannelPtr channel = m_channels.Get( "#" + channel_name );
+    ChannelPtr channel = m_channels.Find( "#" + channel_name );
     UserPtr user = m_users.FindByNick( who );
 	if(!channel) return;
 	if(!user) return;
@@ -1082,7 +1205,7 @@ void ServerImpl::OnMutelistItem( const std::string& mutee, const std::string& me
 
 void ServerImpl::OnMutelistEnd()
 {
-    ChannelPtr chan = m_channels.Get("#" + m_mutelist_current_channelname);
+    ChannelPtr chan = m_channels.Find("#" + m_mutelist_current_channelname);
     m_mutelist_current_channelname = "";
 	if (!chan) return;
     m_iface->OnMuteList(chan, m_mutelist);
@@ -1090,7 +1213,7 @@ void ServerImpl::OnMutelistEnd()
 
 void ServerImpl::OnChannelMessage( const std::string& channel, const std::string& msg )
 {
-    ChannelPtr chan = m_channels.Get(channel);
+    ChannelPtr chan = m_channels.Find(channel);
 	if (!chan) return;
     m_iface->OnChannelMessage( chan, msg );
 }
@@ -1108,7 +1231,7 @@ void ServerImpl::OnKickedFromBattle()
 
 void ServerImpl::OnKickedFromChannel( const std::string& channel, const std::string& fromWho, const std::string& message)
 {
-    ChannelPtr chan = m_channels.Get(channel);
+    ChannelPtr chan = m_channels.Find(channel);
 	if(!chan) return;
     m_iface->OnKickedFromChannel(chan, fromWho, message);
     m_iface->OnUserLeftChannel(chan, m_me );
@@ -1143,10 +1266,10 @@ void ServerImpl::OnHostExternalUdpPort( const int udpport )
 
 void ServerImpl::OnChannelListEntry( const std::string& channel, const int& numusers, const std::string& topic )
 {
-    ChannelPtr chan = m_channels.Get( "#" + channel );
+    ChannelPtr chan = m_channels.Find( "#" + channel );
 	if (!chan)
 	{
-        chan = m_channels.Add( new Channel( "#" + channel ) );
+        chan = m_channels.Add( Util::MakePooled<Channel>( "#" + channel ) );
 	}
 	chan->SetNumUsers(numusers);
 	chan->SetTopic(topic);
@@ -1164,7 +1287,7 @@ void ServerImpl::OnRequestBattleStatus()
 
 void ServerImpl::OnBattleAddBot( int battleid, const std::string& nick, const std::string& owner, int intstatus, int intcolor, const std::string& aidll)
 {
-    BattlePtr battle = m_battles.Get(battleid);
+    BattlePtr battle = m_battles.Find(battleid);
 	if (!battle) return;
 	UTASBattleStatus tasbstatus;
 	UserBattleStatus status;
@@ -1173,17 +1296,18 @@ void ServerImpl::OnBattleAddBot( int battleid, const std::string& nick, const st
 	status = ConvTasbattlestatus( tasbstatus.tasdata );
 	color.data = intcolor;
     status.color = lslColor( color.color.red, color.color.green, color.color.blue );
-	status.aishortname = aidll;
-    status.owner = owner;
-    UserPtr user( new User( m_iface->shared_from_this(), User::GetNewUserId(), nick ) );
+	status.MutableExtras().aishortname = aidll;
+    status.MutableExtras().owner = owner;
+    UserPtr user = Util::MakePooled<User>( m_iface->shared_from_this(), User::GetNewUserId(), nick );
     battle->OnUserAdded( user );
+    TouchBattle( battleid );
     m_iface->OnUserJoinedBattle( battle, user );
     m_iface->OnUserBattleStatusUpdated( battle, user, status );
 }
 
 void ServerImpl::OnBattleUpdateBot( int battleid, const std::string& nick, int intstatus, int intcolor )
 {
-    BattlePtr battle = m_battles.Get(battleid);
+    BattlePtr battle = m_battles.Find(battleid);
 	if (!battle) return;
 	UTASBattleStatus tasbstatus;
 	UserBattleStatus status;
@@ -1198,10 +1322,11 @@ void ServerImpl::OnBattleUpdateBot( int battleid, const std::string& nick, int i
 
 void ServerImpl::OnBattleRemoveBot( int battleid, const std::string& nick )
 {
-    BattlePtr battle = m_battles.Get(battleid);
+    BattlePtr battle = m_battles.Find(battleid);
 	if (!battle) return;
     CommonUserPtr user = battle->GetUser( nick );
 	if (!user ) return;
+    TouchBattle( battleid );
     m_iface->OnUserLeftBattle( battle, user );
     if (user->BattleStatus().IsBot())
         m_iface->OnUserQuit( user );
@@ -1232,11 +1357,22 @@ void ServerImpl::Ring( const ConstCommonUserPtr user )
 
 void ServerImpl::OnConnected(const std::string &, const int, const std::string &, const int)
 {
+    m_iface->sig_Connected();
 }
 
 void ServerImpl::OnLoginInfoComplete()
 {
-    //TODO: event
+    InitialState state;
+    std::swap( state, m_initial_state );
+    m_ingesting_login = false;
+    state.channels = m_channels.Vectorize();
+    //the one per-user check Server::OnNewUser does, without calling it for everyone
+    const UserPtr relay_manager = m_users.FindByNick( "RelayHostManagerList" );
+    if ( relay_manager )
+        m_iface->OnNewUser( relay_manager );
+    m_battle_queries.Flush( m_battles );
+    m_snapshots.Publish( m_users, m_battles );
+    m_iface->sig_InitialStateReady( state );
 }
 
 void ServerImpl::OnChannelListEnd()
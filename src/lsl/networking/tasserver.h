@@ -5,6 +5,7 @@
 
 #include <lslutils/type_forwards.h>
 #include <boost/format/format_fwd.hpp>
+#include <boost/utility/string_ref_fwd.hpp>
 
 namespace LSL {
 
@@ -14,6 +15,7 @@ class Server;
 class ServerImpl
 {
     friend class Server;
+    friend class ProtocolReplay;
 private:
     ServerImpl( Server* serv );
 
@@ -68,14 +70,26 @@ private:
 	std::string GetBattleChannelName(const BattlePtr battle);
 
 private:
+	//! slot for Socket::sig_dataReceived, the views are only valid during the call
+	void OnDataReceived( boost::string_ref cmd, boost::string_ref params );
+	//! slot for Socket::sig_receiveBatchDone, publishes what the batch changed
+	void OnReceiveBatchDone();
+	//! \param battleid changed, for the snapshot and the battle queries
+	void TouchBattle( int battleid );
 	void ExecuteCommand( const std::string& cmd, std::string& inparams );
-	void ExecuteCommand( const std::string& cmd, std::string& inparams, int replyid );
+	void ExecuteCommand( const boost::string_ref cmd, const boost::string_ref params, int replyid );
 
 	void OnNewUser( const std::string& nick, const std::string& country, int cpu, int id );
 
-    void SendCmd(const std::string& cmd, const std::string& param = "" );
+    /** \return the message id the command went out with
+     * With \param on_reply set, the first reply carrying that id is handed to it, see RequestTracker.
+     */
+    int SendCmd(const std::string& cmd, const std::string& param = "",
+                const RequestCallback& on_reply = RequestCallback(), int timeout_ms = 0 );
 	void SendCmd( const std::string& command, const boost::format& param );
 	void SendRaw(const std::string &raw);
+	//! completion of an async SendCmd, forwarded to Server::sig_SentMessage
+	void OnCmdSent( bool success, const std::string& error, const std::string& msg, int id );
 	void RequestInGameTime(const std::string &nick);
 
     BattlePtr AddBattle( const int& id );
@@ -96,6 +110,7 @@ private:
     void Ring(const ConstCommonUserPtr user );
     void _Disconnect(const std::string& reason);
     void Ping();
+    void OnPingReply( const RequestReply& reply );
     void JoinBattle( const IBattlePtr battle, const std::string& password, const std::string& scriptpassword );
     void HostBattle( Battle::BattleOptions bo );
     void StartHostedBattle();
@@ -150,7 +165,7 @@ private:
 	void OnJoinChannelFailed(const std::string &channel, const std::string &reason);
 	void OnChannelJoin(const std::string &name, const std::string &who);
 	void OnChannelJoinUserList(const std::string &channel, const std::string &usernames);
-	void OnJoinedBattle(const int battleid, const std::string msg);
+	void OnJoinedBattle(const int battleid, const std::string& msg);
 	void OnGetHandle();
 	void OnLogin(const std::string& msg);
 	void OnUserJoinedChannel(const std::string &channel_name, const std::string &who);
@@ -211,6 +226,11 @@ private:
     std::string m_buffer;
     std::string m_addr;
     std::string m_last_denied;
+    //! nick the server ACCEPTED, our own ADDUSER arrives afterwards
+    std::string m_login_nick;
+    //! between ACCEPTED and LOGININFOEND: collect m_initial_state instead of per item events
+    bool m_ingesting_login;
+    InitialState m_initial_state;
     bool m_id_transmission;
     bool m_redirecting;
     bool m_connected;
@@ -220,18 +240,11 @@ private:
     int m_udp_reply_timeout;
     time_t m_last_udp_ping;
 
-    MutexWrapper<unsigned int> m_last_ping_id;
-    unsigned int& GetLastPingID()
-    {
-        ScopedLocker<unsigned int> l_last_ping_id(m_last_ping_id);
-        return l_last_ping_id.Get();
-    }
-    MutexWrapper<PingList> m_pinglist;
-    PingList& GetPingList()
-    {
-        ScopedLocker<PingList> l_pinglist(m_pinglist);
-        return l_pinglist.Get();
-    }
+    //! requests, pings included, waiting for a reply with their message id
+    RequestTracker m_requests;
+    //! what Server::GetSnapshot hands out
+    SnapshotPublisher m_snapshots;
+    Battle::BattleQueryEngine m_battle_queries;
 
     UserPtr m_relay_host_manager;
 
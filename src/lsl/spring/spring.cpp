@@ -75,14 +75,13 @@ bool Spring::Run(const IBattlePtr battle )
     BF::path path = sett().GetCurrentUsedDataDir();
     path /= "script.txt";
     try {
-        BF::ofstream f( path );
-        if ( !f.is_open() ) {
+        TDF::FileSink f( path.string() );
+        if ( !f.Good() ) {
             LslError( "Access denied to script.txt at %s", path.string().c_str() );
         }
         battle->DisableHostStatusInProxyMode( true );
-        f << WriteScriptTxt(battle);
+        WriteScriptTxt( battle, f );
         battle->DisableHostStatusInProxyMode( false );
-        f.close();
     }
     catch ( std::exception& e ) {
         LslError( "Couldn't write script.txt, exception caught:\n %s", e.what() );
@@ -163,12 +162,11 @@ bool Spring::Run(const std::string& script)
     path /= "script.txt";
     std::string cmd = std::string(" \"" + path.string() +  "\"");
     try {
-        BF::ofstream f( path );
-        if ( !f.is_open() ) {
+        TDF::FileSink f( path.string() );
+        if ( !f.Good() ) {
             LslError( "Access denied to script.txt at %s", path.string().c_str() );
         }
-        f << script;
-        f.close();
+        f.Write( script.data(), script.size() );
     }
     catch ( std::exception& e ) {
         LslError( "Couldn't write script.txt, exception caught:\n %s", e.what() );
@@ -236,9 +234,17 @@ void Spring::OnTerminated(int event )
 
 std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
 {
-    std::stringstream ret;
+    //a 64 player script is about 20 KiB
+    TDF::BufferSink sink( 32 * 1024 );
+    WriteScriptTxt( battle, sink );
+    std::string ret;
+    sink.Swap( ret );
+    return ret;
+}
 
-    TDF::TDFWriter tdf(ret);
+void Spring::WriteScriptTxt( const IBattlePtr battle, TDF::TDFSink& sink ) const
+{
+    TDF::TDFWriter tdf( sink );
 
     // Start generating the script.
     tdf.EnterSection( "GAME" );
@@ -268,15 +274,15 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
     const ConstCommonUserPtr  me = battle->GetMe();
     tdf.Append("MyPlayerName", me->Nick() );
 
-    if ( !me->BattleStatus().scriptPassword.empty() )
+    if ( !me->BattleStatus().Extras().scriptPassword.empty() )
     {
-        tdf.Append( "MyPasswd", me->BattleStatus().scriptPassword );
+        tdf.Append( "MyPasswd", me->BattleStatus().Extras().scriptPassword );
     }
 
     if ( !battle->IsFounderMe() )
     {
         tdf.LeaveSection();
-        return ret.str();
+        return;
     }
 
     /**********************************************************************************
@@ -328,7 +334,7 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
     {
         std::set<int> parsedteams;
         unsigned int NumTeams = 0;
-        BOOST_FOREACH( const ConstCommonUserPtr usr, battle->Users() )
+        BOOST_FOREACH( const CommonUserPtr& usr, battle->UserRange() )
         {
             const UserBattleStatus& status = usr->BattleStatus();
             if ( status.spectator )
@@ -412,8 +418,8 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
     std::map<const ConstCommonUserPtr, int> player_to_number; // player -> ordernumber
     srand ( time(NULL) );
     int i = 0;
-    const unsigned int NumUsers = battle->Users().size();
-    BOOST_FOREACH( const ConstCommonUserPtr user, battle->Users() )
+    const unsigned int NumUsers = battle->GetNumUsers();
+    BOOST_FOREACH( const CommonUserPtr& user, battle->UserRange() )
     {
         const UserBattleStatus& status = user->BattleStatus();
         if ( !status.spectator )
@@ -433,9 +439,9 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
         tdf.Append( "Spectator", status.spectator );
         tdf.Append( "Rank", (int)user->GetRank() );
         tdf.Append( "IsFromDemo", int(status.isfromdemo) );
-        if ( !status.scriptPassword.empty() )
+        if ( !status.Extras().scriptPassword.empty() )
         {
-            tdf.Append( "Password", status.scriptPassword );
+            tdf.Append( "Password", status.Extras().scriptPassword );
         }
         if ( !status.spectator )
         {
@@ -456,17 +462,17 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
     if ( usync().VersionSupports( LSL::USYNC_GetSkirmishAI ) )
     {
         unsigned int i = 0;
-        BOOST_FOREACH( const ConstCommonUserPtr user, battle->Users() )
+        BOOST_FOREACH( const CommonUserPtr& user, battle->UserRange() )
         {
             const UserBattleStatus& status = user->BattleStatus();
             if ( !status.IsBot() ) continue;
             tdf.EnterSection( "AI" + Util::ToString( i ) );
             tdf.Append( "Name", user->Nick() ); // AI's nick;
-            tdf.Append( "ShortName", status.aishortname ); // AI libtype
-            tdf.Append( "Version", status.aiversion ); // AI libtype version
+            tdf.Append( "ShortName", status.Extras().aishortname ); // AI libtype
+            tdf.Append( "Version", status.Extras().aiversion ); // AI libtype version
             tdf.Append( "Team", teams_to_sorted_teams[status.team] );
             tdf.Append( "IsFromDemo", int(status.isfromdemo) );
-            tdf.Append( "Host", player_to_number[battle->GetUser( status.owner )] );
+            tdf.Append( "Host", player_to_number[battle->GetUser( status.Extras().owner )] );
             tdf.EnterSection( "Options" );
             int optionmapindex = battle->CustomBattleOptions()->GetAIOptionIndex( user->Nick() );
             if ( optionmapindex > 0 )
@@ -488,7 +494,7 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
 
     std::set<int> parsedteams;
     StringVector sides = usync().GetSides( battle->GetHostModName() );
-    BOOST_FOREACH( const ConstCommonUserPtr usr, battle->Users() )
+    BOOST_FOREACH( const CommonUserPtr& usr, battle->UserRange() )
     {
         const UserBattleStatus& status = usr->BattleStatus();
         if ( status.spectator ) continue;
@@ -498,14 +504,14 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
         tdf.EnterSection( "TEAM" + Util::ToString( teams_to_sorted_teams[status.team] ) );
         if ( !usync().VersionSupports( LSL::USYNC_GetSkirmishAI ) && status.IsBot() )
         {
-            tdf.Append( "AIDLL", status.aishortname );
-            tdf.Append( "TeamLeader", player_to_number[battle->GetUser( status.owner )] ); // bot owner is the team leader
+            tdf.Append( "AIDLL", status.Extras().aishortname );
+            tdf.Append( "TeamLeader", player_to_number[battle->GetUser( status.Extras().owner )] ); // bot owner is the team leader
         }
         else
         {
             if ( status.IsBot() )
             {
-                tdf.Append( "TeamLeader", player_to_number[battle->GetUser( status.owner )] );
+                tdf.Append( "TeamLeader", player_to_number[battle->GetUser( status.Extras().owner )] );
             }
             else
             {
@@ -541,11 +547,8 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
 
         tdf.Append( "AllyTeam",status.ally );
 
-        std::string colorstring =
-                Util::ToString( status.color.Red()/255.0 ) + ' ' +
-                Util::ToString( status.color.Green()/255.0 ) + ' ' +
-                Util::ToString( status.color.Blue()/255.0 );
-        tdf.Append( "RGBColor", colorstring);
+        const double rgb[3] = { status.color.Red()/255.0, status.color.Green()/255.0, status.color.Blue()/255.0 };
+        tdf.Append( "RGBColor", rgb, rgb + 3 );
 
         unsigned int side = status.side;
         if ( side < sides.size() ) tdf.Append( "Side", sides[side] );
@@ -557,9 +560,10 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
 
     unsigned int maxiter = std::max( NumUsers, battle->GetLastRectIdx() + 1 );
     std::set<int> parsedallys;
+    const CommonUserList::RangeType users = battle->UserRange();
     for ( unsigned int i = 0; i < maxiter; i++ )
     {
-        const ConstCommonUserPtr  usr = battle->Users()[i];
+        const ConstCommonUserPtr  usr = users[i];
         const UserBattleStatus& status = usr->BattleStatus();
         Battle::BattleStartRect sr = battle->GetStartRect( i );
         if ( status.spectator && !sr.IsOk() )
@@ -578,22 +582,16 @@ std::string Spring::WriteScriptTxt( const IBattlePtr battle ) const
         {
             if ( sr.IsOk() )
             {
-                const char* old_locale = std::setlocale(LC_NUMERIC, "C");
-
-                tdf.Append( "StartRectLeft", boost::format( "%.3f" ) % ( sr.left / 200.0 ) );
-                tdf.Append( "StartRectTop", boost::format( "%.3f" ) % ( sr.top / 200.0 ) );
-                tdf.Append( "StartRectRight", boost::format( "%.3f" ) % ( sr.right / 200.0 ) );
-                tdf.Append( "StartRectBottom", boost::format( "%.3f" ) % ( sr.bottom / 200.0 ) );
-
-                std::setlocale(LC_NUMERIC, old_locale);
+                tdf.Append( "StartRectLeft", sr.left / 200.0, 3 );
+                tdf.Append( "StartRectTop", sr.top / 200.0, 3 );
+                tdf.Append( "StartRectRight", sr.right / 200.0, 3 );
+                tdf.Append( "StartRectBottom", sr.bottom / 200.0, 3 );
             }
         }
         tdf.LeaveSection();
     }
 
     tdf.LeaveSection();
-
-    return ret.str();
 }
 
 } // namespace LSL {
@@ -33,6 +33,8 @@ class Spring
     bool RunReplay ( const std::string& filename );
 
     std::string WriteScriptTxt(const IBattlePtr battle ) const;
+    //! writes the script in one pass straight into \param sink
+    void WriteScriptTxt( const IBattlePtr battle, TDF::TDFSink& sink ) const;
     void OnTerminated( int event );
 
     boost::signals2::signal<void (int,std::string)> sig_springStopped;
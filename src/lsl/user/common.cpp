@@ -7,7 +7,6 @@ namespace LSL {
 
 void CommonUser::UpdateBattleStatus( const UserBattleStatus& status )
 {
-	// total 17 members to update.
 	m_bstatus.team = status.team;
 	m_bstatus.ally = status.ally;
 	m_bstatus.color = status.color;
@@ -17,17 +16,19 @@ void CommonUser::UpdateBattleStatus( const UserBattleStatus& status )
 	m_bstatus.sync = status.sync;
 	m_bstatus.spectator = status.spectator;
 	m_bstatus.ready = status.ready;
-	if( !status.aishortname.empty() ) m_bstatus.aishortname = status.aishortname;
-	if( !status.airawname.empty() ) m_bstatus.airawname = status.airawname;
-	if( !status.aiversion.empty() ) m_bstatus.aiversion = status.aiversion;
-	if( !status.aitype > 0 ) m_bstatus.aitype = status.aitype;
-	if( !status.owner.empty() ) m_bstatus.owner = status.owner;
 	if( status.pos.x > 0 ) m_bstatus.pos.x = status.pos.x;
 	if( status.pos.y > 0 ) m_bstatus.pos.y = status.pos.y;
 
-	// update ip and port if those were set.
-	if( !status.ip.empty() ) m_bstatus.ip = status.ip;
-	if( status.udpport != 0 ) m_bstatus.udpport = status.udpport;// 15
+	// bot details and ip/port only if those were set, most updates carry none
+	const UserBattleExtras& extras = status.Extras();
+	if( &extras == &m_bstatus.Extras() ) return;
+	if( !extras.aishortname.empty() ) m_bstatus.MutableExtras().aishortname = extras.aishortname;
+	if( !extras.airawname.empty() ) m_bstatus.MutableExtras().airawname = extras.airawname;
+	if( !extras.aiversion.empty() ) m_bstatus.MutableExtras().aiversion = extras.aiversion;
+	if( !extras.aitype > 0 ) m_bstatus.MutableExtras().aitype = extras.aitype;
+	if( !extras.owner.empty() ) m_bstatus.MutableExtras().owner = extras.owner;
+	if( !extras.ip.empty() ) m_bstatus.MutableExtras().ip = extras.ip;
+	if( extras.udpport != 0 ) m_bstatus.MutableExtras().udpport = extras.udpport;// 15
 }
 
 void CommonUser::SetStatus( const UserStatus& status )
@@ -36,7 +37,7 @@ void CommonUser::SetStatus( const UserStatus& status )
 }
 
 CommonUser::CommonUser(const std::string id, const std::string nick, const std::string country, const int cpu)
-    : m_id(id), m_nick(nick), m_country(country), m_cpu(cpu)
+    : HasNick(nick), m_country(country), m_id(id), m_cpu(cpu)
 {}
 
 std::string CommonUser::GetNewUserId()
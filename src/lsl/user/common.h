@@ -5,6 +5,7 @@
 #include <lslutils/type_forwards.h>
 #include <lslutils/misc.h>
 #include <lsl/user/userdata.h>
+#include <lslutils/interned.h>
 
 #include <boost/enable_shared_from_this.hpp>
 #include <string>
@@ -15,7 +16,7 @@ static const int DEFAULT_CPU_ID = 9001;
 
 
 //! parent class leaving out server related functionality
-class CommonUser : public HasKey< std::string >,public boost::enable_shared_from_this<CommonUser>
+class CommonUser : public HasKey< std::string >, public HasNick, public boost::enable_shared_from_this<CommonUser>
 {
 public:
     CommonUser(const std::string id = GetNewUserId(),
@@ -30,9 +31,6 @@ public:
     std::string key() const {return Id();}
 	static std::string className() { return "Channel"; }
 
-	const std::string& Nick() const { return m_nick; }
-	virtual void SetNick( const std::string& nick ) { m_nick = nick; }
-
 	const std::string& GetCountry() const { return m_country; }
 	virtual void SetCountry( const std::string& country ) { m_country = country; }
 
@@ -61,8 +59,8 @@ public:
     virtual UserStatus::RankContainer GetRank() const { return UserStatus::RANK_1; }
 
 protected:
-	std::string m_nick;
-	std::string m_country;
+	//! a couple hundred values shared by thousands of users
+	InternedString m_country;
     const std::string m_id;
 	int m_cpu;
 	UserStatus m_status;
@@ -13,27 +13,36 @@ std::string UserStatus::GetDiffString ( const UserStatus& old ) const
         std::string();
 }
 
+const UserBattleExtras UserBattleStatus::s_no_extras;
+
 UserBattleStatus::UserBattleStatus()
     : team(0)
     , ally(0)
-    , color(lslColor(0,0,0))
-    , color_index(-1)
-    , handicap(0)
     , side(0)
-    , sync(SYNC_UNKNOWN)
+    , handicap(0)
     , spectator(false)
+    , sync(SYNC_UNKNOWN)
     , ready(false)
     , isfromdemo(false)
-    , aitype(-1)
-    , udpport(0)
+    , color_index(-1)
+    , color(lslColor(0,0,0))
 {}
 
+UserBattleExtras& UserBattleStatus::MutableExtras()
+{
+    if ( !m_extras )
+        m_extras.reset( new UserBattleExtras() );
+    else if ( !m_extras.unique() )
+        m_extras.reset( new UserBattleExtras( *m_extras ) );
+    return *m_extras;
+}
+
 bool UserBattleStatus::operator == ( const UserBattleStatus& s ) const
 {
     return ( ( team == s.team ) && ( color == s.color ) && ( handicap == s.handicap ) && ( side == s.side )
              && ( sync == s.sync ) && ( spectator == s.spectator ) && ( ready == s.ready )
-             && ( owner == s.owner ) && ( aishortname == s.aishortname ) && ( isfromdemo == s.isfromdemo )
-             && ( aitype == s.aitype ) );
+             && ( isfromdemo == s.isfromdemo ) && ( Extras().owner == s.Extras().owner )
+             && ( Extras().aishortname == s.Extras().aishortname ) && ( Extras().aitype == s.Extras().aitype ) );
 }
 
 bool UserBattleStatus::operator != ( const UserBattleStatus& s ) const
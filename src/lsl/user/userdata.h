@@ -3,6 +3,7 @@
 
 #include <lslutils/type_forwards.h>
 #include <lslutils/misc.h>
+#include <boost/shared_ptr.hpp>
 #include <string>
 
 namespace LSL {
@@ -26,11 +27,12 @@ struct UserStatus
       RANK_8
     };
 
-  bool in_game;
-  bool away;
-  RankContainer rank;
-  bool moderator;
-  bool bot;
+  //! packed like TASClientstatus, the whole thing fits a single int
+  bool in_game : 1;
+  bool away : 1;
+  RankContainer rank : 3;
+  bool moderator : 1;
+  bool bot : 1;
   UserStatus(): in_game(false), away(false), rank(RANK_1), moderator(false), bot(false) {}
   std::string GetDiffString ( const UserStatus& other ) const;
 };
@@ -43,23 +45,9 @@ struct UserPosition
     UserPosition(): x(-1), y(-1) {}
 };
 
-//! Battle specific user data
-struct UserBattleStatus
+//! bot and NAT details of a UserBattleStatus, most users have none of these
+struct UserBattleExtras
 {
-    //!!! when adding something to this struct, also modify User::UpdateBattleStatus() !!
-    // total 17 members here
-    int team;
-    int ally;
-    lslColor color;
-    int color_index;
-    int handicap;
-    int side;
-    unsigned int sync;
-    bool spectator;
-    bool ready;
-    bool isfromdemo;
-    UserPosition pos; // for startpos = 4
-    // bot-only stuff
     std::string owner;
     std::string aishortname;
     std::string airawname;
@@ -69,11 +57,42 @@ struct UserBattleStatus
     std::string ip;
     unsigned int udpport;
     std::string scriptPassword;
-    bool IsBot() const { return !aishortname.empty(); }
+    UserBattleExtras() : aitype(-1), udpport(0) {}
+};
+
+/** \brief Battle specific user data
+ * The per player numbers are bitfields sized after what spring accepts (255 teams and
+ * allies, handicap 0-100), bot and NAT strings live in a UserBattleExtras that is only
+ * allocated once something is written to it and shared between copies until then.
+ */
+struct UserBattleStatus
+{
+    //!!! when adding something to this struct, also modify User::UpdateBattleStatus() !!
+    unsigned int team : 8;
+    unsigned int ally : 8;
+    unsigned int side : 8;
+    unsigned int handicap : 7;
+    bool spectator : 1;
+    unsigned int sync : 2;
+    bool ready : 1;
+    bool isfromdemo : 1;
+    int color_index : 16;
+    lslColor color;
+    UserPosition pos; // for startpos = 4
+
+    //! empty defaults unless something was set
+    const UserBattleExtras& Extras() const { return m_extras ? *m_extras : s_no_extras; }
+    //! allocates the extras, or unshares them from the copies
+    UserBattleExtras& MutableExtras();
+    bool IsBot() const { return m_extras && !m_extras->aishortname.empty(); }
     UserBattleStatus();
 
     bool operator == ( const UserBattleStatus& s ) const;
     bool operator != ( const UserBattleStatus& s ) const;
+
+private:
+    boost::shared_ptr<UserBattleExtras> m_extras;
+    static const UserBattleExtras s_no_extras;
 };
 
 } // namespace LSL
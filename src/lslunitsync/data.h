@@ -5,18 +5,19 @@
 #include <map>
 #include <string>
 
+#include <lslutils/interned.h>
+
 namespace LSL {
 
 struct UnitsyncMod
 {
     UnitsyncMod()
-        : name(std::string()),hash(std::string())
     {}
     UnitsyncMod(const std::string& name, const std::string& hash)
         : name(name),hash(hash)
     {}
-	std::string name;
-	std::string hash;
+	InternedString name;
+	InternedString hash;
 };
 
 struct StartPos
@@ -57,16 +58,14 @@ struct MapInfo
 
 struct UnitsyncMap
 {
-    UnitsyncMap():
-		name(std::string()),
-        hash(std::string())
+    UnitsyncMap()
     {}
     UnitsyncMap(const std::string& name, const std::string& hash):
 		name(name),
 		hash(hash)
     {}
-	std::string name;
-	std::string hash;
+	InternedString name;
+	InternedString hash;
 	MapInfo info;
 };
 
@@ -2,6 +2,10 @@
 #define LSL_CONVERSION_H
 
 #include <sstream>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
 
 namespace LSL {
 namespace Util {
@@ -23,6 +27,91 @@ static inline std::string ToString(const T arg){
 	return s.str();
 }
 
+//! what the protocol and scripts put around numbers
+static inline bool IsNumberSpace( const char c )
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/** \brief locale independent decimal integer parsing of [first,last)
+ * Reads like a stream does: leading whitespace, a sign and digits up to the first non digit.
+ * Values out of range end up at LONG_MAX or LONG_MIN.
+ * \param parsed if not NULL tells whether there were any digits, the result is 0 if not
+ */
+static inline long ParseLong( const char* first, const char* last, bool* parsed = NULL )
+{
+	while ( first != last && IsNumberSpace( *first ) )
+		++first;
+	bool negative = false;
+	if ( first != last && ( *first == '-' || *first == '+' ) )
+		negative = ( *first++ == '-' );
+	const char* const digits = first;
+	const unsigned long limit = negative ? 0ul - static_cast<unsigned long>( LONG_MIN ) : static_cast<unsigned long>( LONG_MAX );
+	unsigned long value = 0;
+	for ( ; first != last && *first >= '0' && *first <= '9'; ++first )
+	{
+		const unsigned long digit = *first - '0';
+		value = ( value > ( limit - digit ) / 10 ) ? limit : value * 10 + digit;
+	}
+	if ( parsed )
+		*parsed = ( first != digits );
+	return negative ? static_cast<long>( 0ul - value ) : static_cast<long>( value );
+}
+
+/** \brief locale independent floating point parsing of [first,last)
+ * always uses '.' as decimal separator and accepts an optional exponent, precision
+ * is limited to 19 significant digits which is plenty for protocol and script values.
+ * Values out of range end up at +-DBL_MAX, like with a stream.
+ * \param parsed if not NULL tells whether there were any digits, the result is 0 if not
+ */
+static inline double ParseDouble( const char* first, const char* last, bool* parsed = NULL )
+{
+	static const double exact_powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	while ( first != last && IsNumberSpace( *first ) )
+		++first;
+	bool negative = false;
+	if ( first != last && ( *first == '-' || *first == '+' ) )
+		negative = ( *first++ == '-' );
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	long exponent = 0;
+	bool any_digit = false;
+	for ( ; first != last && *first >= '0' && *first <= '9'; ++first )
+	{
+		any_digit = true;
+		if ( digits < 19 ) { mantissa = mantissa * 10 + ( *first - '0' ); if ( mantissa ) ++digits; }
+		else ++exponent;
+	}
+	if ( first != last && *first == '.' )
+	{
+		for ( ++first; first != last && *first >= '0' && *first <= '9'; ++first )
+		{
+			any_digit = true;
+			if ( digits < 19 ) { mantissa = mantissa * 10 + ( *first - '0' ); --exponent; if ( mantissa ) ++digits; }
+		}
+	}
+	if ( parsed )
+		*parsed = any_digit;
+	if ( !any_digit )
+		return 0;
+	if ( first != last && ( *first == 'e' || *first == 'E' ) && first + 1 != last && !IsNumberSpace( first[1] ) )
+	{
+		// far beyond DBL_MAX_10_EXP either way, the clamp only keeps the sum in range
+		exponent += std::max( -100000L, std::min( 100000L, ParseLong( first + 1, last ) ) );
+	}
+	double value = double( mantissa );
+	if ( mantissa == 0 )
+		value = 0;
+	else if ( exponent < 0 )
+		value = ( -exponent <= 22 ) ? value / exact_powers[-exponent] : value / 1e22 * std::pow( 10.0, double( exponent + 22 ) );
+	else if ( exponent > 0 )
+		value = ( exponent <= 22 ) ? value * exact_powers[exponent] : value * std::pow( 10.0, double( exponent ) );
+	if ( value > DBL_MAX )
+		value = DBL_MAX;
+	return negative ? -value : value;
+}
+
 static inline std::string MakeHashUnsigned( const std::string& hash )
 {
 	return ToString( FromString<unsigned int>( hash ) );
@@ -1,7 +1,9 @@
 #ifndef LIBSPRINGLOBBY_HEADERGUARD_CRTPBASE_H
 #define LIBSPRINGLOBBY_HEADERGUARD_CRTPBASE_H
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 namespace LSL {
 
@@ -26,6 +28,55 @@ struct HasKey {
     static std::string className();
 };
 
+class NickObserver;
+
+/** \brief items a NickIndexedList can index by nick
+ * SetNick tells every list indexing the item, so the indexes follow any rename.
+ */
+class HasNick {
+	public:
+		const std::string& Nick() const { return m_nick; }
+		void SetNick( const std::string& nick );
+		//! \param observer hears of every nick change until it unwatches
+		void WatchNick( NickObserver* observer );
+		void UnwatchNick( NickObserver* observer );
+	protected:
+		explicit HasNick( const std::string& nick ) : m_nick( nick ) {}
+		//! a copy is in nobody's index
+		HasNick( const HasNick& other ) : m_nick( other.m_nick ) {}
+		HasNick& operator=( const HasNick& other ) { SetNick( other.m_nick ); return *this; }
+		~HasNick() {}
+		std::string m_nick;
+	private:
+		std::vector<NickObserver*> m_nick_observers;
+};
+
+//! what HasNick tells about a nick change, after it happened
+class NickObserver {
+	public:
+		virtual void OnNickChanged( HasNick& item, const std::string& old_nick ) = 0;
+	protected:
+		~NickObserver() {}
+};
+
+inline void HasNick::SetNick( const std::string& nick ) {
+	if ( nick == m_nick )
+		return;
+	const std::string old_nick = m_nick;
+	m_nick = nick;
+	for ( size_t i = 0; i < m_nick_observers.size(); ++i )
+		m_nick_observers[i]->OnNickChanged( *this, old_nick );
+}
+
+inline void HasNick::WatchNick( NickObserver* observer ) {
+	if ( std::find( m_nick_observers.begin(), m_nick_observers.end(), observer ) == m_nick_observers.end() )
+		m_nick_observers.push_back( observer );
+}
+
+inline void HasNick::UnwatchNick( NickObserver* observer ) {
+	m_nick_observers.erase( std::remove( m_nick_observers.begin(), m_nick_observers.end(), observer ), m_nick_observers.end() );
+}
+
 } //namespace LSL {
 
 #endif // LIBSPRINGLOBBY_HEADERGUARD_CRTPBASE_H
@@ -0,0 +1,73 @@
+#include "interned.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_set.hpp>
+#include <ostream>
+
+namespace LSL {
+
+namespace {
+
+struct Pool
+{
+    boost::mutex mutex;
+    //! node based, so the strings never move
+    boost::unordered_set<std::string> strings;
+};
+
+Pool& GetPool()
+{
+    static Pool pool;
+    return pool;
+}
+
+const std::string* Insert( const std::string& value )
+{
+    Pool& pool = GetPool();
+    boost::mutex::scoped_lock lock( pool.mutex );
+    return &*pool.strings.insert( value ).first;
+}
+
+const std::string* EmptyString()
+{
+    static const std::string* empty = Insert( std::string() );
+    return empty;
+}
+
+} // namespace
+
+const std::string* InternedString::Intern( const std::string& value )
+{
+    if ( value.empty() )
+        return EmptyString();
+    return Insert( value );
+}
+
+InternedString::InternedString()
+    : m_value( EmptyString() )
+{
+}
+
+InternedString::InternedString( const std::string& value )
+    : m_value( Intern( value ) )
+{
+}
+
+InternedString::InternedString( const char* value )
+    : m_value( Intern( value ? std::string( value ) : std::string() ) )
+{
+}
+
+std::size_t InternedString::PoolSize()
+{
+    Pool& pool = GetPool();
+    boost::mutex::scoped_lock lock( pool.mutex );
+    return pool.strings.size();
+}
+
+std::ostream& operator<<( std::ostream& out, const InternedString& value )
+{
+    return out << value.str();
+}
+
+}
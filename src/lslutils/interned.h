@@ -0,0 +1,88 @@
+#ifndef LSL_INTERNED_H
+#define LSL_INTERNED_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace LSL {
+
+/** \brief an immutable string kept once in a process wide pool
+ * For the few distinct values thousands of entities share: countries, map and mod names
+ * and hashes. Copies are a pointer copy, equality is a pointer compare. Pooled strings are
+ * never released, so don't intern values that keep changing, like nicks or chat.
+ */
+class InternedString
+{
+public:
+	//! the empty string
+	InternedString();
+	InternedString( const std::string& value );
+	InternedString( const char* value );
+
+	const std::string& str() const { return *m_value; }
+	operator const std::string&() const { return *m_value; }
+	const char* c_str() const { return m_value->c_str(); }
+	bool empty() const { return m_value->empty(); }
+	std::size_t size() const { return m_value->size(); }
+	//! stable for the lifetime of the process, equal for equal strings only
+	std::size_t Id() const { return reinterpret_cast<std::size_t>( m_value ); }
+
+	bool operator==( const InternedString& other ) const { return m_value == other.m_value; }
+	bool operator!=( const InternedString& other ) const { return m_value != other.m_value; }
+	//! string order, so sorted containers come out the same as with std::string
+	bool operator<( const InternedString& other ) const { return m_value != other.m_value && *m_value < *other.m_value; }
+
+	//! number of distinct strings pooled so far
+	static std::size_t PoolSize();
+
+private:
+	static const std::string* Intern( const std::string& value );
+	const std::string* m_value;
+};
+
+//! comparing with a plain string must not intern it
+inline bool operator==( const InternedString& a, const std::string& b ) { return a.str() == b; }
+inline bool operator==( const std::string& a, const InternedString& b ) { return a == b.str(); }
+inline bool operator==( const InternedString& a, const char* b ) { return a.str() == b; }
+inline bool operator!=( const InternedString& a, const std::string& b ) { return a.str() != b; }
+inline bool operator!=( const std::string& a, const InternedString& b ) { return a != b.str(); }
+inline bool operator!=( const InternedString& a, const char* b ) { return a.str() != b; }
+inline std::string operator+( const InternedString& a, const std::string& b ) { return a.str() + b; }
+inline std::string operator+( const std::string& a, const InternedString& b ) { return a + b.str(); }
+inline std::string operator+( const char* a, const InternedString& b ) { return a + b.str(); }
+
+inline std::size_t hash_value( const InternedString& value ) { return value.Id(); }
+
+std::ostream& operator<<( std::ostream& out, const InternedString& value );
+
+} // namespace LSL
+
+/**
+ * \file interned.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_INTERNED_H
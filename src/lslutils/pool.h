@@ -0,0 +1,75 @@
+#ifndef LSL_POOL_H
+#define LSL_POOL_H
+
+#include <boost/make_shared.hpp>
+#include <boost/pool/pool_alloc.hpp>
+#include <utility>
+
+namespace LSL {
+namespace Util {
+
+#ifdef LSL_SINGLE_THREADED
+//! only sound if lsl objects are never created or dropped outside the network thread
+typedef boost::details::pool::null_mutex
+    PoolMutex;
+#else
+typedef boost::details::pool::default_mutex
+    PoolMutex;
+#endif
+
+/** \brief allocator for User, Battle and Channel objects
+ * Used through allocate_shared, so the object and its shared_ptr control block are one
+ * chunk from a per-size free list instead of two trips to the global heap. Freed chunks
+ * are kept for the next object of that size.
+ */
+template < class T >
+struct PoolAllocator {
+    typedef boost::fast_pool_allocator< T, boost::default_user_allocator_new_delete, PoolMutex >
+        type;
+};
+
+/** \brief boost::make_shared, allocating from the entity pool if LSL_ENTITY_POOL is set
+ * The pool is opt-in: with its lock it loses to the global heap on raw login/logout churn,
+ * it only pays off together with LSL_SINGLE_THREADED.
+ */
+template < class T, class... Args >
+boost::shared_ptr< T > MakePooled( Args&&... args )
+{
+#ifdef LSL_ENTITY_POOL
+    return boost::allocate_shared< T >( typename PoolAllocator< T >::type(), std::forward<Args>( args )... );
+#else
+    return boost::make_shared< T >( std::forward<Args>( args )... );
+#endif
+}
+
+} // namespace Util
+} // namespace LSL
+
+/**
+ * \file pool.h
+ * \section LICENSE
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
+
+#endif // LSL_POOL_H
@@ -34,6 +34,7 @@ typedef lslColorBase<unsigned char> lslColor;
 
 namespace TDF {
     class Tokenizer;
+    class TDFSink;
     class Node;
     typedef RefcountedPointer<Node,true> PNode;
     class DataList;
@@ -54,9 +55,6 @@ class OptionsWrapper;
 struct GameOptions;
 class Spring;
 
-//! @brief map used internally by the iServer class to calculate ping roundtimes.
-typedef std::map<int, long long> PingList;
-
 typedef std::map< std::string, std::string> StringMap;
 typedef std::vector< std::string > StringVector;
 
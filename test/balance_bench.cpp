@@ -0,0 +1,176 @@
+#include <lsl/battle/balance.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "common.h"
+
+namespace PT = boost::posix_time;
+using LSL::Battle::BalanceInput;
+using LSL::Battle::BalanceResult;
+using LSL::Battle::Balancer;
+
+namespace {
+
+//! a battle worth of players: lobby ranks map to 1.0-1.1 like CommonUser::GetBalanceRank
+BalanceInput MakeBattle( int players, size_t groups, bool lobby_ranks, int clans )
+{
+    BalanceInput input;
+    input.groups = groups;
+    for ( int p = 0; p < players; ++p )
+    {
+        input.ranks.push_back( lobby_ranks ? 1.0f + 0.1f * ( rand() % 8 ) / 7.0f : 10.0f + rand() % 4000 / 100.0f );
+        //a few clans with two or three members present
+        const int clan = rand() % ( 3 * clans + 1 );
+        input.clans_of.push_back( clan < clans ? ( boost::format( "clan%d" ) % clan ).str() : std::string() );
+    }
+    return input;
+}
+
+//! strong clans with two or more members present have to end up in one group
+void CheckClans( const BalanceInput& input, const BalanceResult& result )
+{
+    std::map<std::string, std::vector<size_t> > clans;
+    for ( size_t p = 0; p < result.size(); ++p )
+    {
+        if ( result[p] >= input.groups )
+            throw TestFailedException( "balancer returned a group out of range" );
+        if ( !input.clans_of[p].empty() )
+            clans[input.clans_of[p]].push_back( result[p] );
+    }
+    for ( std::map<std::string, std::vector<size_t> >::const_iterator it = clans.begin(); it != clans.end(); ++it )
+        if ( std::count( it->second.begin(), it->second.end(), it->second.front() ) != long( it->second.size() ) )
+            throw TestFailedException( "clan " + it->first + " got split up" );
+}
+
+//! players in the biggest group minus players in the smallest one
+size_t SizeSpread( const BalanceInput& input, const BalanceResult& result )
+{
+    std::vector<size_t> sizes( input.groups, 0 );
+    for ( size_t p = 0; p < result.size(); ++p )
+        ++sizes[result[p]];
+    return *std::max_element( sizes.begin(), sizes.end() ) - *std::min_element( sizes.begin(), sizes.end() );
+}
+
+//! false if a clan kept together has more members than a group can take, even sizes can't be had then
+bool EvenSizesPossible( const BalanceInput& input )
+{
+    std::map<std::string, size_t> members;
+    for ( size_t p = 0; p < input.clans_of.size(); ++p )
+        if ( !input.clans_of[p].empty() )
+            ++members[input.clans_of[p]];
+    for ( std::map<std::string, size_t>::const_iterator it = members.begin(); it != members.end(); ++it )
+        if ( it->second > 1 && it->second > input.ranks.size() / input.groups )
+            return false;
+    return true;
+}
+
+struct Report
+{
+    Report() : spread( 0 ), worst( 0 ), ms( 0 ), worst_ms( 0 ), uneven( 0 ) {}
+    double spread;
+    double worst;
+    double ms;
+    double worst_ms;
+    //! battles with groups more than one player apart although the clans allowed even ones
+    int uneven;
+};
+
+void Run( Balancer& balancer, const std::vector<BalanceInput>& battles, Report& report, std::vector<float>& spreads )
+{
+    for ( size_t b = 0; b < battles.size(); ++b )
+    {
+        const PT::ptime start = PT::microsec_clock::universal_time();
+        const BalanceResult result = balancer.Balance( battles[b] );
+        const double ms = ( PT::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+        CheckClans( battles[b], result );
+        report.uneven += SizeSpread( battles[b], result ) > 1 && EvenSizesPossible( battles[b] );
+        const float spread = Balancer::Spread( battles[b], result );
+        spreads.push_back( spread );
+        report.spread += spread / battles.size();
+        report.worst = std::max<double>( report.worst, spread );
+        report.ms += ms / battles.size();
+        report.worst_ms = std::max( report.worst_ms, ms );
+    }
+}
+
+} // namespace
+
+//! usage: balance_bench [battles] [players]
+int main( int argc, char** argv )
+{
+    const int count = argc > 1 ? atoi( argv[1] ) : 200;
+    const int players = argc > 2 ? atoi( argv[2] ) : 32;
+    srand( 1 );
+
+    //the sizes of the battles, and a small one where a single unit decides the team sizes
+    const int player_counts[] = { players, 16 };
+    const size_t group_counts[] = { 2, 4 };
+    for ( size_t n = 0; n < sizeof( player_counts ) / sizeof( player_counts[0] ); ++n )
+    for ( int lobby = 1; lobby >= 0; --lobby )
+        for ( size_t g = 0; g < sizeof( group_counts ) / sizeof( group_counts[0] ); ++g )
+        {
+            std::vector<BalanceInput> battles;
+            for ( int b = 0; b < count; ++b )
+                battles.push_back( MakeBattle( player_counts[n], group_counts[g], lobby, 3 ) );
+
+            LSL::Battle::GreedyBalancer greedy( 7 );
+            LSL::Battle::PartitionBalancer partition( 7 );
+            Report greedy_report, partition_report;
+            std::vector<float> greedy_spreads, partition_spreads;
+            Run( greedy, battles, greedy_report, greedy_spreads );
+            Run( partition, battles, partition_report, partition_spreads );
+            int better = 0, worse = 0;
+            for ( size_t b = 0; b < battles.size(); ++b )
+            {
+                if ( partition_spreads[b] < greedy_spreads[b] - 1e-4f ) ++better;
+                if ( partition_spreads[b] > greedy_spreads[b] + 1e-4f ) ++worse;
+            }
+            std::cout << boost::format( "%s ranks, %d players into %d groups, %d battles:\n" )
+                         % ( lobby ? "lobby" : "rating" ) % player_counts[n] % group_counts[g] % count;
+            std::cout << boost::format( "  greedy    spread avg %.3f worst %.3f, %.3f ms avg; uneven in %d\n" )
+                         % greedy_report.spread % greedy_report.worst % greedy_report.ms % greedy_report.uneven;
+            std::cout << boost::format( "  partition spread avg %.3f worst %.3f, %.3f ms avg %.3f ms worst; better in %d, worse in %d\n" )
+                         % partition_report.spread % partition_report.worst % partition_report.ms % partition_report.worst_ms % better % worse;
+            if ( partition_report.uneven )
+                throw TestFailedException( ( boost::format( "partition balancer left the groups more than one player apart in %d battles" )
+                                             % partition_report.uneven ).str() );
+        }
+
+    //same seed, a restart limit hit long before the budget: the same answer
+    const BalanceInput input = MakeBattle( players, 4, false, 3 );
+    LSL::Battle::PartitionBalancer first( 99, PT::seconds( 10 ), 50 ), second( 99, PT::seconds( 10 ), 50 );
+    if ( first.Balance( input ) != second.Balance( input ) )
+        throw TestFailedException( "equally seeded balancers disagree" );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
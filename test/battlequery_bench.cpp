@@ -0,0 +1,155 @@
+#include <lsl/container/orderedindex.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+struct BenchBattle
+{
+    int id;
+    int players;
+    int maxplayers;
+    bool passworded;
+};
+
+//! the query: open, unpassworded battles, most players first
+bool Matches( const BenchBattle& battle )
+{
+    return !battle.passworded && battle.players < battle.maxplayers;
+}
+
+struct MorePlayers
+{
+    bool operator()( const BenchBattle* a, const BenchBattle* b ) const
+    {
+        return a->players != b->players ? a->players > b->players : a->id < b->id;
+    }
+};
+
+//! what a battle list refresh costs today: filter and sort everything again
+std::vector<const BenchBattle*> Rescan( const std::vector<BenchBattle>& battles )
+{
+    std::vector<const BenchBattle*> result;
+    for ( size_t i = 0; i < battles.size(); ++i )
+        if ( Matches( battles[i] ) )
+            result.push_back( &battles[i] );
+    std::sort( result.begin(), result.end(), MorePlayers() );
+    return result;
+}
+
+//! what BattleQuery::Update does for one battle
+void Incremental( LSL::OrderedIndex<int>& order, std::vector<long>& keys, const BenchBattle& battle )
+{
+    const long none = 1;
+    const bool match = Matches( battle );
+    const long key = -battle.players;
+    if ( keys[battle.id] != none && ( !match || keys[battle.id] != key ) )
+    {
+        order.Erase( keys[battle.id], battle.id );
+        keys[battle.id] = none;
+    }
+    if ( match && keys[battle.id] == none )
+    {
+        order.Insert( key, battle.id, battle.id );
+        keys[battle.id] = key;
+    }
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+} // namespace
+
+//! usage: battlequery_bench [battles] [updates]
+int main( int argc, char** argv )
+{
+    const int count = argc > 1 ? atoi( argv[1] ) : 2000;
+    const int updates = argc > 2 ? atoi( argv[2] ) : 20000;
+
+    std::vector<BenchBattle> battles( count );
+    srand( 7 );
+    for ( int i = 0; i < count; ++i )
+    {
+        battles[i].id = i;
+        battles[i].maxplayers = 2 + rand() % 31;
+        battles[i].players = rand() % ( battles[i].maxplayers + 1 );
+        battles[i].passworded = rand() % 8 == 0;
+    }
+    std::vector<BenchBattle> rescanned( battles );
+
+    //somebody joins or leaves somewhere, the list is refreshed after every change
+    std::vector<int> who( updates );
+    std::vector<int> step( updates );
+    for ( int u = 0; u < updates; ++u )
+    {
+        who[u] = rand() % count;
+        step[u] = rand() % 2 ? 1 : -1;
+    }
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for ( int u = 0; u < updates; ++u )
+    {
+        BenchBattle& battle = rescanned[who[u]];
+        battle.players = std::max( 0, std::min( battle.maxplayers, battle.players + step[u] ) );
+        Rescan( rescanned );
+    }
+    const double rescan_ms = Milliseconds( start );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    LSL::OrderedIndex<int> order;
+    std::vector<long> keys( count, 1 );
+    for ( int i = 0; i < count; ++i )
+        Incremental( order, keys, battles[i] );
+    for ( int u = 0; u < updates; ++u )
+    {
+        BenchBattle& battle = battles[who[u]];
+        battle.players = std::max( 0, std::min( battle.maxplayers, battle.players + step[u] ) );
+        Incremental( order, keys, battle );
+    }
+    const double incremental_ms = Milliseconds( start );
+
+    const std::vector<const BenchBattle*> expected = Rescan( rescanned );
+    if ( expected.size() != order.size() )
+        throw TestFailedException( "incremental result has the wrong size" );
+    for ( size_t i = 0; i < expected.size(); ++i )
+        if ( expected[i]->id != order.At( i ) )
+            throw TestFailedException( "incremental result is in the wrong order" );
+    std::cout << boost::format( "%d battles, %d updates, %d shown: rescan + sort %.2f ms, incremental %.2f ms (%.0fx)\n" )
+                 % count % updates % order.size() % rescan_ms % incremental_ms
+                 % ( rescan_ms / std::max( incremental_ms, 0.001 ) );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,289 @@
+#include <lsl/battle/statustable.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+//! what UserStatus and UserBattleStatus used to be
+struct OldStatus
+{
+    bool in_game;
+    bool away;
+    LSL::UserStatus::RankContainer rank;
+    bool moderator;
+    bool bot;
+};
+
+struct OldBattleStatus
+{
+    int team;
+    int ally;
+    LSL::lslColor color;
+    int color_index;
+    int handicap;
+    int side;
+    unsigned int sync;
+    bool spectator;
+    bool ready;
+    bool isfromdemo;
+    LSL::UserPosition pos;
+    std::string owner;
+    std::string aishortname;
+    std::string airawname;
+    std::string aiversion;
+    int aitype;
+    std::string ip;
+    unsigned int udpport;
+    std::string scriptPassword;
+    bool IsBot() const { return !aishortname.empty(); }
+};
+
+//! stands in for CommonUser: the status sits behind a pointer, between nick, country and friends
+struct OldUser
+{
+    std::string id;
+    std::string nick;
+    std::string country;
+    OldBattleStatus status;
+};
+
+typedef boost::shared_ptr<OldUser> OldUserPtr;
+
+//! the counting pass IBattle::OnUserBattleStatusUpdated did over m_userlist
+long CountOld( const std::vector<OldUserPtr>& users )
+{
+    long spectators = 0, ready = 0, synced = 0, ok = 0;
+    for ( size_t i = 0; i < users.size(); ++i )
+    {
+        const OldBattleStatus& s = users[i]->status;
+        if ( s.spectator ) ++spectators;
+        if ( s.IsBot() || s.spectator ) continue;
+        if ( s.ready ) ++ready;
+        if ( s.sync == LSL::SYNC_SYNCED ) ++synced;
+        if ( s.ready && s.sync == LSL::SYNC_SYNCED ) ++ok;
+    }
+    return spectators + 100 * ready + 10000 * synced + 1000000 * ok;
+}
+
+long CountTable( const LSL::Battle::StatusTable& table )
+{
+    return table.CountSpectators() + 100 * table.CountReady() + 10000 * table.CountSynced() + 1000000 * table.CountOk();
+}
+
+//! the same counts one by one, a packed sum could hide two errors cancelling out
+void CheckCounts( const std::vector<OldUserPtr>& users, const LSL::Battle::StatusTable& table )
+{
+    size_t spectators = 0, ready = 0, synced = 0, ok = 0;
+    for ( size_t i = 0; i < users.size(); ++i )
+    {
+        const OldBattleStatus& s = users[i]->status;
+        if ( s.spectator ) ++spectators;
+        if ( s.IsBot() || s.spectator ) continue;
+        ready += s.ready;
+        synced += s.sync == LSL::SYNC_SYNCED;
+        ok += s.ready && s.sync == LSL::SYNC_SYNCED;
+    }
+    if ( table.size() != users.size() || table.CountSpectators() != spectators || table.CountReady() != ready
+         || table.CountSynced() != synced || table.CountOk() != ok )
+        throw TestFailedException( "status table and user walk disagree on a count" );
+}
+
+//! the bitfields have to hold what spring sends, the extras stay unallocated and unshared on write
+void CheckPacking()
+{
+    LSL::UserBattleStatus status;
+    status.team = 254;
+    status.ally = 255;
+    status.side = 17;
+    status.handicap = 100;
+    status.spectator = true;
+    status.sync = LSL::SYNC_UNSYNCED;
+    status.ready = true;
+    status.isfromdemo = true;
+    status.color_index = -1;
+    if ( status.team != 254 || status.ally != 255 || status.side != 17 || status.handicap != 100 || !status.spectator
+         || status.sync != LSL::SYNC_UNSYNCED || !status.ready || !status.isfromdemo || status.color_index != -1 )
+        throw TestFailedException( "UserBattleStatus bitfields lost a value" );
+
+    const LSL::UserBattleStatus plain;
+    if ( &plain.Extras() != &status.Extras() || plain.IsBot() )
+        throw TestFailedException( "a status without bot or NAT details allocated extras" );
+    status.MutableExtras().scriptPassword = "secret";
+    LSL::UserBattleStatus copy = status;
+    copy.MutableExtras().scriptPassword.clear();
+    copy.MutableExtras().aishortname = "KAIK";
+    if ( status.Extras().scriptPassword != "secret" || status.IsBot() || !copy.IsBot() || copy == status )
+        throw TestFailedException( "writing the extras of a copy changed the original" );
+}
+
+//! what IBattle::GetFreeTeam did: walk everybody again until no one is on the candidate
+int FreeTeamOld( const std::vector<OldUserPtr>& users, const OldUser* except )
+{
+    int lowest = 0;
+    bool changed = true;
+    while ( changed )
+    {
+        changed = false;
+        for ( size_t i = 0; i < users.size(); ++i )
+        {
+            if ( users[i].get() == except || users[i]->status.spectator ) continue;
+            if ( users[i]->status.team == lowest )
+            {
+                ++lowest;
+                changed = true;
+            }
+        }
+    }
+    return lowest;
+}
+
+//! and IsEveryoneReady
+bool AllOkOld( const std::vector<OldUserPtr>& users, const OldUser* except )
+{
+    for ( size_t i = 0; i < users.size(); ++i )
+    {
+        const OldBattleStatus& s = users[i]->status;
+        if ( users[i].get() == except || s.IsBot() || s.spectator ) continue;
+        if ( !s.ready || s.sync != LSL::SYNC_SYNCED ) return false;
+    }
+    return true;
+}
+
+LSL::UserBattleStatus ToStatus( const OldBattleStatus& old )
+{
+    LSL::UserBattleStatus status;
+    status.team = old.team;
+    status.ally = old.ally;
+    status.spectator = old.spectator;
+    status.ready = old.ready;
+    status.sync = old.sync;
+    return status;
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+} // namespace
+
+//! usage: battlestatus_bench [battles] [players] [updates]
+int main( int argc, char** argv )
+{
+    const int battles = argc > 1 ? atoi( argv[1] ) : 600;
+    const int players = argc > 2 ? atoi( argv[2] ) : 32;
+    const int updates = argc > 3 ? atoi( argv[3] ) : 200;
+
+    //users allocated interleaved across battles like they trickle in from the server
+    std::vector<std::vector<OldUserPtr> > old_battles( battles );
+    std::vector<LSL::Battle::StatusTable> tables( battles );
+    for ( int p = 0; p < players; ++p )
+        for ( int b = 0; b < battles; ++b )
+        {
+            OldUserPtr user( new OldUser() );
+            user->id = ( boost::format( "%d" ) % ( b * players + p ) ).str();
+            user->nick = "Player" + user->id;
+            user->country = "DE";
+            user->status.team = p;
+            user->status.ally = p % 2;
+            user->status.spectator = p % 8 == 7;
+            user->status.ready = p % 3 != 0;
+            user->status.sync = p % 5 ? LSL::SYNC_SYNCED : LSL::SYNC_UNSYNCED;
+            old_battles[b].push_back( user );
+
+            tables[b].Set( user->id, ToStatus( user->status ) );
+        }
+    CheckPacking();
+    for ( int b = 0; b < battles; ++b )
+        CheckCounts( old_battles[b], tables[b] );
+
+    //every status change asks for the counts of its battle
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    long old_sum = 0;
+    for ( int u = 0; u < updates; ++u )
+        for ( int b = 0; b < battles; ++b )
+            old_sum += CountOld( old_battles[b] );
+    const double old_ms = Milliseconds( start );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    long table_sum = 0;
+    for ( int u = 0; u < updates; ++u )
+        for ( int b = 0; b < battles; ++b )
+            table_sum += CountTable( tables[b] );
+    const double table_ms = Milliseconds( start );
+
+    if ( old_sum != table_sum )
+        throw TestFailedException( "status table and user walk disagree on the counts" );
+    std::cout << boost::format( "sizeof UserBattleStatus: was %d, now %d (+%d for bots/NAT); UserStatus: was %d, now %d\n" )
+                 % sizeof( OldBattleStatus ) % sizeof( LSL::UserBattleStatus ) % sizeof( LSL::UserBattleExtras )
+                 % sizeof( OldStatus ) % sizeof( LSL::UserStatus );
+    std::cout << boost::format( "%d battles x %d players x %d recounts: user walk %.2f ms, status table %.2f ms (%.1fx)\n" )
+                 % battles % players % updates % old_ms % table_ms % ( old_ms / std::max( table_ms, 0.001 ) );
+
+    //an autohost battle: random status changes, each followed by the queries the host makes
+    std::vector<OldUserPtr>& host_users = old_battles.front();
+    LSL::Battle::StatusTable& host_table = tables.front();
+    const OldUser* me = host_users.front().get();
+    srand( 42 );
+    double walk_ms = 0, lookup_ms = 0;
+    long walk_sum = 0, lookup_sum = 0;
+    for ( int u = 0; u < updates * 100; ++u )
+    {
+        OldUser& user = *host_users[rand() % host_users.size()];
+        switch ( rand() % 4 )
+        {
+            case 0: user.status.team = rand() % players; break;
+            case 1: user.status.ally = rand() % 4; break;
+            case 2: user.status.spectator = !user.status.spectator; break;
+            default: user.status.ready = !user.status.ready; break;
+        }
+        host_table.Set( user.id, ToStatus( user.status ) );
+
+        start = boost::posix_time::microsec_clock::universal_time();
+        walk_sum += FreeTeamOld( host_users, me ) + 1000 * AllOkOld( host_users, me ) + 10000 * CountOld( host_users );
+        walk_ms += Milliseconds( start );
+        start = boost::posix_time::microsec_clock::universal_time();
+        lookup_sum += host_table.LowestFreeTeam( me->id ) + 1000 * host_table.AllOk( me->id ) + 10000 * CountTable( host_table );
+        lookup_ms += Milliseconds( start );
+        if ( walk_sum != lookup_sum )
+            throw TestFailedException( "status table and user walk disagree after a status change" );
+        CheckCounts( host_users, host_table );
+    }
+    std::cout << boost::format( "%d status changes in a %d player battle, free team + everyone ready + counts: "
+                                "user walk %.2f ms, status table %.2f ms (%.1fx)\n" )
+                 % ( updates * 100 ) % players % walk_ms % lookup_ms % ( walk_ms / std::max( lookup_ms, 0.001 ) );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,185 @@
+#include <lsl/container/base.h>
+#include <lslutils/global_interfaces.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+struct BenchUser : public LSL::HasKey<std::string>
+{
+    BenchUser( const std::string& id, int team ) : m_id( id ), team( team ) {}
+    std::string key() const { return m_id; }
+    static std::string className() { return "BenchUser"; }
+    std::string m_id;
+    int team;
+};
+
+typedef boost::shared_ptr<BenchUser> BenchUserPtr;
+
+//! what ContainerBase used to be: a std::map with a seek iterator cached for At()
+class MapContainer
+{
+public:
+    MapContainer() : m_seekpos( SEEKPOS_INVALID ) {}
+    void Add( BenchUserPtr item ) { m_map[item->key()] = item; m_seekpos = SEEKPOS_INVALID; }
+    void Remove( const std::string& key )
+    {
+        if ( m_map.erase( key ) )
+            m_seekpos = SEEKPOS_INVALID;
+    }
+    BenchUserPtr Get( const std::string& key ) const { return m_map.find( key )->second; }
+    size_t size() const { return m_map.size(); }
+    BenchUserPtr At( size_t index ) const
+    {
+        if ( m_seekpos == SEEKPOS_INVALID || m_seekpos > index ) {
+            m_seek = m_map.begin();
+            m_seekpos = 0;
+        }
+        std::advance( m_seek, index - m_seekpos );
+        m_seekpos = index;
+        return m_seek->second;
+    }
+private:
+    typedef std::map<std::string, BenchUserPtr> MapType;
+    static const size_t SEEKPOS_INVALID = size_t( -1 );
+    MapType m_map;
+    mutable MapType::const_iterator m_seek;
+    mutable size_t m_seekpos;
+};
+
+class DenseContainer : public LSL::ContainerBase<BenchUser> {};
+
+std::string Id( int i )
+{
+    return ( boost::format( "%d" ) % ( 100000 + i ) ).str();
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+//! the server wide list: fill, look everybody up, walk it backwards like a sorted view would
+template <class Container>
+long ServerList( int users, double& fill_ms, double& get_ms, double& walk_ms )
+{
+    Container list;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for ( int i = 0; i < users; ++i )
+        list.Add( BenchUserPtr( new BenchUser( Id( i ), i % 16 ) ) );
+    fill_ms = Milliseconds( start );
+
+    long checksum = 0;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( int i = 0; i < users; ++i )
+        checksum += list.Get( Id( ( i * 7919 ) % users ) )->team;
+    get_ms = Milliseconds( start );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( size_t i = list.size(); i-- > 0; )
+        checksum += list.At( i )->team;
+    walk_ms = Milliseconds( start );
+    return checksum;
+}
+
+/** battles with people joining and leaving between FixColors style passes:
+ * every pass compares each player with every other through At()
+ */
+template <class Container>
+long BattleLists( int battles, int players, int rounds )
+{
+    std::vector<Container> lists( battles );
+    //join order, the longest present player leaves first
+    std::vector<std::deque<std::string> > joined( battles );
+    int next = 0;
+    for ( int b = 0; b < battles; ++b )
+        for ( int p = 0; p < players; ++p, ++next )
+        {
+            lists[b].Add( BenchUserPtr( new BenchUser( Id( next ), p ) ) );
+            joined[b].push_back( Id( next ) );
+        }
+    long checksum = 0;
+    for ( int r = 0; r < rounds; ++r )
+    {
+        for ( int b = 0; b < battles; ++b )
+        {
+            Container& list = lists[b];
+            list.Remove( joined[b].front() );
+            joined[b].pop_front();
+            list.Add( BenchUserPtr( new BenchUser( Id( next ), r ) ) );
+            joined[b].push_back( Id( next++ ) );
+            for ( size_t i = 0; i < list.size(); ++i )
+                for ( size_t j = 0; j < i; ++j )
+                    checksum += list.At( i )->team == list.At( j )->team;
+        }
+    }
+    return checksum;
+}
+
+} // namespace
+
+//! usage: container_bench [users] [battles]
+int main( int argc, char** argv )
+{
+    const int users = argc > 1 ? atoi( argv[1] ) : 10000;
+    const int battles = argc > 2 ? atoi( argv[2] ) : 1000;
+    const int players = 16;
+    const int rounds = 10;
+
+    double map_fill, map_get, map_walk, dense_fill, dense_get, dense_walk;
+    const long map_sum = ServerList<MapContainer>( users, map_fill, map_get, map_walk );
+    const long dense_sum = ServerList<DenseContainer>( users, dense_fill, dense_get, dense_walk );
+    if ( map_sum != dense_sum )
+        throw TestFailedException( "map and dense containers disagree on the server list" );
+    std::cout << boost::format( "%d users  fill: map %.2f ms, dense %.2f ms\n" ) % users % map_fill % dense_fill;
+    std::cout << boost::format( "%d users   Get: map %.2f ms, dense %.2f ms\n" ) % users % map_get % dense_get;
+    std::cout << boost::format( "%d users   At backwards: map %.2f ms, dense %.2f ms (%.0fx)\n" )
+                 % users % map_walk % dense_walk % ( map_walk / std::max( dense_walk, 0.001 ) );
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    const long map_pairs = BattleLists<MapContainer>( battles, players, rounds );
+    const double map_ms = Milliseconds( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    const long dense_pairs = BattleLists<DenseContainer>( battles, players, rounds );
+    const double dense_ms = Milliseconds( start );
+    //iteration order differs, the number of same team pairs mustn't
+    if ( map_pairs != dense_pairs )
+        throw TestFailedException( "map and dense containers disagree on the battle lists" );
+    std::cout << boost::format( "%d battles x %d players, %d join/leave + pairwise passes: map %.2f ms, dense %.2f ms (%.1fx)\n" )
+                 % battles % players % rounds % map_ms % dense_ms % ( map_ms / std::max( dense_ms, 0.001 ) );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
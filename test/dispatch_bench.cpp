@@ -0,0 +1,116 @@
+#include <lsl/networking/commandtable.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <map>
+
+#include "common.h"
+
+namespace {
+
+//! every name CommandDictionary registers
+const char* const command_names[] = {
+    "ADDUSER","TASSERVER","ACCEPTED","MOTD","CLIENTSTATUS","BATTLEOPENED","JOINEDBATTLE","UPDATEBATTLEINFO",
+    "LOGININFOEND","REMOVEUSER","BATTLECLOSED","LEFTBATTLE","JOIN","SAID","JOINED","LEFT","CHANNELTOPIC",
+    "SAIDEX","CLIENTS","SAYPRIVATE","SAYPRIVATEEX","SAIDPRIVATEEX","JOINBATTLE","CLIENTBATTLESTATUS",
+    "ADDSTARTRECT","REMOVESTARTRECT","ENABLEALLUNITS","ENABLEUNITS","DISABLEUNITS","CHANNEL","ENDOFCHANNELS",
+    "REQUESTBATTLESTATUS","SAIDBATTLE","SAIDBATTLEEX","AGREEMENT","AGREEMENTEND","OPENBATTLE","ADDBOT",
+    "UPDATEBOT","REMOVEBOT","RING","SERVERMSG","JOINBATTLEFAILED","OPENBATTLEFAILED","JOINFAILED",
+    "ACQUIREUSERID","FORCELEAVECHANNEL","DENIED","HOSTPORT","UDPSOURCEPORT","CLIENTIPPORT","SETSCRIPTTAGS",
+    "SCRIPTSTART","SCRIPTEND","SCRIPT","FORCEQUITBATTLE","BROADCAST","SERVERMSGBOX","REDIRECT",
+    "MUTELISTBEGIN","MUTELIST","MUTELISTEND","OFFERFILE"
+};
+const size_t command_count = sizeof( command_names ) / sizeof( command_names[0] );
+
+//! command mix of a login burst, weighted like the real thing
+const char* const burst_mix[] = {
+    "ADDUSER","ADDUSER","ADDUSER","ADDUSER","CLIENTSTATUS","CLIENTSTATUS","CLIENTSTATUS",
+    "JOINEDBATTLE","JOINEDBATTLE","BATTLEOPENED","UPDATEBATTLEINFO","SAID","CLIENTS","SAIDPRIVATE",
+    "NOSUCHCOMMAND"
+};
+const size_t mix_count = sizeof( burst_mix ) / sizeof( burst_mix[0] );
+
+double Nanoseconds( const boost::posix_time::ptime& start, size_t ops )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() * 1000.0 / ops;
+}
+
+} // namespace
+
+int main( int, char** )
+{
+    std::map< std::string, int > map;
+    LSL::CommandTable< int > table;
+    for ( size_t i = 0; i < command_count; ++i )
+    {
+        map[command_names[i]] = int( i ) + 1;
+        table.Insert( command_names[i], int( i ) + 1 );
+    }
+    table.Build();
+
+    for ( size_t i = 0; i < command_count; ++i )
+    {
+        const int* found = table.Find( command_names[i] );
+        if ( !found || *found != int( i ) + 1 )
+            throw TestFailedException( std::string( "lookup failed for " ) + command_names[i] );
+    }
+    if ( table.Find( "NOSUCHCOMMAND" ) || table.Find( "" ) || table.Find( "ADDUSE" ) )
+        throw TestFailedException( "unknown command resolved" );
+
+    //the names arrive as views into the receive buffer, the map needs a std::string first
+    std::vector< LSL::StringRef > lines;
+    for ( size_t i = 0; i < 1000000; ++i )
+        lines.push_back( burst_mix[( i * 7 ) % mix_count] );
+
+    long map_sum = 0;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for ( size_t i = 0; i < lines.size(); ++i )
+    {
+        const std::map< std::string, int >::const_iterator it = map.find( std::string( lines[i].begin(), lines[i].end() ) );
+        if ( it != map.end() )
+            map_sum += it->second;
+    }
+    const double map_ns = Nanoseconds( start, lines.size() );
+
+    long table_sum = 0;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( size_t i = 0; i < lines.size(); ++i )
+    {
+        const int* found = table.Find( lines[i] );
+        if ( found )
+            table_sum += *found;
+    }
+    const double table_ns = Nanoseconds( start, lines.size() );
+
+    if ( map_sum != table_sum )
+        throw TestFailedException( "map and table dispatch disagree" );
+    std::cout << boost::format( "%d commands, %d index slots\nstd::map %.1f ns/line, perfect hash %.1f ns/line\n" )
+                 % table.size() % table.IndexSize() % map_ns % table_ns;
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
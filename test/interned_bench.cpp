@@ -0,0 +1,157 @@
+#include <lslutils/interned.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+//! the name/hash pairs IBattle keeps for the host's and the local map and mod
+template <class String>
+struct BenchBattle
+{
+    String host_map, host_map_hash, host_mod, host_mod_hash;
+    String local_map, local_map_hash, local_mod, local_mod_hash;
+    bool IsSynced() const
+    {
+        return host_map_hash == local_map_hash && host_map == local_map
+            && host_mod_hash == local_mod_hash && host_mod == local_mod;
+    }
+};
+
+std::string MapName( int i ) { return ( boost::format( "Some Reasonably Long Map Name v%d" ) % ( i % 40 ) ).str(); }
+std::string ModName( int i ) { return ( boost::format( "Balanced Annihilation V7.%d" ) % ( i % 6 ) ).str(); }
+std::string Hash( const std::string& name ) { return ( boost::format( "%u" ) % ( 1000000000u + name.size() * 7919u + name[name.size() - 1] ) ).str(); }
+
+template <class String>
+std::vector<BenchBattle<String> > Fill( int battles )
+{
+    std::vector<BenchBattle<String> > result( battles );
+    for ( int i = 0; i < battles; ++i )
+    {
+        const std::string map = MapName( i ), mod = ModName( i );
+        BenchBattle<String>& b = result[i];
+        b.host_map = map;
+        b.host_map_hash = Hash( map );
+        b.host_mod = mod;
+        b.host_mod_hash = Hash( mod );
+        //everyone has the same local content, half the battles match it
+        const std::string local_map = MapName( i % 2 ? i : 0 );
+        b.local_map = local_map;
+        b.local_map_hash = Hash( local_map );
+        b.local_mod = ModName( 0 );
+        b.local_mod_hash = Hash( ModName( 0 ) );
+    }
+    return result;
+}
+
+template <class String>
+long Scan( const std::vector<BenchBattle<String> >& battles, int rounds )
+{
+    long synced = 0;
+    for ( int r = 0; r < rounds; ++r )
+        for ( size_t i = 0; i < battles.size(); ++i )
+            synced += battles[i].IsSynced();
+    return synced;
+}
+
+/** every interned battle holds the plain battle's strings and agrees on IsSynced,
+ * and equal strings, and only those, share an id
+ */
+void CheckInterned( const std::vector<BenchBattle<std::string> >& plain,
+                    const std::vector<BenchBattle<LSL::InternedString> >& interned )
+{
+    for ( size_t i = 0; i < plain.size(); ++i )
+    {
+        const BenchBattle<std::string>& p = plain[i];
+        const BenchBattle<LSL::InternedString>& n = interned[i];
+        if ( n.host_map != p.host_map || n.host_map_hash != p.host_map_hash || n.host_mod != p.host_mod
+             || n.host_mod_hash != p.host_mod_hash || n.local_map != p.local_map || n.local_map_hash != p.local_map_hash
+             || n.local_mod != p.local_mod || n.local_mod_hash != p.local_mod_hash )
+            throw TestFailedException( ( boost::format( "interned battle %d holds other strings than the plain one" ) % i ).str() );
+        if ( n.IsSynced() != p.IsSynced() )
+            throw TestFailedException( ( boost::format( "interned and plain strings disagree on IsSynced of battle %d" ) % i ).str() );
+        const BenchBattle<LSL::InternedString>& first = interned.front();
+        if ( ( n.host_map.Id() == first.host_map.Id() ) != ( p.host_map == plain.front().host_map )
+             || ( n.host_map < first.host_map ) != ( p.host_map < plain.front().host_map ) )
+            throw TestFailedException( ( boost::format( "interned map of battle %d compares unlike its string" ) % i ).str() );
+    }
+}
+
+//! heap bytes the strings of one battle hold beyond the struct, assuming no small string buffer
+size_t HeapBytes( const std::string& s ) { return s.capacity() > 15 ? s.capacity() + 1 : 0; }
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+} // namespace
+
+//! usage: interned_bench [battles] [rounds]
+int main( int argc, char** argv )
+{
+    const int count = argc > 1 ? atoi( argv[1] ) : 5000;
+    const int rounds = argc > 2 ? atoi( argv[2] ) : 1000;
+
+    const std::vector<BenchBattle<std::string> > plain = Fill<std::string>( count );
+    const std::vector<BenchBattle<LSL::InternedString> > interned = Fill<LSL::InternedString>( count );
+
+    CheckInterned( plain, interned );
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    const long plain_synced = Scan( plain, rounds );
+    const double plain_ms = Milliseconds( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    const long interned_synced = Scan( interned, rounds );
+    const double interned_ms = Milliseconds( start );
+    if ( plain_synced != interned_synced )
+        throw TestFailedException( "interned and plain strings disagree on IsSynced" );
+
+    size_t plain_bytes = 0;
+    for ( size_t i = 0; i < plain.size(); ++i )
+    {
+        const BenchBattle<std::string>& b = plain[i];
+        plain_bytes += sizeof( b ) + HeapBytes( b.host_map ) + HeapBytes( b.host_map_hash ) + HeapBytes( b.host_mod )
+                + HeapBytes( b.host_mod_hash ) + HeapBytes( b.local_map ) + HeapBytes( b.local_map_hash )
+                + HeapBytes( b.local_mod ) + HeapBytes( b.local_mod_hash );
+    }
+    const size_t interned_bytes = count * sizeof( BenchBattle<LSL::InternedString> );
+
+    std::cout << boost::format( "%d battles x %d IsSynced scans: std::string %.2f ms, interned %.2f ms (%.1fx)\n" )
+                 % count % rounds % plain_ms % interned_ms % ( plain_ms / std::max( interned_ms, 0.001 ) );
+    std::cout << boost::format( "name/hash storage: std::string %.0f KiB, interned %.0f KiB plus a pool of %d strings\n" )
+                 % ( plain_bytes / 1024.0 ) % ( interned_bytes / 1024.0 ) % LSL::InternedString::PoolSize();
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
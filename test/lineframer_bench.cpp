@@ -0,0 +1,135 @@
+#include <lsl/networking/lineframer.h>
+
+#include <boost/asio/buffers_iterator.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/ref.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "common.h"
+#include "loginburst.h"
+
+namespace {
+
+struct Counter
+{
+    Counter() : lines( 0 ), bytes( 0 ) {}
+    void operator()( LSL::StringRef cmd, LSL::StringRef params )
+    {
+        ++lines;
+        bytes += cmd.size() + params.size();
+    }
+    size_t lines;
+    size_t bytes;
+};
+
+//! what Socket::ReceiveCallback used to do: one istream and two strings per line
+size_t ParseWithStreambuf( const std::string& burst, size_t chunk, Counter& counter )
+{
+    boost::asio::streambuf incoming;
+    for ( size_t off = 0; off < burst.size(); off += chunk )
+    {
+        const size_t len = std::min( chunk, burst.size() - off );
+        boost::asio::streambuf::mutable_buffers_type target = incoming.prepare( len );
+        std::memcpy( boost::asio::buffer_cast<char*>( target ), burst.data() + off, len );
+        incoming.commit( len );
+        std::istream buf( &incoming );
+        while ( std::find( boost::asio::buffers_begin( incoming.data() ), boost::asio::buffers_end( incoming.data() ), '\n' )
+                != boost::asio::buffers_end( incoming.data() ) )
+        {
+            std::string command, msg;
+            buf >> command;
+            std::getline( buf, msg );
+            if ( !msg.empty() )
+                msg = msg.substr( 1 );
+            counter( command, msg );
+        }
+    }
+    return counter.lines;
+}
+
+size_t ParseWithFramer( const std::string& burst, size_t chunk, Counter& counter )
+{
+    LSL::LineFramer framer;
+    const LSL::LineFramer::LineHandler handler = boost::ref( counter );
+    for ( size_t off = 0; off < burst.size(); off += chunk )
+        framer.Feed( burst.data() + off, std::min( chunk, burst.size() - off ), handler );
+    if ( framer.Pending() != 0 )
+        throw TestFailedException( "framer kept a partial line at the end of the burst" );
+    return counter.lines;
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+} // namespace
+
+//! usage: lineframer_bench [captured_login_burst.txt]
+int main( int argc, char** argv )
+{
+    std::string burst;
+    if ( argc > 1 )
+    {
+        std::ifstream in( argv[1], std::ios::binary );
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        burst = contents.str();
+    }
+    else
+        burst = SyntheticLoginBurst( 5000, 600 );
+
+    //typical tcp segment payload and a large socket read
+    const size_t chunks[] = { 1448, 65536 };
+    const int rounds = 20;
+    for ( size_t c = 0; c < sizeof( chunks ) / sizeof( chunks[0] ); ++c )
+    {
+        Counter old_counter, new_counter;
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        for ( int r = 0; r < rounds; ++r )
+            ParseWithStreambuf( burst, chunks[c], old_counter );
+        const double old_ms = Milliseconds( start );
+
+        start = boost::posix_time::microsec_clock::universal_time();
+        for ( int r = 0; r < rounds; ++r )
+            ParseWithFramer( burst, chunks[c], new_counter );
+        const double new_ms = Milliseconds( start );
+
+        if ( old_counter.lines != new_counter.lines || old_counter.bytes != new_counter.bytes )
+            throw TestFailedException( "framer and streambuf parsing disagree" );
+        std::cout << boost::format( "chunk %6d: %d lines, streambuf %.2f ms, framer %.2f ms (%.1fx)\n" )
+                     % chunks[c] % ( new_counter.lines / rounds ) % old_ms % new_ms % ( old_ms / std::max( new_ms, 0.001 ) );
+    }
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,276 @@
+#include <lsl/networking/iserver.h>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "mockserver.h"
+
+namespace PT = boost::posix_time;
+
+namespace {
+
+struct LoginTracker
+{
+    LoginTracker() : completed( 0 ) {}
+    void Done( size_t index )
+    {
+        boost::mutex::scoped_lock lock( mutex );
+        finished[index] = PT::microsec_clock::universal_time();
+        ++completed;
+        cond.notify_all();
+    }
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    std::vector<PT::ptime> started;
+    std::vector<PT::ptime> finished;
+    size_t completed;
+};
+
+struct LoadClient
+{
+    LoadClient( size_t index, LoginTracker& tracker )
+        : m_index( index ), m_tracker( tracker ), m_server( new LSL::Server() )
+    {
+        m_server->sig_Connected.connect( boost::bind( &LoadClient::OnConnected, this ) );
+        m_server->sig_InitialStateReady.connect( boost::bind( &LoadClient::OnInitialStateReady, this, _1 ) );
+    }
+    void OnConnected()
+    {
+        m_tracker.started[m_index] = PT::microsec_clock::universal_time();
+        m_server->Login( ( boost::format( "LoadClient%d" ) % m_index ).str(), "password" );
+    }
+    void OnInitialStateReady( const LSL::InitialState& /*state*/ )
+    {
+        m_tracker.Done( m_index );
+        m_server->JoinChannel( "main", "" );
+    }
+    const size_t m_index;
+    LoginTracker& m_tracker;
+    boost::shared_ptr<LSL::Server> m_server;
+};
+
+//! user+system time of the whole process
+double CpuSeconds()
+{
+    rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+            + ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1e6;
+}
+
+double ResidentMegabytes()
+{
+#ifdef __linux__
+    FILE* statm = fopen( "/proc/self/statm", "r" );
+    long pages = 0, resident = 0;
+    if ( statm )
+    {
+        if ( fscanf( statm, "%ld %ld", &pages, &resident ) != 2 )
+            resident = 0;
+        fclose( statm );
+    }
+    return resident * sysconf( _SC_PAGESIZE ) / ( 1024.0 * 1024.0 );
+#else
+    rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_maxrss / 1024.0; //peak, not current
+#endif
+}
+
+double Milliseconds( const PT::time_duration& d )
+{
+    return d.total_microseconds() / 1000.0;
+}
+
+void Usage()
+{
+    std::cout << "usage: loadtest [--clients N] [--users N] [--battles N] [--rate lines/s per client]\n"
+                 "                [--seconds N] [--pipeline N] [--serve port | --connect host:port]\n"
+                 "  --serve runs only the mock lobby, --connect only the clients, so both can be measured alone\n";
+}
+
+} // namespace
+
+int main( int argc, char** argv )
+{
+    MockServerConfig config;
+    size_t clients = 10;
+    int seconds = 10;
+    int pipeline = 200;
+    int serve_port = -1;
+    std::string host = "127.0.0.1";
+    int port = 0;
+    for ( int i = 1; i < argc; ++i )
+    {
+        const std::string arg = argv[i];
+        if ( i + 1 >= argc )
+        {
+            Usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if ( arg == "--clients" )
+            clients = std::max( 1, atoi( value ) );
+        else if ( arg == "--users" )
+            config.users = atoi( value );
+        else if ( arg == "--battles" )
+            config.battles = std::min( atoi( value ), config.users );
+        else if ( arg == "--rate" )
+            config.chat_rate = atof( value );
+        else if ( arg == "--seconds" )
+            seconds = atoi( value );
+        else if ( arg == "--pipeline" )
+            pipeline = atoi( value );
+        else if ( arg == "--serve" )
+            serve_port = atoi( value );
+        else if ( arg == "--connect" )
+        {
+            const char* colon = strrchr( value, ':' );
+            if ( !colon )
+            {
+                Usage();
+                return 1;
+            }
+            host.assign( value, colon );
+            port = atoi( colon + 1 );
+        }
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    boost::shared_ptr<MockLobbyServer> mock;
+    if ( port == 0 )
+    {
+        mock.reset( new MockLobbyServer( config, serve_port > 0 ? serve_port : 0 ) );
+        mock->Start();
+        port = mock->Port();
+    }
+    if ( serve_port >= 0 )
+    {
+        std::cout << boost::format( "mock lobby on port %d: %d users, %d battles, %.0f lines/s per client\n" )
+                     % port % config.users % config.battles % config.chat_rate;
+        for ( ;; )
+        {
+            boost::this_thread::sleep( PT::seconds( 5 ) );
+            const MockServerStatistics stats = mock->GetStatistics();
+            std::cout << boost::format( "logins %d, lines %d, MiB %.1f\n" )
+                         % stats.logins % stats.lines_sent % ( stats.bytes_sent / ( 1024.0 * 1024.0 ) );
+        }
+    }
+
+    const double rss_start = ResidentMegabytes();
+    LoginTracker tracker;
+    tracker.started.resize( clients );
+    tracker.finished.resize( clients );
+    std::vector<boost::shared_ptr<LoadClient> > load_clients;
+    for ( size_t i = 0; i < clients; ++i )
+    {
+        load_clients.push_back( boost::shared_ptr<LoadClient>( new LoadClient( i, tracker ) ) );
+        load_clients.back()->m_server->Connect( "mock", host, port );
+    }
+    {
+        boost::mutex::scoped_lock lock( tracker.mutex );
+        const PT::ptime deadline = PT::microsec_clock::universal_time() + PT::seconds( 60 );
+        while ( tracker.completed < clients )
+        {
+            if ( !tracker.cond.timed_wait( lock, deadline ) )
+                throw TestFailedException( ( boost::format( "only %d of %d clients reached LOGININFOEND" )
+                                             % tracker.completed % clients ).str() );
+        }
+    }
+    std::vector<double> login_ms;
+    for ( size_t i = 0; i < clients; ++i )
+        login_ms.push_back( Milliseconds( tracker.finished[i] - tracker.started[i] ) );
+    std::sort( login_ms.begin(), login_ms.end() );
+    const double rss_logged_in = ResidentMegabytes();
+    std::cout << boost::format( "%d clients, %d users, %d battles\n" ) % clients % config.users % config.battles;
+    std::cout << boost::format( "login to LOGININFOEND: min %.1f ms, median %.1f ms, max %.1f ms\n" )
+                 % login_ms.front() % login_ms[login_ms.size() / 2] % login_ms.back();
+
+    //steady state: let the joins settle, then measure over the chat stream
+    boost::this_thread::sleep( PT::seconds( 1 ) );
+    const size_t chat_before = mock ? mock->GetStatistics().chat_lines : 0;
+    const double cpu_before = CpuSeconds();
+    const PT::ptime start = PT::microsec_clock::universal_time();
+    boost::this_thread::sleep( PT::seconds( seconds ) );
+    const double wall = Milliseconds( PT::microsec_clock::universal_time() - start ) / 1000.0;
+    const double cpu = CpuSeconds() - cpu_before;
+    const double rate = mock ? ( mock->GetStatistics().chat_lines - chat_before ) / wall
+                             : config.chat_rate * clients;
+    const double rss_end = ResidentMegabytes();
+
+    std::cout << boost::format( "steady state: %.0f msg/s over %.1f s, %.1f%% cpu, %.2f%% cpu per 1k msg/s%s\n" )
+                 % rate % wall % ( 100 * cpu / wall ) % ( 100 * cpu / wall / std::max( rate / 1000, 0.001 ) )
+                 % ( mock ? " (includes the mock lobby)" : "" );
+    std::cout << boost::format( "rss: %.1f MiB at start, %.1f MiB logged in (%.1f KiB per client), %.1f MiB after steady state (%+.1f MiB)\n" )
+                 % rss_start % rss_logged_in % ( ( rss_logged_in - rss_start ) * 1024 / clients ) % rss_end % ( rss_end - rss_logged_in );
+
+    //a bot firing off many queries at once instead of waiting for each reply
+    if ( pipeline > 0 )
+    {
+        LSL::Server& server = *load_clients.front()->m_server;
+        std::vector<boost::unique_future<LSL::RequestReply> > replies;
+        const PT::ptime sent = PT::microsec_clock::universal_time();
+        for ( int i = 0; i < pipeline; ++i )
+            replies.push_back( server.Request( "PING", "", 10000 ) );
+        size_t failed = 0;
+        for ( size_t i = 0; i < replies.size(); ++i )
+        {
+            while ( !replies[i].timed_wait( PT::milliseconds( 100 ) ) )
+                server.TimerUpdate();
+            if ( !replies[i].get().success )
+                ++failed;
+        }
+        const LSL::RttHistogram ping = server.GetRequestStatistics()["PING"];
+        std::cout << boost::format( "%d pipelined requests: %.1f ms total, %d failed, rtt p50 < %.2f ms, p99 < %.2f ms\n" )
+                     % pipeline % Milliseconds( PT::microsec_clock::universal_time() - sent ) % failed
+                     % ( ping.Percentile( 0.5 ) / 1000.0 ) % ( ping.Percentile( 0.99 ) / 1000.0 );
+    }
+
+    load_clients.clear();
+    if ( mock )
+        mock->Stop();
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
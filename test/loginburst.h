@@ -0,0 +1,30 @@
+#ifndef LSL_TESTS_LOGINBURST_H
+#define LSL_TESTS_LOGINBURST_H
+
+#include <boost/format.hpp>
+#include <sstream>
+#include <string>
+
+//! the ADDUSER/BATTLEOPENED/CLIENTSTATUS/JOINEDBATTLE part of a login burst, users are named Player<n>
+inline std::string SyntheticPopulation( int users, int battles )
+{
+    std::ostringstream out;
+    for ( int i = 0; i < users; ++i )
+        out << boost::format( "ADDUSER Player%d DE %d %d\n" ) % i % ( 2000 + i % 1000 ) % ( 100000 + i );
+    for ( int i = 0; i < battles; ++i )
+        out << boost::format( "BATTLEOPENED %d 0 0 Player%d 192.168.0.%d 8452 16 1 0 -1234567 DeltaSiegeDry\tTeam game %d\tBalanced Annihilation V7.72\n" )
+               % i % i % ( i % 255 ) % i;
+    for ( int i = 0; i < users; ++i )
+        out << boost::format( "CLIENTSTATUS Player%d %d\n" ) % i % ( i % 128 );
+    for ( int i = 0; battles > 0 && i < users / 2; ++i )
+        out << boost::format( "JOINEDBATTLE %d Player%d\n" ) % ( i % battles ) % i;
+    return out.str();
+}
+
+//! roughly what the server sends right after LOGININFOEND on a busy day
+inline std::string SyntheticLoginBurst( int users, int battles )
+{
+    return "TASServer 0.35 * 8201 0\n" + SyntheticPopulation( users, battles ) + "LOGININFOEND\n";
+}
+
+#endif // LSL_TESTS_LOGINBURST_H
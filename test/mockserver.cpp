@@ -0,0 +1,303 @@
+#include "mockserver.h"
+
+#include <lsl/networking/lineframer.h>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/format.hpp>
+#include <cmath>
+#include <deque>
+
+#include "loginburst.h"
+
+namespace BA = boost::asio;
+using boost::asio::ip::tcp;
+
+namespace {
+//! a client that can't keep up stops getting chat until it drained this much
+const size_t MAX_CHAT_BACKLOG = 8 * 1024 * 1024;
+const int CHAT_TICK_MS = 10;
+//! how many nicks the CLIENTS reply to JOIN lists
+const int CHANNEL_MEMBERS = 50;
+}
+
+class MockLobbyServer::Session : public boost::enable_shared_from_this<Session>
+{
+public:
+    Session( MockLobbyServer& server )
+        : m_server( server )
+        , m_socket( server.m_service )
+        , m_line_handler( boost::bind( &Session::OnLine, this, _1, _2 ) )
+        , m_queued_bytes( 0 )
+        , m_writing( false )
+        , m_logged_in( false )
+    {}
+
+    tcp::socket& Socket() { return m_socket; }
+    bool LoggedIn() const { return m_logged_in; }
+    size_t QueuedBytes() const { return m_queued_bytes; }
+
+    void Start()
+    {
+        Send( "TASSERVER 0.35 * 8201 0\n" );
+        Receive();
+    }
+
+    void Send( const std::string& text )
+    {
+        Send( boost::shared_ptr<const std::string>( new std::string( text ) ) );
+    }
+
+    void Send( const boost::shared_ptr<const std::string>& text )
+    {
+        m_queued_bytes += text->size();
+        m_outgoing.push_back( text );
+        if ( !m_writing )
+            WriteNext();
+    }
+
+    void Close()
+    {
+        boost::system::error_code ignored;
+        m_socket.close( ignored );
+    }
+
+private:
+    void Receive()
+    {
+        m_socket.async_read_some( m_framer.Prepare(),
+                                  boost::bind( &Session::ReceiveCallback, shared_from_this(),
+                                               BA::placeholders::error, BA::placeholders::bytes_transferred ) );
+    }
+
+    void ReceiveCallback( const boost::system::error_code& error, size_t bytes )
+    {
+        if ( error )
+        {
+            m_server.OnClosed( shared_from_this() );
+            return;
+        }
+        m_framer.Commit( bytes, m_line_handler );
+        if ( m_socket.is_open() )
+            Receive();
+    }
+
+    void OnLine( LSL::StringRef cmd, LSL::StringRef params )
+    {
+        std::string reply_prefix;
+        if ( !cmd.empty() && cmd[0] == '#' )
+        {
+            reply_prefix = cmd.to_string() + " ";
+            const size_t sep = params.find( ' ' );
+            cmd = params.substr( 0, sep );
+            params = ( sep == LSL::StringRef::npos ) ? LSL::StringRef() : params.substr( sep + 1 );
+        }
+        const LSL::StringRef first = params.substr( 0, params.find( ' ' ) );
+        if ( cmd == "LOGIN" && !m_logged_in )
+        {
+            m_logged_in = true;
+            m_server.OnLogin( shared_from_this(), first.to_string() );
+        }
+        else if ( cmd == "PING" )
+            Send( reply_prefix + "PONG\n" );
+        else if ( cmd == "JOIN" && m_logged_in )
+        {
+            const int members = std::min( CHANNEL_MEMBERS, m_server.m_config.users );
+            std::string reply = reply_prefix + "JOIN " + first.to_string() + "\nCLIENTS " + first.to_string();
+            for ( int i = 0; i < members; ++i )
+                reply += ( boost::format( " Player%d" ) % i ).str();
+            Send( reply + "\n" );
+            m_server.CountSent( 2, reply.size() + 1 );
+        }
+        else if ( cmd == "EXIT" )
+            Close();
+    }
+
+    void WriteNext()
+    {
+        m_writing = true;
+        BA::async_write( m_socket, BA::buffer( *m_outgoing.front() ),
+                         boost::bind( &Session::WriteCallback, shared_from_this(),
+                                      BA::placeholders::error, BA::placeholders::bytes_transferred ) );
+    }
+
+    void WriteCallback( const boost::system::error_code& error, size_t /*bytes*/ )
+    {
+        m_writing = false;
+        m_queued_bytes -= m_outgoing.front()->size();
+        m_outgoing.pop_front();
+        if ( error )
+        {
+            m_server.OnClosed( shared_from_this() );
+            return;
+        }
+        if ( !m_outgoing.empty() )
+            WriteNext();
+    }
+
+    MockLobbyServer& m_server;
+    tcp::socket m_socket;
+    LSL::LineFramer m_framer;
+    const LSL::LineFramer::LineHandler m_line_handler;
+    std::deque<boost::shared_ptr<const std::string> > m_outgoing;
+    size_t m_queued_bytes;
+    bool m_writing;
+    bool m_logged_in;
+};
+
+MockLobbyServer::MockLobbyServer( const MockServerConfig& config, unsigned short port )
+    : m_config( config )
+    , m_population( new std::string( SyntheticPopulation( config.users, config.battles ) ) )
+    , m_acceptor( m_service, tcp::endpoint( BA::ip::address_v4::loopback(), port ) )
+    , m_chat_timer( m_service )
+    , m_chat_credit( 0 )
+    , m_chat_serial( 0 )
+{
+}
+
+MockLobbyServer::~MockLobbyServer()
+{
+    Stop();
+}
+
+unsigned short MockLobbyServer::Port() const
+{
+    return m_acceptor.local_endpoint().port();
+}
+
+MockServerStatistics MockLobbyServer::GetStatistics() const
+{
+    boost::mutex::scoped_lock lock( m_stats_mutex );
+    return m_stats;
+}
+
+void MockLobbyServer::Start()
+{
+    if ( m_thread )
+        return;
+    Accept();
+    m_chat_timer.expires_from_now( boost::posix_time::milliseconds( CHAT_TICK_MS ) );
+    m_chat_timer.async_wait( boost::bind( &MockLobbyServer::ChatTimerCallback, this, BA::placeholders::error ) );
+    m_thread.reset( new boost::thread( boost::bind( &BA::io_service::run, &m_service ) ) );
+}
+
+void MockLobbyServer::Stop()
+{
+    if ( !m_thread )
+        return;
+    m_service.stop();
+    m_thread->join();
+    m_thread.reset();
+    for ( std::set<SessionPtr>::const_iterator it = m_sessions.begin(); it != m_sessions.end(); ++it )
+        ( *it )->Close();
+    m_sessions.clear();
+}
+
+void MockLobbyServer::Accept()
+{
+    SessionPtr session( new Session( *this ) );
+    m_acceptor.async_accept( session->Socket(),
+                             boost::bind( &MockLobbyServer::AcceptCallback, this, session, BA::placeholders::error ) );
+}
+
+void MockLobbyServer::AcceptCallback( SessionPtr session, const boost::system::error_code& error )
+{
+    if ( error )
+        return;
+    boost::system::error_code ignored;
+    session->Socket().set_option( tcp::no_delay( true ), ignored );
+    m_sessions.insert( session );
+    session->Start();
+    Accept();
+}
+
+void MockLobbyServer::OnLogin( SessionPtr session, const std::string& nick )
+{
+    size_t logins;
+    {
+        boost::mutex::scoped_lock lock( m_stats_mutex );
+        logins = ++m_stats.logins;
+    }
+    const std::string accepted = ( boost::format( "ACCEPTED %s\nMOTD welcome to the mock lobby\n" ) % nick ).str();
+    const std::string self = ( boost::format( "ADDUSER %s XX 0 %d\nLOGININFOEND\n" ) % nick % ( 1000000 + logins ) ).str();
+    session->Send( accepted );
+    session->Send( m_population );
+    session->Send( self );
+    const size_t population_lines = 2 * m_config.users + m_config.battles + ( m_config.battles > 0 ? m_config.users / 2 : 0 );
+    CountSent( 4 + population_lines, accepted.size() + m_population->size() + self.size() );
+}
+
+void MockLobbyServer::OnClosed( SessionPtr session )
+{
+    session->Close();
+    m_sessions.erase( session );
+}
+
+void MockLobbyServer::CountSent( size_t lines, size_t bytes, size_t chat_lines )
+{
+    boost::mutex::scoped_lock lock( m_stats_mutex );
+    m_stats.lines_sent += lines;
+    m_stats.bytes_sent += bytes;
+    m_stats.chat_lines += chat_lines;
+}
+
+void MockLobbyServer::ChatTimerCallback( const boost::system::error_code& error )
+{
+    if ( error )
+        return;
+    m_chat_credit += m_config.chat_rate * CHAT_TICK_MS / 1000.0;
+    const int count = static_cast<int>( std::floor( m_chat_credit ) );
+    m_chat_credit -= count;
+    if ( count > 0 && m_config.users > 0 )
+    {
+        //every client gets the same batch, like a busy #main would look to all of them
+        std::string batch;
+        for ( int i = 0; i < count; ++i, ++m_chat_serial )
+        {
+            const size_t who = m_chat_serial % m_config.users;
+            if ( m_chat_serial % 2 )
+                batch += ( boost::format( "CLIENTSTATUS Player%d %d\n" ) % who % ( m_chat_serial % 128 ) ).str();
+            else
+                batch += ( boost::format( "SAID main Player%d message number %d, nothing to see here\n" ) % who % m_chat_serial ).str();
+        }
+        const boost::shared_ptr<const std::string> shared( new std::string( batch ) );
+        size_t receivers = 0;
+        for ( std::set<SessionPtr>::const_iterator it = m_sessions.begin(); it != m_sessions.end(); ++it )
+        {
+            if ( !( *it )->LoggedIn() || ( *it )->QueuedBytes() > MAX_CHAT_BACKLOG )
+                continue;
+            ( *it )->Send( shared );
+            ++receivers;
+        }
+        CountSent( receivers * count, receivers * batch.size(), receivers * count );
+    }
+    m_chat_timer.expires_at( m_chat_timer.expires_at() + boost::posix_time::milliseconds( CHAT_TICK_MS ) );
+    m_chat_timer.async_wait( boost::bind( &MockLobbyServer::ChatTimerCallback, this, BA::placeholders::error ) );
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
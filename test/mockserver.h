@@ -0,0 +1,79 @@
+#ifndef LSL_TESTS_MOCKSERVER_H
+#define LSL_TESTS_MOCKSERVER_H
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <set>
+#include <string>
+
+struct MockServerConfig
+{
+    MockServerConfig()
+        : users( 5000 ), battles( 600 ), chat_rate( 100 ) {}
+    //! size of the population every login receives
+    int users;
+    int battles;
+    //! SAID/CLIENTSTATUS lines per second sent to each logged in client
+    double chat_rate;
+};
+
+struct MockServerStatistics
+{
+    MockServerStatistics()
+        : logins( 0 ), lines_sent( 0 ), bytes_sent( 0 ), chat_lines( 0 ) {}
+    size_t logins;
+    size_t lines_sent;
+    size_t bytes_sent;
+    size_t chat_lines;
+};
+
+/** \brief a local stand-in for a TASServer lobby, for load and soak testing
+ * Speaks just enough protocol to take clients through login: the greeting, ACCEPTED,
+ * the population burst up to LOGININFOEND, JOIN/CLIENTS and PING/PONG. Logged in clients
+ * then get a steady stream of SAID and CLIENTSTATUS lines at MockServerConfig::chat_rate.
+ * Everything runs on one thread of its own.
+ */
+class MockLobbyServer
+{
+public:
+    //! \param port 0 picks an ephemeral port, see Port()
+    MockLobbyServer( const MockServerConfig& config, unsigned short port = 0 );
+    ~MockLobbyServer();
+
+    void Start();
+    void Stop();
+    unsigned short Port() const;
+    MockServerStatistics GetStatistics() const;
+
+    class Session;
+    typedef boost::shared_ptr<Session> SessionPtr;
+
+private:
+    friend class Session;
+    void Accept();
+    void AcceptCallback( SessionPtr session, const boost::system::error_code& error );
+    void ChatTimerCallback( const boost::system::error_code& error );
+    void OnLogin( SessionPtr session, const std::string& nick );
+    void OnClosed( SessionPtr session );
+    void CountSent( size_t lines, size_t bytes, size_t chat_lines = 0 );
+
+    const MockServerConfig m_config;
+    //! built once, every login gets the same copy
+    boost::shared_ptr<const std::string> m_population;
+    boost::asio::io_service m_service;
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    boost::asio::deadline_timer m_chat_timer;
+    boost::scoped_ptr<boost::thread> m_thread;
+    std::set<SessionPtr> m_sessions;
+    double m_chat_credit;
+    size_t m_chat_serial;
+    mutable boost::mutex m_stats_mutex;
+    MockServerStatistics m_stats;
+};
+
+#endif // LSL_TESTS_MOCKSERVER_H
@@ -0,0 +1,177 @@
+#include <lsl/container/nicklist.h>
+#include <lslutils/global_interfaces.h>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+struct BenchUser : public LSL::HasKey<std::string>, public LSL::HasNick
+{
+    BenchUser( const std::string& id, const std::string& nick ) : LSL::HasNick( nick ), m_id( id ) {}
+    std::string key() const { return m_id; }
+    static std::string className() { return "BenchUser"; }
+    std::string m_id;
+};
+
+typedef boost::shared_ptr<BenchUser> BenchUserPtr;
+typedef LSL::NickIndexedList<BenchUser> NickList;
+
+//! what FindByNick has to do without an index: compare against every nick
+BenchUserPtr LinearFind( const std::vector<BenchUserPtr>& users, const std::string& nick )
+{
+    const std::string wanted = boost::to_lower_copy( nick );
+    for ( size_t i = 0; i < users.size(); ++i )
+        if ( boost::to_lower_copy( users[i]->Nick() ) == wanted )
+            return users[i];
+    return BenchUserPtr();
+}
+
+size_t LinearPrefix( const std::vector<BenchUserPtr>& users, const std::string& prefix )
+{
+    const std::string wanted = boost::to_lower_copy( prefix );
+    size_t count = 0;
+    for ( size_t i = 0; i < users.size(); ++i )
+        if ( boost::to_lower_copy( users[i]->Nick() ).compare( 0, wanted.size(), wanted ) == 0 )
+            ++count;
+    return count;
+}
+
+std::string Nick( int i )
+{
+    //mixed case so lookups have to fold
+    return ( boost::format( "%s_Player%d" ) % ( i % 3 ? "Clan" : "TAG" ) % i ).str();
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+} // namespace
+
+//! usage: nick_bench [users] [lookups]
+int main( int argc, char** argv )
+{
+    const int users = argc > 1 ? atoi( argv[1] ) : 10000;
+    const int lookups = argc > 2 ? atoi( argv[2] ) : 2000;
+
+    std::vector<BenchUserPtr> all;
+    NickList list;
+    for ( int i = 0; i < users; ++i )
+    {
+        all.push_back( BenchUserPtr( new BenchUser( ( boost::format( "%d" ) % i ).str(), Nick( i ) ) ) );
+        list.Add( all.back() );
+    }
+
+    //some users rename and some leave, the index has to follow
+    std::vector<BenchUserPtr> present;
+    for ( int i = 0; i < users; ++i )
+    {
+        if ( i % 10 == 0 )
+            list.Rename( all[i], "renamed_" + Nick( i ) );
+        if ( i % 10 == 5 )
+            list.Remove( all[i]->key() );
+        else
+            present.push_back( all[i] );
+    }
+    if ( list.FindByNick( Nick( 0 ) ) || ( users > 5 && list.FindByNick( Nick( 5 ) ) )
+         || list.FindByNick( "RENAMED_" + Nick( 0 ) ) != all[0] || list.size() != present.size() )
+        throw TestFailedException( "nick index missed a rename or removal" );
+
+    //a user in two lists (server and battle) renamed directly, neither list may go stale
+    {
+        NickList battle;
+        battle.Add( all[1] );
+        NickList copy( battle );
+        all[1]->SetNick( "Direct_" + Nick( 1 ) );
+        if ( list.FindByNick( Nick( 1 ) ) || battle.FindByNick( Nick( 1 ) ) || copy.FindByNick( Nick( 1 ) )
+             || list.FindByNick( "direct_" + Nick( 1 ) ) != all[1] || battle.FindByNick( "DIRECT_" + Nick( 1 ) ) != all[1]
+             || copy.FindByNick( "direct_" + Nick( 1 ) ) != all[1] )
+            throw TestFailedException( "SetNick left a nick index behind" );
+        all[1]->SetNick( Nick( 1 ) );
+    }
+    //the lists above are gone, renaming must not reach them any more
+    all[1]->SetNick( "Again_" + Nick( 1 ) );
+    all[1]->SetNick( Nick( 1 ) );
+    if ( list.FindByNick( Nick( 1 ) ) != all[1] )
+        throw TestFailedException( "nick index lost a user renamed back" );
+
+    std::vector<std::string> wanted;
+    for ( int i = 0; i < lookups; ++i )
+    {
+        const int who = ( i * 7919 ) % users;
+        wanted.push_back( boost::to_upper_copy( who % 10 == 0 ? "renamed_" + Nick( who ) : Nick( who ) ) );
+    }
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    size_t linear_hits = 0;
+    for ( size_t i = 0; i < wanted.size(); ++i )
+        linear_hits += !!LinearFind( present, wanted[i] );
+    const double linear_ms = Milliseconds( start );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    size_t index_hits = 0;
+    for ( size_t i = 0; i < wanted.size(); ++i )
+        index_hits += !!list.FindByNick( wanted[i] );
+    const double index_ms = Milliseconds( start );
+    if ( linear_hits != index_hits )
+        throw TestFailedException( "indexed and linear FindByNick disagree" );
+    std::cout << boost::format( "%d users, %d FindByNick: linear %.2f ms, indexed %.2f ms (%.0fx)\n" )
+                 % present.size() % lookups % linear_ms % index_ms % ( linear_ms / std::max( index_ms, 0.001 ) );
+
+    //tab completion: a couple of typed letters narrow it down
+    const char* prefixes[] = { "tag_player1", "Clan_Player42", "renamed_TAG", "x" };
+    const int rounds = 100;
+    for ( size_t p = 0; p < sizeof( prefixes ) / sizeof( prefixes[0] ); ++p )
+    {
+        start = boost::posix_time::microsec_clock::universal_time();
+        size_t linear_matches = 0;
+        for ( int r = 0; r < rounds; ++r )
+            linear_matches = LinearPrefix( present, prefixes[p] );
+        const double linear_prefix_ms = Milliseconds( start );
+
+        start = boost::posix_time::microsec_clock::universal_time();
+        size_t index_matches = 0;
+        for ( int r = 0; r < rounds; ++r )
+            index_matches = list.FindByNickPrefix( prefixes[p] ).size();
+        const double index_prefix_ms = Milliseconds( start );
+        if ( linear_matches != index_matches )
+            throw TestFailedException( "indexed and linear prefix queries disagree" );
+        std::cout << boost::format( "prefix %-14s %5d matches x %d: linear %.2f ms, indexed %.2f ms\n" )
+                     % prefixes[p] % index_matches % rounds % linear_prefix_ms % index_prefix_ms;
+    }
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
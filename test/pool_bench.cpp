@@ -0,0 +1,154 @@
+#include <lslutils/pool.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+
+#include "common.h"
+
+namespace {
+
+//! about what a User carries around
+struct BenchUser
+{
+    BenchUser( const std::string& id, const std::string& nick )
+        : id( id ), nick( nick ), country( "XX" ), cpu( 0 ), status( 0 ), battlestatus( 0 ) {}
+    std::string id;
+    std::string nick;
+    std::string country;
+    int cpu;
+    int status;
+    long battlestatus;
+};
+
+typedef boost::shared_ptr<BenchUser> BenchUserPtr;
+
+struct NewAndWrap
+{
+    static const char* Name() { return "new + shared_ptr"; }
+    static BenchUserPtr Make( const std::string& id, const std::string& nick ) { return BenchUserPtr( new BenchUser( id, nick ) ); }
+};
+
+struct MakeShared
+{
+    static const char* Name() { return "make_shared"; }
+    static BenchUserPtr Make( const std::string& id, const std::string& nick ) { return boost::make_shared<BenchUser>( id, nick ); }
+};
+
+//! what MakePooled does with LSL_ENTITY_POOL set, whatever the build says
+struct Pooled
+{
+    static const char* Name() { return "entity pool"; }
+    static BenchUserPtr Make( const std::string& id, const std::string& nick )
+        { return boost::allocate_shared<BenchUser>( LSL::Util::PoolAllocator<BenchUser>::type(), id, nick ); }
+};
+
+struct Default
+{
+    static const char* Name() { return "MakePooled"; }
+    static BenchUserPtr Make( const std::string& id, const std::string& nick ) { return LSL::Util::MakePooled<BenchUser>( id, nick ); }
+};
+
+//! a fresh user has to be built from its arguments, with nothing left over from a recycled chunk
+template <class Factory>
+BenchUserPtr MakeChecked( const std::string& id, const std::string& nick )
+{
+    BenchUserPtr user = Factory::Make( id, nick );
+    if ( !user || user->id != id || user->nick != nick || user->country != "XX"
+         || user->cpu != 0 || user->status != 0 || user->battlestatus != 0 )
+        throw TestFailedException( std::string( Factory::Name() ) + " built a user that differs from its arguments" );
+    return user;
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+/** a server population with users leaving and new ones logging in,
+ * and a scan over everyone after every batch
+ */
+template <class Factory>
+long Churn( int users, int turnover, double& churn_ms, double& scan_ms )
+{
+    const std::string nicks[] = { "SomePlayerName", "[clan]LongerPlayerName", "x" };
+    std::deque<BenchUserPtr> online;
+    for ( int i = 0; i < users; ++i )
+        online.push_back( MakeChecked<Factory>( "id", nicks[i % 3] ) );
+    long checksum = 0;
+    churn_ms = scan_ms = 0;
+    const int batch = std::max( 1, users / 10 );
+    for ( int done = 0; done < turnover; done += batch )
+    {
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        for ( int i = 0; i < batch; ++i )
+        {
+            //scribble on the leaving user, its chunk is the next one handed out
+            online.front()->cpu = online.front()->status = -1;
+            online.pop_front();
+            online.push_back( MakeChecked<Factory>( "id", nicks[( done + i ) % 3] ) );
+        }
+        churn_ms += Milliseconds( start );
+        start = boost::posix_time::microsec_clock::universal_time();
+        for ( size_t i = 0; i < online.size(); ++i )
+            checksum += online[i]->cpu + online[i]->nick.size();
+        scan_ms += Milliseconds( start );
+    }
+    return checksum;
+}
+
+template <class Factory>
+void Report( int users, int turnover, long& checksum )
+{
+    double churn_ms, scan_ms;
+    const long sum = Churn<Factory>( users, turnover, churn_ms, scan_ms );
+    if ( checksum >= 0 && sum != checksum )
+        throw TestFailedException( std::string( Factory::Name() ) + " scanned a different population" );
+    checksum = sum;
+    std::cout << boost::format( "%-18s %d users, %d logins/logouts: churn %.2f ms, scans %.2f ms\n" )
+                 % Factory::Name() % users % turnover % churn_ms % scan_ms;
+}
+
+} // namespace
+
+//! usage: pool_bench [users] [turnover]
+int main( int argc, char** argv )
+{
+    const int users = argc > 1 ? atoi( argv[1] ) : 10000;
+    const int turnover = argc > 2 ? atoi( argv[2] ) : 1000000;
+    long checksum = -1;
+    Report<NewAndWrap>( users, turnover, checksum );
+    Report<MakeShared>( users, turnover, checksum );
+    Report<Pooled>( users, turnover, checksum );
+    Report<Default>( users, turnover, checksum );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
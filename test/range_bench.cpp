@@ -0,0 +1,130 @@
+#include <lsl/container/battlelist.h>
+#include <lslutils/global_interfaces.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+//! the bits of a battle a battle list view looks at
+struct BenchBattle : public LSL::HasKey<int>
+{
+    BenchBattle( int id, unsigned int players, unsigned int maxplayers )
+        : m_id( id ), players( players ), maxplayers( maxplayers ) {}
+    int key() const { return m_id; }
+    static std::string className() { return "BenchBattle"; }
+    unsigned int GetNumActivePlayers() const { return players; }
+    unsigned int GetMaxPlayers() const { return maxplayers; }
+    int m_id;
+    unsigned int players;
+    unsigned int maxplayers;
+};
+
+typedef LSL::ContainerBase<BenchBattle> BenchBattleList;
+typedef BenchBattleList::PointerType BenchBattlePtr;
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+//! Range() is the list in storage order and Filter() the part of it the predicate holds for, item for item
+void CheckViews( BenchBattleList& list )
+{
+    const std::vector<BenchBattlePtr> copied = list.Vectorize();
+    const std::vector<BenchBattlePtr> ranged( list.Range().begin(), list.Range().end() );
+    if ( ranged != copied )
+        throw TestFailedException( "Range differs from Vectorize" );
+    std::vector<BenchBattlePtr> expected;
+    for ( size_t i = 0; i < copied.size(); ++i )
+        if ( copied[i]->GetNumActivePlayers() < copied[i]->GetMaxPlayers() )
+            expected.push_back( copied[i] );
+    std::vector<BenchBattlePtr> filtered;
+    BOOST_FOREACH( const BenchBattlePtr& battle, list.Filter( LSL::Battle::HasFreeSlots() ) )
+        filtered.push_back( battle );
+    if ( filtered != expected )
+        throw TestFailedException( "Filter differs from filtering Vectorize" );
+}
+
+} // namespace
+
+//! usage: range_bench [battles] [scans]
+int main( int argc, char** argv )
+{
+    const int battles = argc > 1 ? atoi( argv[1] ) : 2000;
+    const int scans = argc > 2 ? atoi( argv[2] ) : 2000;
+
+    BenchBattleList list;
+    for ( int i = 0; i < battles; ++i )
+        list.Add( BenchBattlePtr( new BenchBattle( i, i % 17, 16 ) ) );
+    CheckViews( list );
+    //removal moves the last item into the gap, the views have to follow
+    for ( int i = 0; i < battles; i += 7 )
+        list.Remove( i );
+    CheckViews( list );
+    for ( int i = 0; i < battles; i += 7 )
+        list.Add( BenchBattlePtr( new BenchBattle( i, i % 17, 16 ) ) );
+    CheckViews( list );
+
+    //what a battle list refresh did: copy the list, then look at every battle
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    long copied_open = 0;
+    for ( int s = 0; s < scans; ++s )
+        BOOST_FOREACH( const BenchBattlePtr battle, list.Vectorize() )
+            copied_open += battle->GetNumActivePlayers() < battle->GetMaxPlayers();
+    const double copied_ms = Milliseconds( start );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    long range_open = 0;
+    for ( int s = 0; s < scans; ++s )
+        BOOST_FOREACH( const BenchBattlePtr& battle, list.Range() )
+            range_open += battle->GetNumActivePlayers() < battle->GetMaxPlayers();
+    const double range_ms = Milliseconds( start );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    long filter_open = 0;
+    for ( int s = 0; s < scans; ++s )
+        BOOST_FOREACH( const BenchBattlePtr& battle, list.Filter( LSL::Battle::HasFreeSlots() ) )
+            filter_open += !!battle;
+    const double filter_ms = Milliseconds( start );
+
+    if ( copied_open != range_open || copied_open != filter_open )
+        throw TestFailedException( "Vectorize, Range and Filter disagree on the open battles" );
+    std::cout << boost::format( "%d battles x %d scans, %d open: Vectorize %.2f ms, Range %.2f ms (%.1fx), Filter %.2f ms (%.1fx)\n" )
+                 % battles % scans % ( filter_open / scans ) % copied_ms
+                 % range_ms % ( copied_ms / std::max( range_ms, 0.001 ) )
+                 % filter_ms % ( copied_ms / std::max( filter_ms, 0.001 ) );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,101 @@
+#include <lsl/networking/iserver.h>
+#include <lsl/networking/capture.h>
+#include <lsl/networking/replay.h>
+
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "common.h"
+#include "loginburst.h"
+
+namespace {
+size_t allocation_count = 0;
+size_t AllocationCount() { return allocation_count; }
+}
+
+void* operator new( std::size_t size )
+{
+    ++allocation_count;
+    if ( void* p = std::malloc( size ? size : 1 ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete( void* p ) throw()
+{
+    std::free( p );
+}
+
+/** usage:
+ *  replay_bench                         replay a synthetic login burst
+ *  replay_bench capture.lslcap [--realtime]
+ *  replay_bench --write-capture out.lslcap   store the synthetic burst as a capture
+ */
+int main( int argc, char** argv )
+{
+    using namespace LSL;
+    if ( argc > 2 && std::strcmp( argv[1], "--write-capture" ) == 0 )
+    {
+        CaptureWriter writer;
+        if ( !writer.Open( argv[2] ) )
+            throw TestFailedException( std::string( "cannot write " ) + argv[2] );
+        const std::string burst = SyntheticLoginBurst( 5000, 600 );
+        for ( size_t off = 0; off < burst.size(); off += 1448 )
+            writer.Write( burst.data() + off, std::min<size_t>( 1448, burst.size() - off ) );
+        return 0;
+    }
+
+    boost::shared_ptr<Server> server = boost::make_shared<Server>();
+    ProtocolReplay replay( *server );
+    replay.SetAllocationCounter( &AllocationCount );
+
+    ReplayStatistics stats;
+    if ( argc > 1 )
+    {
+        CaptureReader capture;
+        if ( !capture.Open( argv[1] ) )
+            throw TestFailedException( std::string( "not a capture: " ) + argv[1] );
+        stats = replay.Run( capture, argc > 2 && std::strcmp( argv[2], "--realtime" ) == 0 );
+    }
+    else
+        stats = replay.Run( SyntheticLoginBurst( 5000, 600 ) );
+
+    std::cout << boost::format( "%d lines, %d bytes in %.3f s: %.0f lines/s, %.2f allocations/line\n" )
+                 % stats.lines % stats.bytes % stats.seconds % stats.LinesPerSecond() % stats.AllocationsPerLine();
+    std::cout << boost::format( "%-20s %8s %9s %9s %9s %9s\n" ) % "command" % "count" % "p50 us" % "p90 us" % "p99 us" % "max us";
+    for ( std::map<std::string, ReplayStatistics::Latency>::const_iterator it = stats.commands.begin(); it != stats.commands.end(); ++it )
+    {
+        const ReplayStatistics::Latency& l = it->second;
+        std::cout << boost::format( "%-20s %8d %9.2f %9.2f %9.2f %9.2f\n" ) % it->first % l.count % l.p50 % l.p90 % l.p99 % l.max;
+    }
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,47 @@
+#ifndef LSL_TESTS_SCRIPTGEN_H
+#define LSL_TESTS_SCRIPTGEN_H
+
+#include <boost/format.hpp>
+#include <sstream>
+#include <string>
+
+/** a host's script.txt the way Spring::WriteScriptTxt lays it out:
+ * players are named Player<n> and split into two ally teams, one AI per \param ai_every players
+ */
+inline std::string SyntheticScript( int players, int ai_every = 4 )
+{
+    const int ais = ai_every > 0 ? players / ai_every : 0;
+    const int teams = players + ais;
+    std::ostringstream out;
+    out << "[GAME]\n{\n"
+           "\tHostIP=;\n\tHostPort=8452;\n\tIsHost=1;\n\tMyPlayerName=Player0;\n\n"
+           "\tModHash=1234567890;\n\tMapHash=-987654321;\n"
+           "\tMapname=DeltaSiegeDry;\n\tGameType=Balanced Annihilation V7.72;\n\n"
+           "\tstartpostype=2;\n"
+           "\t[mapoptions]\n\t{\n\t\tmaxspeed=3;\n\t\tcloud=0.5;\n\t}\n"
+           "\t[modoptions]\n\t{\n\t\trelayhoststartpostype=2;\n";
+    for ( int i = 0; i < 40; ++i )
+        out << boost::format( "\t\tmodoption%d=%d;\n" ) % i % ( i * 3 );
+    out << "\t}\n\tNumRestrictions=20;\n\t[RESTRICT]\n\t{\n";
+    for ( int i = 0; i < 20; ++i )
+        out << boost::format( "\t\tUnit%d=armunit%d;\n\t\tLimit%d=%d;\n" ) % i % i % i % ( i % 3 );
+    out << boost::format( "\t}\n\n\tNumPlayers=%d;\n\tNumUsers=%d;\n\n" ) % players % teams;
+    for ( int i = 0; i < players; ++i )
+        out << boost::format( "\t[PLAYER%d]\n\t{\n\t\tName=Player%d;\n\t\tCountryCode=de;\n\t\tSpectator=0;\n"
+                              "\t\tRank=%d;\n\t\tIsFromDemo=0;\n\t\tTeam=%d;\n\t}\n" ) % i % i % ( i % 7 ) % i;
+    for ( int i = 0; i < ais; ++i )
+        out << boost::format( "\t[AI%d]\n\t{\n\t\tName=Bot%d;\n\t\tShortName=KAIK;\n\t\tVersion=0.13;\n\t\tTeam=%d;\n"
+                              "\t\tIsFromDemo=0;\n\t\tHost=%d;\n\t\t[Options]\n\t\t{\n\t\t}\n\t}\n" ) % i % i % ( players + i ) % ( i * ai_every );
+    out << "\n";
+    for ( int i = 0; i < teams; ++i )
+        out << boost::format( "\t[TEAM%d]\n\t{\n\t\tTeamLeader=%d;\n\t\tStartPosX=%d;\n\t\tStartPosZ=%d;\n\t\tAllyTeam=%d;\n"
+                              "\t\tRGBColor=0.%03d 0.5 0.25;\n\t\tSide=ARM;\n\t\tHandicap=0;\n\t}\n" )
+               % i % ( i < players ? i : ( i - players ) * ai_every ) % ( 100 * i ) % ( 50 * i ) % ( i % 2 ) % ( i * 7 % 1000 );
+    for ( int i = 0; i < 2; ++i )
+        out << boost::format( "\t[ALLYTEAM%d]\n\t{\n\t\tNumAllies=0;\n\t\tStartRectLeft=%d;\n\t\tStartRectTop=0;\n"
+                              "\t\tStartRectRight=%d;\n\t\tStartRectBottom=1;\n\t}\n" ) % i % ( 0.5 * i ) % ( 0.5 + 0.5 * i );
+    out << boost::format( "\tNumTeams=%d;\n\tNumAllyTeams=2;\n}\n" ) % teams;
+    return out.str();
+}
+
+#endif // LSL_TESTS_SCRIPTGEN_H
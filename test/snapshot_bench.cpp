@@ -0,0 +1,156 @@
+#include <lsl/networking/snapshot.h>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "common.h"
+
+namespace {
+
+struct Record
+{
+    Record( int key, long value ) : key( key ), value( value ) {}
+    int key;
+    long value;
+};
+
+//! the checksum lives next to the table, so a torn view would not add up
+struct Version
+{
+    LSL::SnapshotTable<Record> records;
+    long sum;
+};
+
+typedef boost::shared_ptr<const Version> VersionPtr;
+
+struct Shared
+{
+    Shared() : done( false ), reads( 0 ), torn( 0 ) {}
+    VersionPtr current;
+    boost::atomic<bool> done;
+    boost::atomic<long> reads;
+    boost::atomic<long> torn;
+};
+
+void Reader( Shared& shared )
+{
+    while ( !shared.done.load() )
+    {
+        const VersionPtr version = boost::atomic_load( &shared.current );
+        long sum = 0;
+        for ( size_t i = 0; i < version->records.size(); ++i )
+            sum += version->records[i].value;
+        if ( sum != version->sum )
+            ++shared.torn;
+        ++shared.reads;
+    }
+}
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+} // namespace
+
+//! usage: snapshot_bench [records] [batches] [readers]
+int main( int argc, char** argv )
+{
+    const int records = argc > 1 ? atoi( argv[1] ) : 10000;
+    const int batches = argc > 2 ? atoi( argv[2] ) : 20000;
+    const int readers = argc > 3 ? atoi( argv[3] ) : 3;
+    const int touches = 20;
+
+    LSL::SnapshotTableWriter<int, Record> writer;
+    std::vector<long> values( records, 0 );
+    long sum = 0;
+    for ( int k = 0; k < records; ++k )
+        writer.Set( k, boost::shared_ptr<const Record>( new Record( k, 0 ) ) );
+    Shared shared;
+    boost::shared_ptr<Version> first( new Version() );
+    first->records = writer.Publish();
+    first->sum = 0;
+    shared.current = first;
+
+    boost::thread_group group;
+    for ( int r = 0; r < readers; ++r )
+        group.create_thread( boost::bind( &Reader, boost::ref( shared ) ) );
+
+    //a batch: some statuses change, somebody leaves, somebody comes back
+    srand( 42 );
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for ( int b = 1; b <= batches; ++b )
+    {
+        for ( int t = 0; t < touches; ++t )
+        {
+            const int k = rand() % records;
+            sum += b - values[k];
+            values[k] = b;
+            writer.Set( k, boost::shared_ptr<const Record>( new Record( k, b ) ) );
+        }
+        const int leaver = rand() % records;
+        writer.Remove( leaver );
+        writer.Set( leaver, boost::shared_ptr<const Record>( new Record( leaver, values[leaver] ) ) );
+
+        boost::shared_ptr<Version> version( new Version() );
+        version->records = writer.Publish();
+        version->sum = sum;
+        boost::atomic_store( &shared.current, VersionPtr( version ) );
+    }
+    const double publish_ms = Milliseconds( start );
+    shared.done = true;
+    group.join_all();
+
+    //what publishing amounts to without shared chunks: a fresh copy of every record pointer
+    std::vector<boost::shared_ptr<const Record> > flat;
+    for ( int k = 0; k < records; ++k )
+        flat.push_back( boost::shared_ptr<const Record>( new Record( k, values[k] ) ) );
+    start = boost::posix_time::microsec_clock::universal_time();
+    size_t copied = 0;
+    for ( int b = 0; b < batches; ++b )
+    {
+        std::vector<boost::shared_ptr<const Record> > copy( flat );
+        copied += copy.size();
+    }
+    const double copy_ms = Milliseconds( start );
+
+    if ( shared.torn.load() != 0 )
+        throw TestFailedException( ( boost::format( "%d of %d snapshot reads were inconsistent" )
+                                     % shared.torn.load() % shared.reads.load() ).str() );
+    std::cout << boost::format( "%d records, %d batches of %d changes, %d readers: publish %.2f ms total (%.1f us per batch), "
+                                "flat copies %.2f ms; %d consistent reads\n" )
+                 % records % batches % touches % readers % publish_ms % ( publish_ms * 1000 / batches )
+                 % copy_ms % shared.reads.load();
+    return copied == 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,785 @@
+#include <lsl/battle/tdfcontainer.h>
+#include <lsl/battle/tdfdocument.h>
+#include <lsl/battle/tdfreader.h>
+#include <lsl/battle/tdfschema.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+#include "common.h"
+#include "scriptgen.h"
+
+namespace {
+size_t allocation_count = 0;
+}
+
+void* operator new( std::size_t size )
+{
+    ++allocation_count;
+    if ( void* p = std::malloc( size ? size : 1 ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete( void* p ) throw()
+{
+    std::free( p );
+}
+
+namespace {
+
+using namespace LSL::TDF;
+using LSL::StringRef;
+using LSL::lslColor;
+
+struct LegacyToken
+{
+    Token::TokenType type;
+    std::string value_s;
+    std::string pos_string;
+};
+
+/** what TDF::Tokenizer used to be: a char at a time off an istream, position strings
+ * formatted for every token, everything copied into the token
+ */
+class LegacyTokenizer
+{
+public:
+    LegacyTokenizer( std::istream& stream ) : m_stream( stream ), m_line( 1 ), m_column( 1 ), m_skip_eol( false ) {}
+
+    bool Good() { return m_stream.good(); }
+
+    char Peek() { return Good() ? m_stream.peek() : 0; }
+
+    char Get()
+    {
+        if ( !Good() )
+            return 0;
+        const char c = m_stream.get();
+        if ( !m_skip_eol && ( c == 10 || c == 13 ) )
+        {
+            ++m_line;
+            m_column = 1;
+            const char nc = m_stream.peek();
+            if ( ( nc == 10 || nc == 13 ) && nc != c )
+                m_skip_eol = true;
+        }
+        else
+        {
+            if ( !m_skip_eol )
+                ++m_column;
+            m_skip_eol = false;
+        }
+        return c;
+    }
+
+    LegacyToken Take()
+    {
+        LegacyToken token;
+        for ( ;; )
+        {
+            while ( Good() && IsWhitespace( Peek() ) )
+                Get();
+            if ( !Good() )
+            {
+                token.type = Token::type_eof;
+                token.pos_string = "EOF";
+                return token;
+            }
+            std::stringstream pos;
+            pos << "line " << m_line << " , column " << m_column;
+            token.pos_string = pos.str();
+            const char c = Get();
+            switch ( c )
+            {
+                case '[':
+                    token.type = Token::type_section_name;
+                    while ( Good() )
+                    {
+                        const char n = Get();
+                        if ( n == '\\' )
+                            token.value_s += Get();
+                        else if ( n == ']' )
+                            return token;
+                        else
+                            token.value_s += n;
+                    }
+                    return token;
+                case '{': token.type = Token::type_enter_section; token.value_s = c; return token;
+                case '}': token.type = Token::type_leave_section; token.value_s = c; return token;
+                case ';': token.type = Token::type_semicolon; token.value_s = c; return token;
+                case '=':
+                    token.type = Token::type_entry_value;
+                    while ( Good() && Peek() != ';' )
+                        token.value_s += Get();
+                    return token;
+                case '/':
+                    if ( Peek() == '/' )
+                    {
+                        std::string tmp;
+                        std::getline( m_stream, tmp );
+                        ++m_line;
+                        m_column = 1;
+                        continue;
+                    }
+                    else if ( Peek() == '*' )
+                    {
+                        Get();
+                        while ( Good() && !( Get() == '*' && Peek() == '/' ) ) {}
+                        Get();
+                        continue;
+                    }
+                    // a lone '/' starts an entry name
+                    // fall through
+                default:
+                    token.type = Token::type_entry_name;
+                    token.value_s = c;
+                    while ( Good() && Peek() != '=' )
+                        token.value_s += Get();
+                    return token;
+            }
+        }
+    }
+
+    //! the old tokenizer buffered every token it ever read
+    std::deque<LegacyToken> buffer;
+
+private:
+    std::istream& m_stream;
+    int m_line;
+    int m_column;
+    bool m_skip_eol;
+};
+
+double Milliseconds( const boost::posix_time::ptime& start )
+{
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() / 1000.0;
+}
+
+size_t LegacyTokenize( const std::string& script )
+{
+    std::istringstream in( script );
+    LegacyTokenizer tokenizer( in );
+    size_t bytes = 0;
+    for ( ;; )
+    {
+        tokenizer.buffer.push_back( tokenizer.Take() );
+        if ( tokenizer.buffer.back().type == Token::type_eof )
+            return bytes;
+        bytes += tokenizer.buffer.back().value_s.size();
+    }
+}
+
+size_t Tokenize( const std::string& script )
+{
+    Tokenizer tokenizer;
+    tokenizer.EnterBuffer( script.data(), script.size() );
+    size_t bytes = 0;
+    for ( Token t = tokenizer.TakeToken(); !t.IsEOF(); t = tokenizer.TakeToken() )
+        bytes += t.value.size();
+    return bytes;
+}
+
+//! same tokens, and the lazily computed positions have to match the ones formatted up front
+void CompareTokens( const std::string& script )
+{
+    std::istringstream in( script );
+    LegacyTokenizer legacy( in );
+    Tokenizer tokenizer;
+    tokenizer.EnterBuffer( script.data(), script.size() );
+    for ( ;; )
+    {
+        const LegacyToken expected = legacy.Take();
+        const Token t = tokenizer.TakeToken();
+        if ( expected.type != t.type || expected.value_s != t.Value() || expected.pos_string != tokenizer.Position( t ) )
+            throw TestFailedException( ( boost::format( "token mismatch at %s: '%s' vs '%s' at %s" )
+                                         % expected.pos_string % expected.value_s % t.Value() % tokenizer.Position( t ) ).str() );
+        if ( t.IsEOF() )
+            return;
+    }
+}
+
+void CheckParse()
+{
+    const std::string script = "// comment\n[GAME]\n{\n\tMapName=Delta Siege;\r\n\t[PLAYER0]\n\t{\n\t\tName=Some\\ One;\n\t}\n"
+                               "\t/* [PLAYER1] { Name=x; } */\n\t[sec\\]tion]\n\t{\n\t\tkey=1\n\t}\n}\n";
+    CompareTokens( script );
+    int errors = 0;
+    std::istringstream in( script );
+    PDataList root( ParseTDF( in, &errors ) );
+    PDataList game( root->Find( "game" ) );
+    if ( !game.ok() || game->GetString( "mapname" ) != "Delta Siege" )
+        throw TestFailedException( "GAME/MapName not parsed" );
+    if ( PDataList( game->Find( "PLAYER0" ) )->GetString( "Name" ) != "Some\\ One" )
+        throw TestFailedException( "entry values must be taken verbatim" );
+    if ( game->Find( "PLAYER1" ).ok() || !game->Find( "sec]tion" ).ok() )
+        throw TestFailedException( "comment or escaped section name mishandled" );
+    //the missing ';' behind key=1
+    if ( errors != 1 )
+        throw TestFailedException( ( boost::format( "expected one error, got %d" ) % errors ).str() );
+
+    Document doc;
+    if ( doc.Parse( script.data(), script.size() ) != 1 )
+        throw TestFailedException( "document and ParseTDF disagree on the errors" );
+    if ( doc.Root().FindByPath( "game/player0/name" ).Value() != "Some\\ One"
+         || doc.Root().FindByPath( "/GAME/sec]tion/../MapName" ).Value() != "Delta Siege"
+         || doc.Root().FindByPath( "GAME/PLAYER1" ).ok() )
+        throw TestFailedException( "document paths not resolved like DataList::FindByPath" );
+}
+
+//! both trees have the same sections and entries in the same order
+void CompareTrees( PDataList list, NodeRef section )
+{
+    size_t children = 0;
+    for ( PNode node = list->First(); node.Ok() && node != list->End(); node = list->Next( node ), ++children )
+    {
+        const NodeRef child = section.Child( children );
+        PDataList sublist( node );
+        if ( child.Name() != node->Name() || child.IsSection() != sublist.ok() )
+            throw TestFailedException( ( boost::format( "document has %s where the tree has %s" ) % child.Name() % node->Name() ).str() );
+        if ( sublist.ok() )
+            CompareTrees( sublist, child );
+        else if ( child.Value() != PDataLeaf( node )->GetValue() )
+            throw TestFailedException( ( boost::format( "%s differs" ) % node->Name() ).str() );
+    }
+    if ( children != section.NumChildren() )
+        throw TestFailedException( ( boost::format( "%s has %d children in the tree, %d in the document" )
+                                     % list->Name() % children % section.NumChildren() ).str() );
+}
+
+//! what GetBattleFromScript looks up for every player
+template <class Section>
+long ReadPlayers( const Section& game )
+{
+    long sum = 0;
+    const int players = game->GetInt( "NumUsers" );
+    for ( int i = 0; i < players; ++i )
+    {
+        Section player( game->Find( "PLAYER" + LSL::Util::ToString( i ) ) );
+        Section bot( game->Find( "AI" + LSL::Util::ToString( i ) ) );
+        if ( !player.ok() )
+            player = bot;
+        if ( !player.ok() )
+            continue;
+        sum += player->GetString( "Name" ).size() + player->GetInt( "Spectator", 0 ) + player->GetInt( "Rank", -1 );
+        Section team( game->Find( "TEAM" + LSL::Util::ToString( player->GetInt( "Team" ) ) ) );
+        if ( team.ok() )
+            sum += team->GetInt( "AllyTeam" ) + team->GetInt( "StartPosX" ) + team->GetString( "Side" ).size();
+    }
+    return sum;
+}
+
+//! lets ReadPlayers use a NodeRef like a PDataList
+struct SectionPtr
+{
+    SectionPtr( NodeRef node ) : section( node.IsSection() ? node : NodeRef() ) {}
+    const NodeRef* operator->() const { return &section; }
+    bool ok() const { return section.ok(); }
+    NodeRef section;
+};
+
+//! writes every event down, to compare whole and piecewise reads
+struct EventLog : public Handler
+{
+    virtual bool EnterSection( StringRef name ) { log << "[" << name << "]"; return true; }
+    virtual bool Entry( StringRef name, StringRef value ) { log << name << "=" << value << ";"; return true; }
+    virtual bool LeaveSection() { log << "}"; return true; }
+    std::ostringstream log;
+};
+
+//! feeds \param script in pieces of \param chunk bytes, carrying what the reader left over
+std::string ReadInPieces( const std::string& script, size_t chunk )
+{
+    EventLog events;
+    Reader reader( events );
+    std::string pending;
+    for ( size_t off = 0; off < script.size(); off += chunk )
+    {
+        pending.append( script, off, chunk );
+        pending.erase( 0, reader.Feed( pending.data(), pending.size() ) );
+    }
+    reader.Finish( pending.data(), pending.size() );
+    if ( reader.NumErrors() != 0 )
+        throw TestFailedException( "piecewise read reported errors" );
+    return events.log.str();
+}
+
+//! GAME/PLAYERn/Name of every player, without looking at anything else
+struct PlayerNames : public Handler
+{
+    PlayerNames() : depth( 0 ), in_player( false ) {}
+    virtual bool EnterSection( StringRef name )
+    {
+        in_player = ++depth == 2 && name.size() > 6 && name.substr( 0, 6 ) == "PLAYER";
+        return true;
+    }
+    virtual bool Entry( StringRef name, StringRef value )
+    {
+        if ( in_player && name == "Name" )
+            names.push_back( value.to_string() );
+        return true;
+    }
+    virtual bool LeaveSection() { in_player = false; --depth; return true; }
+    int depth;
+    bool in_player;
+    std::vector<std::string> names;
+};
+
+void CheckReader( const std::string& script )
+{
+    EventLog whole;
+    if ( !ReadTDF( script.data(), script.size(), whole ) )
+        throw TestFailedException( "reader stopped without being asked to" );
+    const size_t chunks[] = { 1, 7, 64, 4096 };
+    for ( size_t c = 0; c < sizeof( chunks ) / sizeof( chunks[0] ); ++c )
+        if ( ReadInPieces( script, chunks[c] ) != whole.log.str() )
+            throw TestFailedException( ( boost::format( "reading in %d byte pieces differs" ) % chunks[c] ).str() );
+
+    const char* paths[] = { "GAME/Mapname", "game/gametype", "GAME/PLAYER3/Name", "GAME/modoptions/modoption7", "GAME/missing" };
+    PathCollector collector( paths, paths + 4 );
+    if ( ReadTDF( script.data(), script.size(), collector ) )
+        throw TestFailedException( "collector should stop once it has everything" );
+    if ( collector.Get( "GAME/MapName" ) != "DeltaSiegeDry" || collector.Get( "GAME/PLAYER3/NAME" ) != "Player3"
+         || collector.Get( "GAME/modoptions/modoption7" ) != "21" )
+        throw TestFailedException( "collector missed a value" );
+    PathCollector missing( paths, paths + 5 );
+    if ( !ReadTDF( script.data(), script.size(), missing ) || missing.Found( paths[4] ) || !missing.Found( paths[3] ) )
+        throw TestFailedException( "collector found a path that isn't there" );
+}
+
+/** what TDFWriter used to be: stringstream conversions for every value,
+ * indentation a tab at a time
+ */
+class LegacyWriter
+{
+public:
+    LegacyWriter( std::stringstream& s ) : m_stream( s ), m_depth( 0 ) {}
+    void EnterSection( const std::string& name )
+    {
+        Indent();
+        m_stream << "[" << name << "]\n";
+        Indent();
+        m_stream << "{\n";
+        ++m_depth;
+    }
+    void LeaveSection()
+    {
+        --m_depth;
+        Indent();
+        m_stream << "}\n";
+    }
+    void Indent()
+    {
+        for ( int i = 0; i < m_depth; ++i )
+            m_stream << "\t";
+    }
+    void Append( const std::string& name, const std::string& value )
+    {
+        Indent();
+        m_stream << name << "=" << value << ";\n";
+    }
+    template <class T>
+    void Append( const std::string& name, T value ) { Append( name, LSL::Util::ToString( value ) ); }
+private:
+    std::stringstream& m_stream;
+    int m_depth;
+};
+
+//! only the new writer has these, keeps WriteTeams compiling for the old one
+void AppendRange( TDFWriter& tdf, const std::string& name, const double* begin, const double* end ) { tdf.Append( name, begin, end ); }
+void AppendRange( LegacyWriter&, const std::string&, const double*, const double* ) {}
+void AppendFixed( TDFWriter& tdf, const std::string& name, double value, int decimals ) { tdf.Append( name, value, decimals ); }
+void AppendFixed( LegacyWriter&, const std::string&, double, int ) {}
+
+//! the PLAYER/TEAM/ALLYTEAM part of WriteScriptTxt, for both writers
+template <class Writer>
+void WriteTeams( Writer& tdf, int players, bool legacy )
+{
+    tdf.EnterSection( "GAME" );
+    tdf.Append( "NumPlayers", players );
+    for ( int i = 0; i < players; ++i )
+    {
+        tdf.EnterSection( "PLAYER" + LSL::Util::ToString( i ) );
+        tdf.Append( "Name", "Player" + LSL::Util::ToString( i ) );
+        tdf.Append( "CountryCode", std::string( "de" ) );
+        tdf.Append( "Spectator", i % 9 == 0 );
+        tdf.Append( "Rank", i % 7 );
+        tdf.Append( "Team", i );
+        tdf.LeaveSection();
+    }
+    for ( int i = 0; i < players; ++i )
+    {
+        tdf.EnterSection( "TEAM" + LSL::Util::ToString( i ) );
+        tdf.Append( "TeamLeader", i );
+        tdf.Append( "StartPosX", 100 * i - 3000 );
+        tdf.Append( "AllyTeam", i % 2 );
+        const double rgb[3] = { ( i * 37 % 256 ) / 255.0, ( i * 91 % 256 ) / 255.0, 1.0 };
+        if ( legacy )
+            tdf.Append( "RGBColor", LSL::Util::ToString( rgb[0] ) + ' ' + LSL::Util::ToString( rgb[1] ) + ' ' + LSL::Util::ToString( rgb[2] ) );
+        else
+            AppendRange( tdf, "RGBColor", rgb, rgb + 3 );
+        tdf.Append( "Handicap", 0u );
+        tdf.LeaveSection();
+    }
+    tdf.EnterSection( "ALLYTEAM0" );
+    tdf.Append( "NumAllies", 0 );
+    if ( legacy )
+        tdf.Append( "StartRectLeft", boost::format( "%.3f" ) % ( 17 / 200.0 ) );
+    else
+        AppendFixed( tdf, "StartRectLeft", 17 / 200.0, 3 );
+    tdf.LeaveSection();
+    tdf.LeaveSection();
+}
+
+void CheckWriter( int players )
+{
+    std::stringstream legacy_out;
+    {
+        LegacyWriter legacy( legacy_out );
+        WriteTeams( legacy, players, true );
+    }
+    BufferSink buffer;
+    {
+        TDFWriter tdf( buffer );
+        WriteTeams( tdf, players, false );
+    }
+    if ( buffer.Data() != legacy_out.str() )
+        throw TestFailedException( "new writer output differs from the stringstream one" );
+    std::stringstream compat_out;
+    {
+        TDFWriter tdf( compat_out );
+        WriteTeams( tdf, players, false );
+    }
+    if ( compat_out.str() != buffer.Data() )
+        throw TestFailedException( "stringstream interface output differs" );
+
+    const std::string path = "tdf_bench_script.txt";
+    {
+        FileSink file( path );
+        TDFWriter tdf( file );
+        WriteTeams( tdf, players, false );
+    }
+    std::ifstream in( path.c_str(), std::ios::binary );
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove( path.c_str() );
+    if ( contents.str() != buffer.Data() )
+        throw TestFailedException( "file sink wrote something else" );
+}
+
+//! the TEAMn fields ReadPlayers adds up
+struct Team
+{
+    int ally;
+    int startx;
+    std::string side;
+};
+
+//! ReadPlayers' names as Keys, resolved once
+struct PlayerKeys
+{
+    PlayerKeys() : numusers( "NumUsers" ), name( "Name" ), spectator( "Spectator" ), rank( "Rank" ), team( "Team" )
+    {
+        teams.Int( "AllyTeam", &Team::ally ).Int( "StartPosX", &Team::startx ).String( "Side", &Team::side );
+    }
+    const Key numusers, name, spectator, rank, team;
+    Schema<Team> teams;
+};
+
+//! ReadPlayers with Keys and a Schema, sums up the same
+template <class Section, class SectionRef>
+long ReadPlayersByKey( const Section& game, const PlayerKeys& keys )
+{
+    long sum = 0;
+    const int players = game->GetInt( keys.numusers );
+    for ( int i = 0; i < players; ++i )
+    {
+        Section player( game->Find( Key( "PLAYER", i ) ) );
+        Section bot( game->Find( Key( "AI", i ) ) );
+        if ( !player.ok() )
+            player = bot;
+        if ( !player.ok() )
+            continue;
+        sum += player->GetString( keys.name ).size() + player->GetInt( keys.spectator, 0 ) + player->GetInt( keys.rank, -1 );
+        Team team;
+        if ( keys.teams.Extract( SectionRef( game->Find( Key( "TEAM", player->GetInt( keys.team ) ) ) ), team ) )
+            sum += team.ally + team.startx + team.side.size();
+    }
+    return sum;
+}
+
+//! the numbers a script holds, and some it shouldn't
+const char* const numbers[] = { "0", "17", "-3", "+42", " 12", "7abc", "2147483647", "-2147483648", "123456789012345678",
+                                "99999999999999999999", "-99999999999999999999", "0.5", "-0.25", "1e3", "3.75 ", ".5", "1.",
+                                "0.0039215", "1e400", "-1e400", "1e-400", "x", "", "-" };
+const size_t num_numbers = sizeof( numbers ) / sizeof( numbers[0] );
+
+//! FromString, but 0 for an empty string instead of whatever was on the stack
+template <class T>
+T Streamed( const char* text )
+{
+    std::istringstream in( text );
+    T result = 0;
+    in >> result;
+    return result;
+}
+
+//! Util::ParseLong and ParseDouble read what a stream reads, out of range values included, whatever the C locale
+void CheckNumbers()
+{
+    const char* locales[] = { "C", "de_DE.UTF-8", "fr_FR.UTF-8" };
+    const std::string previous = setlocale( LC_NUMERIC, NULL );
+    for ( size_t l = 0; l < sizeof( locales ) / sizeof( locales[0] ); ++l )
+    {
+        if ( !setlocale( LC_NUMERIC, locales[l] ) )
+            continue;
+        for ( size_t i = 0; i < num_numbers; ++i )
+        {
+            const char* const end = numbers[i] + strlen( numbers[i] );
+            bool int_ok, double_ok;
+            const long parsed_int = LSL::Util::ParseLong( numbers[i], end, &int_ok );
+            const double parsed_double = LSL::Util::ParseDouble( numbers[i], end, &double_ok );
+            const long streamed_int = Streamed<long>( numbers[i] );
+            const double streamed_double = Streamed<double>( numbers[i] );
+            if ( parsed_int != streamed_int || parsed_double != streamed_double )
+                throw TestFailedException( ( boost::format( "\"%s\" in %s: %d %g parsed, %d %g streamed" ) % numbers[i] % locales[l]
+                                             % parsed_int % parsed_double % streamed_int % streamed_double ).str() );
+            const bool has_digits = strpbrk( numbers[i], "0123456789" ) != NULL;
+            if ( int_ok != ( has_digits && numbers[i][0] != '.' ) || double_ok != has_digits )
+                throw TestFailedException( ( boost::format( "\"%s\": wrong success flag" ) % numbers[i] ).str() );
+        }
+    }
+    setlocale( LC_NUMERIC, previous.c_str() );
+}
+
+//! Keys and Paths find what strings do, in trees and documents
+void CheckKeys( const PDataList& root, const Document& doc )
+{
+    const char* paths[] = { "GAME/PLAYER3/Name", "/game/team2/../ALLYTEAM0/StartRectTop", "GAME/./player1/", "GAME/PLAYER9999", "", "/" };
+    for ( size_t i = 0; i < sizeof( paths ) / sizeof( paths[0] ); ++i )
+    {
+        const Path path( paths[i] );
+        if ( root->FindByPath( path ) != root->FindByPath( paths[i] ) || doc.Root().FindByPath( path ) != doc.Root().FindByPath( paths[i] ) )
+            throw TestFailedException( ( boost::format( "path %s resolved differently" ) % paths[i] ).str() );
+    }
+    const PDataList game( root->Find( Key( "game" ) ) );
+    if ( Key( "Player", 12 ).Lower() != "player12" || Key( "AI", -1 ).Lower() != "ai-1"
+         || PDataList( game->Find( Key( "PLAYER", 2 ) ) ) != PDataList( game->Find( "PLAYER2" ) ) )
+        throw TestFailedException( "indexed key mismatch" );
+}
+
+//! trees and documents read the same colour from the same entry, scaled by 256 and clamped like ParseFloatColour
+void CheckColours()
+{
+    const std::string script = "[GAME]\n{\n\tTeamColor=0.5 0.25 0.999;\n\tBright=1.5 -0.2 1;\n\tShort=0.5 0.5;\n}\n";
+    const PDataList game( PDataList( ParseTDF( script.data(), script.size() ) )->Find( "GAME" ) );
+    Document doc;
+    doc.Parse( script.data(), script.size() );
+    const NodeRef doc_game = doc.Root().Find( "GAME" );
+    const lslColor fallback( 1, 2, 3 );
+    const char* names[] = { "TeamColor", "Bright", "Short", "Missing" };
+    const lslColor expected[] = { lslColor( 128, 64, 255 ), lslColor( 255, 0, 255 ), fallback, fallback };
+    for ( size_t i = 0; i < sizeof( names ) / sizeof( names[0] ); ++i )
+    {
+        bool tree_worked, doc_worked;
+        const lslColor tree = game->GetColour( names[i], fallback, &tree_worked );
+        const lslColor document = doc_game.GetColour( names[i], fallback, &doc_worked );
+        if ( tree != expected[i] || document != expected[i] || tree_worked != doc_worked || tree_worked != ( i < 2 ) )
+            throw TestFailedException( ( boost::format( "%s: tree %d %d %d, document %d %d %d" ) % names[i]
+                                         % int( tree.Red() ) % int( tree.Green() ) % int( tree.Blue() )
+                                         % int( document.Red() ) % int( document.Green() ) % int( document.Blue() ) ).str() );
+    }
+}
+
+} // namespace
+
+//! usage: tdf_bench [players]
+int main( int argc, char** argv )
+{
+    const int players = argc > 1 ? atoi( argv[1] ) : 64;
+    const int rounds = 200;
+    CheckParse();
+    CheckColours();
+    const std::string script = SyntheticScript( players );
+    CompareTokens( script );
+
+    size_t allocations = allocation_count;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    size_t legacy_bytes = 0;
+    for ( int r = 0; r < rounds; ++r )
+        legacy_bytes += LegacyTokenize( script );
+    const double legacy_ms = Milliseconds( start );
+    const size_t legacy_allocations = ( allocation_count - allocations ) / rounds;
+
+    allocations = allocation_count;
+    start = boost::posix_time::microsec_clock::universal_time();
+    size_t bytes = 0;
+    for ( int r = 0; r < rounds; ++r )
+        bytes += Tokenize( script );
+    const double buffer_ms = Milliseconds( start );
+    const size_t buffer_allocations = ( allocation_count - allocations ) / rounds;
+    if ( bytes != legacy_bytes )
+        throw TestFailedException( "tokenizers disagree on the token contents" );
+
+    std::cout << boost::format( "%d players, %d KiB script, %d rounds\n" ) % players % ( script.size() / 1024 ) % rounds;
+    std::cout << boost::format( "tokenize: istream %.2f ms (%d allocations), buffer %.2f ms (%d allocations), %.1fx\n" )
+                 % legacy_ms % legacy_allocations % buffer_ms % buffer_allocations % ( legacy_ms / std::max( buffer_ms, 0.001 ) );
+
+    allocations = allocation_count;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( int r = 0; r < rounds; ++r )
+        ParseTDF( script.data(), script.size() );
+    const double tree_ms = Milliseconds( start );
+    const size_t tree_allocations = ( allocation_count - allocations ) / rounds;
+
+    Document doc;
+    allocations = allocation_count;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( int r = 0; r < rounds; ++r )
+        doc.Parse( script.data(), script.size() );
+    const double doc_ms = Milliseconds( start );
+    const size_t doc_allocations = ( allocation_count - allocations ) / rounds;
+    std::cout << boost::format( "parse: tree %.2f ms (%d allocations), document %.2f ms (%d allocations), %.1fx\n" )
+                 % tree_ms % tree_allocations % doc_ms % doc_allocations % ( tree_ms / std::max( doc_ms, 0.001 ) );
+
+    const PDataList root( ParseTDF( script.data(), script.size() ) );
+    CompareTrees( root, doc.Root() );
+    const PDataList game( root->Find( "GAME" ) );
+    const SectionPtr doc_game( doc.Root().Find( "GAME" ) );
+    start = boost::posix_time::microsec_clock::universal_time();
+    long tree_sum = 0;
+    for ( int r = 0; r < rounds; ++r )
+        tree_sum += ReadPlayers( game );
+    const double tree_read_ms = Milliseconds( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    long doc_sum = 0;
+    for ( int r = 0; r < rounds; ++r )
+        doc_sum += ReadPlayers( doc_game );
+    const double doc_read_ms = Milliseconds( start );
+    if ( tree_sum != doc_sum )
+        throw TestFailedException( "tree and document read different players" );
+    std::cout << boost::format( "read players: tree %.2f ms, document %.2f ms, %.1fx\n" )
+                 % tree_read_ms % doc_read_ms % ( tree_read_ms / std::max( doc_read_ms, 0.001 ) );
+
+    CheckNumbers();
+    CheckKeys( root, doc );
+    const PlayerKeys keys;
+    start = boost::posix_time::microsec_clock::universal_time();
+    long tree_key_sum = 0;
+    for ( int r = 0; r < rounds; ++r )
+        tree_key_sum += ReadPlayersByKey<PDataList, PDataList>( game, keys );
+    const double tree_key_ms = Milliseconds( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    long doc_key_sum = 0;
+    for ( int r = 0; r < rounds; ++r )
+        doc_key_sum += ReadPlayersByKey<SectionPtr, NodeRef>( doc_game, keys );
+    const double doc_key_ms = Milliseconds( start );
+    if ( tree_key_sum != tree_sum || doc_key_sum != tree_sum )
+        throw TestFailedException( "reading by key gave other players" );
+    std::cout << boost::format( "read players by key: tree %.2f ms (%.1fx), document %.2f ms (%.1fx)\n" )
+                 % tree_key_ms % ( tree_read_ms / std::max( tree_key_ms, 0.001 ) ) % doc_key_ms % ( doc_read_ms / std::max( doc_key_ms, 0.001 ) );
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    double streamed = 0;
+    for ( int r = 0; r < rounds * 100; ++r )
+        for ( size_t i = 0; i < num_numbers; ++i )
+            streamed += Streamed<double>( numbers[i] );
+    const double stream_ms = Milliseconds( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    double parsed = 0;
+    for ( int r = 0; r < rounds * 100; ++r )
+        for ( size_t i = 0; i < num_numbers; ++i )
+        {
+            parsed += LSL::Util::ParseDouble( numbers[i], numbers[i] + strlen( numbers[i] ) );
+        }
+    const double parse_ms = Milliseconds( start );
+    if ( parsed != streamed )
+        throw TestFailedException( "parsed numbers add up differently" );
+    std::cout << boost::format( "numbers: FromString %.2f ms, ParseDouble %.2f ms, %.1fx\n" )
+                 % stream_ms % parse_ms % ( stream_ms / std::max( parse_ms, 0.001 ) );
+
+    CheckReader( script );
+    allocations = allocation_count;
+    start = boost::posix_time::microsec_clock::universal_time();
+    size_t names = 0;
+    for ( int r = 0; r < rounds; ++r )
+    {
+        PlayerNames handler;
+        ReadTDF( script.data(), script.size(), handler );
+        names += handler.names.size();
+    }
+    const double reader_ms = Milliseconds( start );
+    const size_t reader_allocations = ( allocation_count - allocations ) / rounds;
+    if ( names != size_t( players * rounds ) )
+        throw TestFailedException( "reader missed player names" );
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( int r = 0; r < rounds; ++r )
+    {
+        const char* paths[] = { "GAME/MapName", "GAME/GameType" };
+        PathCollector collector( paths, paths + 2 );
+        ReadTDF( script.data(), script.size(), collector );
+    }
+    std::cout << boost::format( "reader: all player names %.2f ms (%d allocations), map and game stopping early %.2f ms\n" )
+                 % reader_ms % reader_allocations % Milliseconds( start );
+
+    CheckWriter( players );
+    allocations = allocation_count;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( int r = 0; r < rounds; ++r )
+    {
+        std::stringstream out;
+        LegacyWriter tdf( out );
+        WriteTeams( tdf, players, true );
+    }
+    const double legacy_write_ms = Milliseconds( start );
+    const size_t legacy_write_allocations = ( allocation_count - allocations ) / rounds;
+    allocations = allocation_count;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for ( int r = 0; r < rounds; ++r )
+    {
+        BufferSink sink( 32 * 1024 );
+        TDFWriter tdf( sink );
+        WriteTeams( tdf, players, false );
+    }
+    const double write_ms = Milliseconds( start );
+    std::cout << boost::format( "write: stringstream %.2f ms (%d allocations), buffer sink %.2f ms (%d allocations), %.1fx\n" )
+                 % legacy_write_ms % legacy_write_allocations % write_ms % ( ( allocation_count - allocations ) / rounds )
+                 % ( legacy_write_ms / std::max( write_ms, 0.001 ) );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/
@@ -0,0 +1,152 @@
+#include <lsl/networking/commands.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/format.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <iostream>
+
+#include "common.h"
+
+namespace {
+
+using namespace LSL;
+
+const std::string battleopened_params( "4711 0 0 SomeHost 192.168.0.17 8452 16 1 0 -1234567 DeltaSiegeDry\tTeam game 4711\tBalanced Annihilation V7.72" );
+
+std::string ClientsParams()
+{
+    std::string params( "main" );
+    for ( int i = 0; i < 200; ++i )
+        params += ( boost::format( " Player%d" ) % i ).str();
+    return params;
+}
+
+long OldBattleOpened( const std::string& line )
+{
+    std::string params = line;
+    long sum = GetIntParam( params ) + GetIntParam( params ) + GetIntParam( params );
+    sum += GetWordParam( params ).size() + GetWordParam( params ).size();
+    sum += GetIntParam( params ) + GetIntParam( params ) + GetIntParam( params ) + GetIntParam( params );
+    sum += GetWordParam( params ).size();
+    sum += GetSentenceParam( params ).size() + GetSentenceParam( params ).size() + GetSentenceParam( params ).size();
+    return sum;
+}
+
+long NewBattleOpened( const std::string& line )
+{
+    ParamCursor params( line );
+    long sum = Tokens::Int( params )() + Tokens::Int( params )() + Tokens::Int( params )();
+    sum += Tokens::Word( params )().size() + Tokens::Word( params )().size();
+    sum += Tokens::Int( params )() + Tokens::Int( params )() + Tokens::Int( params )() + Tokens::Int( params )();
+    sum += Tokens::Word( params )().size();
+    sum += Tokens::Sentence( params )().size() + Tokens::Sentence( params )().size() + Tokens::Sentence( params )().size();
+    return sum;
+}
+
+//! CLIENTS is a Word plus All, the handler then splits the nick list
+long OldClients( const std::string& line )
+{
+    std::string params = line;
+    long sum = GetWordParam( params ).size();
+    std::string users = params;
+    while ( !users.empty() )
+        sum += GetWordParam( users ).size();
+    return sum;
+}
+
+long NewClients( const std::string& line )
+{
+    ParamCursor params( line );
+    long sum = params.Next( ' ' ).size();
+    ParamCursor users( params.Rest() );
+    while ( !users.empty() )
+        sum += users.Next( ' ' ).size();
+    return sum;
+}
+
+//! stands in for ServerImpl to check wide commands arrive complete and in order
+struct BattleSink
+{
+    BattleSink() : calls( 0 ) {}
+    void OnBattleOpened( int id, int type, int nat, const std::string& nick, const std::string& host, int port,
+                         int maxplayers, bool haspass, int rank, const std::string& maphash, const std::string& map,
+                         const std::string& title, const std::string& mod )
+    {
+        if ( id != 4711 || type != 0 || nat != 0 || nick != "SomeHost" || host != "192.168.0.17" || port != 8452
+             || maxplayers != 16 || !haspass || rank != 0 || maphash != "-1234567" || map != "DeltaSiegeDry"
+             || title != "Team game 4711" || mod != "Balanced Annihilation V7.72" )
+            throw TestFailedException( "BATTLEOPENED parsed wrong" );
+        ++calls;
+    }
+    int calls;
+};
+
+double Bench( long (*parse)( const std::string& ), const std::string& line, int rounds, long& checksum )
+{
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for ( int i = 0; i < rounds; ++i )
+        checksum += parse( line );
+    return ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() * 1000.0 / rounds;
+}
+
+void Compare( const char* name, long (*old_parse)( const std::string& ), long (*new_parse)( const std::string& ),
+              const std::string& line, int rounds )
+{
+    long old_sum = 0, new_sum = 0;
+    const double old_ns = Bench( old_parse, line, rounds, old_sum );
+    const double new_ns = Bench( new_parse, line, rounds, new_sum );
+    if ( old_sum != new_sum )
+        throw TestFailedException( std::string( "old and new tokenizer disagree on " ) + name );
+    std::cout << boost::format( "%-13s substr/stringstream %8.1f ns/line, cursor %8.1f ns/line (%.1fx)\n" )
+                 % name % old_ns % new_ns % ( old_ns / std::max( new_ns, 0.001 ) );
+}
+
+} // namespace
+
+int main( int, char** )
+{
+    if ( Util::ParseDouble( "-12.5e1", "-12.5e1" + 7 ) != -125.0 || Util::ParseLong( "-42", "-42" + 3 ) != -42 )
+        throw TestFailedException( "number parsing broken" );
+    Compare( "BATTLEOPENED", OldBattleOpened, NewBattleOpened, battleopened_params, 200000 );
+
+    using namespace LSL::Tokens;
+    BattleSink sink;
+    Command< BOOST_TYPEOF( &BattleSink::OnBattleOpened ), Int, Int, Int, Word, Word, Int, Int, Int, Int, Word, Sentence, Sentence, Sentence >
+        battleopened( &BattleSink::OnBattleOpened, &sink );
+    const int rounds = 200000;
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for ( int i = 0; i < rounds; ++i )
+        battleopened.process( battleopened_params );
+    std::cout << boost::format( "BATTLEOPENED  full Command dispatch %.1f ns/line\n" )
+                 % ( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() * 1000.0 / rounds );
+    if ( sink.calls != rounds )
+        throw TestFailedException( "BATTLEOPENED handler not called" );
+
+    Compare( "CLIENTS", OldClients, NewClients, ClientsParams(), 20000 );
+    return 0;
+}
+
+/**
+Copyright 2012 by The libSpringLobby team. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are
+permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this list of
+      conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright notice, this list
+      of conditions and the following disclaimer in the documentation and/or other materials
+      provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**/